@@ -0,0 +1,120 @@
+// I2C interface by default
+//
+// Six-position accelerometer calibration saved to EEPROM. On boot a stored
+// calibration is loaded if there is a valid one; send 'c' over serial to
+// run the calibration again. The offsets are pushed into the chip's
+// reference registers so correcting them costs no CPU time per sample.
+#include <EEPROM.h>
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CAccelCalibrator.h"
+#include "LSM303CTypes.h"
+
+#define EEPROM_ADDRESS 0
+#define SAMPLES        64
+#define ONE_G_2G       16384 // 1 g in counts at 2 g full scale
+
+LSM303C myIMU;
+
+static const char* const POSITIONS[ACC_CAL_POSITIONS] =
+{
+  "X axis up", "X axis down", "Y axis up", "Y axis down",
+  "Z axis up (flat)", "Z axis down (upside down)"
+};
+
+void waitForKey()
+{
+  while (Serial.available())
+  {
+    Serial.read();
+  }
+  while (!Serial.available());
+  Serial.read();
+}
+
+void calibrate()
+{
+  LSM303CAccelCalibrator calibrator;
+  AccelCalibration_t cal;
+
+  myIMU.clearAccelCalibration();
+  for (uint8_t p = 0; p < ACC_CAL_POSITIONS; p++)
+  {
+    Serial.print("Hold the board still with the ");
+    Serial.print(POSITIONS[p]);
+    Serial.println(" and send any key");
+    waitForKey();
+
+    // Fresh conversions only, so this keeps pace with whatever output data
+    // rate begin() set rather than assuming one
+    uint8_t taken = 0;
+    while (taken < SAMPLES)
+    {
+      AxesSample_t sample;
+      if (myIMU.readAccelSample(sample) == IMU_SUCCESS &&
+          !(sample.flags & SAMPLE_STALE))
+      {
+        calibrator.add((ACC_CAL_POSITION_t)p, sample.axes);
+        taken++;
+      }
+    }
+  }
+
+  if (!calibrator.solve(ACC_FS_2g, ONE_G_2G, cal))
+  {
+    Serial.println("Calibration failed, check the orientations.");
+    return;
+  }
+
+  EEPROM.put(EEPROM_ADDRESS, cal);
+  myIMU.setAccelCalibration(cal, true);
+  Serial.println("Calibration saved.");
+}
+
+void setup() {
+
+  Wire.begin();//set up I2C bus, comment out if using SPI mode
+  Wire.setClock(400000L);//clock stretching, comment out if using SPI mode
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+
+  AccelCalibration_t cal;
+  EEPROM.get(EEPROM_ADDRESS, cal);
+  if (myIMU.setAccelCalibration(cal, true) == IMU_SUCCESS)
+  {
+    Serial.println("Loaded calibration from EEPROM.");
+  }
+  else
+  {
+    calibrate();
+  }
+}
+
+void loop()
+{
+  AxesRaw_t mg;
+
+  if (Serial.available() && Serial.read() == 'c')
+  {
+    calibrate();
+  }
+
+  if (myIMU.readAccelMilliG(mg) == IMU_SUCCESS)
+  {
+    Serial.print("Accel (mg): ");
+    Serial.print(mg.xAxis);
+    Serial.print(", ");
+    Serial.print(mg.yAxis);
+    Serial.print(", ");
+    Serial.println(mg.zAxis);
+  }
+
+  delay(500);//slow down output to make it easier to read, adjust as necessary
+}
@@ -0,0 +1,81 @@
+// SPI interface on the SPI peripheral
+//
+// Runs two breakouts as one array. Both share MOSI/MISO/SCK and each has its
+// own chip selects and INT_XL line, so the array only talks to a sensor when
+// it has fresh data. Prints one synchronized frame per accelerometer sample
+// pair, each with its own timestamp.
+//
+//  MOSI -> 1k resistor -> SDI/SDO (both)
+//  MISO ------------------> SDI/SDO (both)
+//  SCK  -> SCLK (both)
+//  D8 -> CS_MAG 1,  D9 -> CS_XL 1,  D2 -> INT_XL 1
+//  D6 -> CS_MAG 2,  D7 -> CS_XL 2,  D3 -> INT_XL 2
+#include "SPI.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CHardwareSPIBus.h"
+#include "LSM303CArray.h"
+#include "LSM303CTypes.h"
+
+#define SENSORS 2
+
+LSM303CHardwareSPIBus bus1(8, 9);
+LSM303CHardwareSPIBus bus2(6, 7);
+LSM303C imu1(bus1);
+LSM303C imu2(bus2);
+LSM303CArrayOf<SENSORS> sensors;
+LSM303CArraySlot_t frame[SENSORS];
+
+void imu1ISR() { imu1.accelDataReadyISR(); }
+void imu2ISR() { imu2.accelDataReadyISR(); }
+
+void setup() {
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (imu1.begin() != IMU_SUCCESS || imu2.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+
+  sensors.add(imu1);
+  sensors.add(imu2);
+
+  pinMode(2, INPUT);
+  pinMode(3, INPUT);
+  attachInterrupt(digitalPinToInterrupt(2), imu1ISR, RISING);
+  attachInterrupt(digitalPinToInterrupt(3), imu2ISR, RISING);
+  sensors.setSchedule(ARRAY_DATA_READY);
+}
+
+void loop()
+{
+  if (sensors.poll() != IMU_SUCCESS)
+  {
+    Serial.println("Read error");
+  }
+
+  if (sensors.readFrame(frame))
+  {
+    for (uint8_t i = 0; i < SENSORS; i++)
+    {
+      // A sensor that stopped answering is left out instead of holding up
+      // the frame, and retried every so often
+      if (!(frame[i].fresh & LSM303C_FRESH_ACCEL))
+      {
+        Serial.print(sensors.online(i) ? "late" : "offline");
+        Serial.print(i + 1 < SENSORS ? " | " : "\n");
+        continue;
+      }
+      Serial.print(frame[i].accel.timestamp);
+      Serial.print(": ");
+      Serial.print(frame[i].accel.axes.xAxis);
+      Serial.print(", ");
+      Serial.print(frame[i].accel.axes.yAxis);
+      Serial.print(", ");
+      Serial.print(frame[i].accel.axes.zAxis);
+      Serial.print(i + 1 < SENSORS ? " | " : "\n");
+    }
+  }
+}
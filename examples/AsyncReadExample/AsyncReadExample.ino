@@ -0,0 +1,86 @@
+// I2C interface by default
+//
+// Runs a fixed 1 kHz loop and spreads each sample read over several ticks,
+// one bus phase per tick, instead of stalling a tick for the whole transfer.
+// The worst tick time is printed alongside the latest sample.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+
+#define TICK_US 1000
+
+LSM303C myIMU;
+unsigned long nextTick;
+unsigned long worstTick = 0;
+
+void onSample(const AxesRaw_t& accel, const AxesRaw_t& mag)
+{
+  static uint8_t count = 0;
+
+  // Keep printing out of the way of the control loop most of the time
+  if (++count < 100)
+  {
+    return;
+  }
+  count = 0;
+
+  Serial.print("Accel raw: ");
+  Serial.print(accel.xAxis);
+  Serial.print(", ");
+  Serial.print(accel.yAxis);
+  Serial.print(", ");
+  Serial.print(accel.zAxis);
+  Serial.print("  Mag raw: ");
+  Serial.print(mag.xAxis);
+  Serial.print(", ");
+  Serial.print(mag.yAxis);
+  Serial.print(", ");
+  Serial.print(mag.zAxis);
+  Serial.print("  worst tick: ");
+  Serial.print(worstTick);
+  Serial.println(" us");
+  worstTick = 0;
+}
+
+void setup() {
+
+  Wire.begin();//set up I2C bus, comment out if using SPI mode
+  Wire.setClock(400000L);//clock stretching, comment out if using SPI mode
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+
+  myIMU.onSampleReady(onSample);
+  nextTick = micros();
+}
+
+void loop()
+{
+  while ((long)(micros() - nextTick) < 0);
+  unsigned long start = micros();
+  nextTick += TICK_US;
+
+  // Start the next read as soon as the last one finished
+  if (!myIMU.sampleBusy())
+  {
+    myIMU.startSampleRead();
+  }
+  if (myIMU.pollSampleRead() != IMU_SUCCESS)
+  {
+    Serial.println("Read error");
+  }
+
+  // ... the rest of the control loop runs here ...
+
+  unsigned long spent = micros() - start;
+  if (spent > worstTick)
+  {
+    worstTick = spent;
+  }
+}
@@ -0,0 +1,141 @@
+// SPI interface, AVR only
+//
+// Times the templated bit-bang SPI transport against the counted-loop
+// version it replaced and prints CPU clocks per byte on the wire. A second
+// sensor on its own pins shows that each instantiation is independent.
+//
+// Sensor 1 (Pro Mini default pins)   Sensor 2
+//  D10 -> SDI/SDO                     D4 -> SDI/SDO
+//  D11 -> SCLK                        D5 -> SCLK
+//  D12 -> CS_XL                       D6 -> CS_XL
+//  D13 -> CS_MAG                      D7 -> CS_MAG
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+
+#if !LSM303C_HAS_BITBANG_SPI
+#error "Bit-banged SPI needs an AVR board"
+#endif
+
+#define TRANSFERS 1000
+#define BURST     6
+
+// The way bytes used to be clocked: variable shift and a loop per bit
+class LoopSPIBus : public LSM303CBus
+{
+  public:
+    InterfaceMode_t mode(void) const { return MODE_SPI; }
+
+    status_t readRegs(CHIP_t, uint8_t reg, uint8_t* data, uint8_t len)
+    {
+      uint8_t counter;
+      uint8_t value;
+
+      reg |= _BV(7);
+      bitSet(DDRB, 2);
+      noInterrupts();
+      bitClear(PORTB, 4);
+      bitSet(PORTB, 5);
+      for (counter = 8; counter; counter--)
+      {
+        bitWrite(PORTB, 2, reg & 0x80);
+        bitClear(PORTB, 3);
+        bitSet(PORTB, 3);
+        reg <<= 1;
+      }
+      bitClear(DDRB, 2);
+      for (; len; len--)
+      {
+        value = 0;
+        for (counter = 8; counter; counter--)
+        {
+          value <<= 1;
+          bitClear(PORTB, 3);
+          bitSet(PORTB, 3);
+          if (bitRead(PINB, 2))
+          {
+            value |= 0x01;
+          }
+        }
+        *data++ = value;
+      }
+      bitSet(PORTB, 4);
+      interrupts();
+      return IMU_SUCCESS;
+    }
+
+    status_t writeRegs(CHIP_t, uint8_t, const uint8_t*, uint8_t)
+    {
+      return IMU_NOT_SUPPORTED;
+    }
+};
+
+LSM303C_AVR_PIN(SecondCSMag, D, 7);
+LSM303C_AVR_PIN(SecondCSXL,  D, 6);
+LSM303C_AVR_PIN(SecondCLK,   D, 5);
+LSM303C_AVR_PIN(SecondData,  D, 4);
+
+LSM303CBitBangSPIBus fastBus;
+LoopSPIBus loopBus;
+LSM303CBitBangSPI<SecondCSMag, SecondCSXL, SecondCLK, SecondData> secondBus;
+
+LSM303C myIMU(fastBus);
+LSM303C secondIMU(secondBus);
+
+// CPU clocks per byte on the wire, address byte included
+float clocksPerByte(LSM303CBus& bus)
+{
+  uint8_t data[BURST];
+  unsigned long start = micros();
+  for (uint16_t i = 0; i < TRANSFERS; i++)
+  {
+    bus.readRegs(ACC, ACC_OUT_X_L, data, BURST);
+  }
+  unsigned long elapsed = micros() - start;
+  return (float)elapsed * (F_CPU / 1000000L) / ((float)TRANSFERS * (BURST + 1));
+}
+
+void setup() {
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+  if (secondIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Second sensor failed setup.");
+  }
+
+  Serial.print("Counted loop     : ");
+  Serial.print(clocksPerByte(loopBus), 1);
+  Serial.println(" clocks/byte");
+  Serial.print("Templated engine : ");
+  Serial.print(clocksPerByte(fastBus), 1);
+  Serial.println(" clocks/byte");
+}
+
+void loop()
+{
+  float x, y, z;
+
+  myIMU.readAccelXYZ(x, y, z);
+  Serial.print("Sensor 1 accel: ");
+  Serial.print(x, 1);
+  Serial.print(", ");
+  Serial.print(y, 1);
+  Serial.print(", ");
+  Serial.println(z, 1);
+
+  secondIMU.readAccelXYZ(x, y, z);
+  Serial.print("Sensor 2 accel: ");
+  Serial.print(x, 1);
+  Serial.print(", ");
+  Serial.print(y, 1);
+  Serial.print(", ");
+  Serial.println(z, 1);
+
+  delay(1000);//slow down output to make it easier to read, adjust as necessary
+}
@@ -0,0 +1,135 @@
+// I2C interface by default
+//
+// Compares fetching one accelerometer + magnetometer sample a register at a
+// time against the auto-increment burst reads the library now uses.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+
+#define SAMPLES 500
+
+// Counts what actually goes out on the wire, underneath the driver, so both
+// read paths are measured the same way
+class CountingI2CBus : public LSM303CI2CBus
+{
+  public:
+    uint32_t transactions = 0;
+    uint32_t bytes = 0;
+
+    status_t readRegs(CHIP_t chip, uint8_t reg, uint8_t* data, uint8_t len)
+    {
+      transactions++;
+      bytes += len;
+      return LSM303CI2CBus::readRegs(chip, reg, data, len);
+    }
+
+    status_t writeRegs(CHIP_t chip, uint8_t reg, const uint8_t* data,
+        uint8_t len)
+    {
+      transactions++;
+      bytes += len;
+      return LSM303CI2CBus::writeRegs(chip, reg, data, len);
+    }
+
+    void reset() { transactions = bytes = 0; }
+};
+
+// Expose the protected register access so the old path can be rebuilt
+class BenchIMU : public LSM303C
+{
+  public:
+    explicit BenchIMU(LSM303CBus& bus) : LSM303C(bus) { }
+
+    // The way samples used to be fetched: one register per read
+    status_t readPerRegister(AxesRaw_t& acc, AxesRaw_t& mag)
+    {
+      uint8_t raw[6];
+      for (uint8_t i = 0; i < 6; i++)
+      {
+        if (ACC_ReadReg((ACC_REG_t)(ACC_OUT_X_L + i), raw[i]))
+        {
+          return IMU_HW_ERROR;
+        }
+      }
+      acc.xAxis = (int16_t)((raw[1] << 8) | raw[0]);
+      acc.yAxis = (int16_t)((raw[3] << 8) | raw[2]);
+      acc.zAxis = (int16_t)((raw[5] << 8) | raw[4]);
+
+      for (uint8_t i = 0; i < 6; i++)
+      {
+        if (MAG_ReadReg((MAG_REG_t)(MAG_OUTX_L + i), raw[i]))
+        {
+          return IMU_HW_ERROR;
+        }
+      }
+      mag.xAxis = (int16_t)((raw[1] << 8) | raw[0]);
+      mag.yAxis = (int16_t)((raw[3] << 8) | raw[2]);
+      mag.zAxis = (int16_t)((raw[5] << 8) | raw[4]);
+      return IMU_SUCCESS;
+    }
+
+    // What the library does now
+    status_t readBurst(AxesRaw_t& acc, AxesRaw_t& mag)
+    {
+      if (ACC_GetAccRaw(acc))
+      {
+        return IMU_HW_ERROR;
+      }
+      return MAG_GetMagRaw(mag);
+    }
+};
+
+CountingI2CBus bus;
+BenchIMU myIMU(bus);
+
+void report(const char* label, unsigned long elapsed)
+{
+  Serial.print(label);
+  Serial.print(": ");
+  Serial.print((float)elapsed / SAMPLES, 1);
+  Serial.print(" us/sample, ");
+  Serial.print((float)bus.transactions / SAMPLES, 1);
+  Serial.print(" transactions/sample, ");
+  Serial.print((float)bus.bytes / SAMPLES, 1);
+  Serial.println(" bytes/sample");
+}
+
+void setup() {
+
+  Wire.begin();//set up I2C bus
+  Wire.setClock(400000L);//clock stretching
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+}
+
+void loop()
+{
+  AxesRaw_t acc, mag;
+  unsigned long start;
+
+  bus.reset();
+  start = micros();
+  for (uint16_t i = 0; i < SAMPLES; i++)
+  {
+    myIMU.readPerRegister(acc, mag);
+  }
+  report("Per-register", micros() - start);
+
+  bus.reset();
+  start = micros();
+  for (uint16_t i = 0; i < SAMPLES; i++)
+  {
+    myIMU.readBurst(acc, mag);
+  }
+  report("Burst       ", micros() - start);
+
+  Serial.println();
+  delay(5000);
+}
@@ -0,0 +1,87 @@
+// No sensor needed
+//
+// Samples the emulated sensor at 100 Hz, hangs the bus halfway through as
+// if a glitch left the sensor holding SDA (and browned it out), and shows
+// what the loop sees: one read that comes back IMU_TIMEOUT after the bus
+// deadline, an automatic recovery that rewrites the configuration, and
+// samples flowing again on the next call.
+//
+// On real hardware the same happens through LSM303CI2CBus: setTimeout()
+// sets the deadline, setRecoveryPins() the pins to clock SCL on and
+// setRecoveryClock() the clock Wire gets back afterwards.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+#include "LSM303CEmulator.h"
+
+#define SAMPLES 20
+#define HANG_AT 10
+#define SAMPLE_PERIOD_US 10000 // 100 Hz
+
+LSM303CEmulator emu(MODE_I2C, 400000L);
+LSM303C myIMU(emu);
+
+void setup() {
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+}
+
+void loop()
+{
+  uint32_t worst = 0;
+  AxesSample_t sample;
+
+  for (uint8_t i = 0; i < SAMPLES; i++)
+  {
+    if (i == HANG_AT)
+    {
+      emu.hangBus(true);
+    }
+
+    emu.elapse(SAMPLE_PERIOD_US);
+    uint32_t start = emu.now();
+    status_t result = myIMU.readAccelSample(sample);
+    uint32_t cost = emu.now() - start;
+    if (cost > worst)
+    {
+      worst = cost;
+    }
+
+    Serial.print(i);
+    Serial.print(": ");
+    if (result == IMU_SUCCESS)
+    {
+      Serial.print("z = ");
+      Serial.print(sample.axes.zAxis);
+    }
+    else if (result == IMU_TIMEOUT)
+    {
+      Serial.print("timeout");
+    }
+    else
+    {
+      Serial.print("error ");
+      Serial.print(result);
+    }
+    Serial.print(", ");
+    Serial.print(cost);
+    Serial.println(" us");
+  }
+
+  Serial.print("Recoveries: ");
+  Serial.println(myIMU.busRecoveries());
+  Serial.print("Slowest read: ");
+  Serial.print(worst);
+  Serial.println(" us");
+  Serial.print("Configuration after recovery: ");
+  Serial.println(myIMU.verifyRegisters() == IMU_SUCCESS ? "intact" : "lost");
+
+  while (1);
+}
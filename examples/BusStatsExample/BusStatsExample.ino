@@ -0,0 +1,61 @@
+// I2C interface by default
+//
+// Polls both sensors as fast as it can and every five seconds prints where
+// the bus time went: transfers, bytes, errors, the slowest transfer and a
+// latency histogram per die and direction, then the I2C failure causes.
+// Instrumentation is compiled out by default. Build with the compiler flag
+// -DLSM303C_INSTRUMENTATION=1 to use this, e.g. arduino-cli compile
+// --build-property compiler.cpp.extra_flags=-DLSM303C_INSTRUMENTATION=1
+// or build_flags = -DLSM303C_INSTRUMENTATION=1 in platformio.ini.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+
+#define REPORT_INTERVAL_MS 5000
+
+LSM303C myIMU;
+LSM303CBusStats busStats;
+bool instrumented = false;
+
+void setup() {
+
+  Wire.begin();//set up I2C bus, comment out if using SPI mode
+  Wire.setClock(400000L);//clock stretching, comment out if using SPI mode
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  // Attached first so begin()'s own transfers count too
+  instrumented = myIMU.setBusStats(&busStats) == IMU_SUCCESS;
+  if (!instrumented)
+  {
+    Serial.println("Build with -DLSM303C_INSTRUMENTATION=1 to count transfers");
+  }
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+  }
+}
+
+void loop()
+{
+  static uint32_t last = millis();
+  AxesSample_t accel;
+  AxesSample_t mag;
+
+  // Errors show up in the report
+  myIMU.readAccelSample(accel);
+  myIMU.readMagSample(mag);
+
+  if (!instrumented || millis() - last < REPORT_INTERVAL_MS)
+  {
+    return;
+  }
+  last = millis();
+
+  Serial.println("die dir transfers bytes errors max_us | <32 <64 <128 <256 <512 <1k <2k more (us)");
+  busStats.report(Serial);
+  Serial.println();
+  busStats.reset();
+}
@@ -0,0 +1,104 @@
+// No sensor needed
+//
+// Times the integer CORDIC eCompass against the same tilt compensation done
+// with float atan2/sqrt/sin/cos (Freescale AN4248) on a fixed set of
+// accelerometer + magnetometer samples, and prints CPU clocks per update for
+// both and the largest heading difference between them.
+#include <math.h>
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CCompass.h"
+#include "LSM303CTypes.h"
+
+#define ROUNDS 125
+
+// Tilted a little every way and facing round the compass, 2 g and 16 gauss
+// full scale counts
+const AxesRaw_t accelSamples[8] =
+{
+  {0, 0, 16384}, {2840, 0, 16135}, {0, -4240, 15826}, {-5600, 2840, 15140},
+  {1420, 8190, 13950}, {-8190, -1420, 13950}, {11585, 0, 11585}, {-700, 11000, -12100}
+};
+const AxesRaw_t magSamples[8] =
+{
+  {2000, 0, 1500}, {0, -2000, 1500}, {-1410, 1410, 1500}, {1730, 1000, 1480},
+  {-600, -1900, 1520}, {900, 1780, 1460}, {-1990, -200, 1500}, {1200, -1600, -1450}
+};
+const uint8_t VECTORS = sizeof(accelSamples) / sizeof(accelSamples[0]);
+
+// Results go through volatiles so the compiler can't drop the work
+volatile float    floatSink;
+volatile uint16_t intSink;
+
+// Reference: AN4248 tilt compensation in float
+float floatHeading(const AxesRaw_t& g, const AxesRaw_t& b)
+{
+  float roll = atan2(g.yAxis, g.zAxis);
+  float sr = sin(roll), cr = cos(roll);
+  float pitch = atan2(-g.xAxis, g.yAxis * sr + g.zAxis * cr);
+  float sp = sin(pitch), cp = cos(pitch);
+  float bfy = b.zAxis * sr - b.yAxis * cr;
+  float bfx = b.xAxis * cp + (b.yAxis * sr + b.zAxis * cr) * sp;
+  return atan2(bfy, bfx);
+}
+
+float clocksPerUpdate(unsigned long elapsed)
+{
+  return (float)elapsed * (F_CPU / 1000000L) / (ROUNDS * VECTORS);
+}
+
+void setup() {
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  Attitude_t attitude;
+  float worst = 0;
+
+  unsigned long start = micros();
+  for (uint8_t round = 0; round < ROUNDS; round++)
+  {
+    for (uint8_t i = 0; i < VECTORS; i++)
+    {
+      LSM303CCompass::update(accelSamples[i], magSamples[i], attitude);
+      intSink = attitude.heading;
+    }
+  }
+  unsigned long cordicTime = micros() - start;
+
+  start = micros();
+  for (uint8_t round = 0; round < ROUNDS; round++)
+  {
+    for (uint8_t i = 0; i < VECTORS; i++)
+    {
+      floatSink = floatHeading(accelSamples[i], magSamples[i]);
+    }
+  }
+  unsigned long floatTime = micros() - start;
+
+  for (uint8_t i = 0; i < VECTORS; i++)
+  {
+    LSM303CCompass::update(accelSamples[i], magSamples[i], attitude);
+    float diff = LSM303CCompass::headingCentiDegrees(attitude.heading) / 100.0 -
+      floatHeading(accelSamples[i], magSamples[i]) * 180 / PI;
+    diff = fabs(fmod(diff + 540, 360) - 180);
+    if (diff > worst)
+    {
+      worst = diff;
+    }
+  }
+
+  Serial.print("CORDIC : ");
+  Serial.print(clocksPerUpdate(cordicTime), 1);
+  Serial.println(" clocks/update");
+  Serial.print("Float  : ");
+  Serial.print(clocksPerUpdate(floatTime), 1);
+  Serial.println(" clocks/update");
+  Serial.print("Largest heading difference: ");
+  Serial.print(worst, 3);
+  Serial.println(" degrees");
+}
+
+void loop()
+{
+}
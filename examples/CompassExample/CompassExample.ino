@@ -0,0 +1,53 @@
+// I2C interface by default
+//
+// Prints tilt-compensated heading, pitch and roll from the integer CORDIC
+// eCompass. CompassBenchmark times it against float trig.
+//
+// The compass expects x forward, y right, z down. Remap the axes below if
+// the breakout is mounted differently, and remove mag offsets first for an
+// accurate heading.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CCompass.h"
+#include "LSM303CTypes.h"
+
+LSM303C myIMU;
+
+void setup() {
+
+  Wire.begin();//set up I2C bus, comment out if using SPI mode
+  Wire.setClock(400000L);//clock stretching, comment out if using SPI mode
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+}
+
+void loop()
+{
+  AxesRaw_t accel, mag;
+  Attitude_t attitude;
+
+  if (myIMU.readAccelRaw(accel) != IMU_SUCCESS ||
+      myIMU.readMagRaw(mag) != IMU_SUCCESS)
+  {
+    Serial.println("Read error");
+    return;
+  }
+
+  LSM303CCompass::update(accel, mag, attitude);
+
+  Serial.print("Heading: ");
+  Serial.print(LSM303CCompass::headingCentiDegrees(attitude.heading) / 100.0, 2);
+  Serial.print("  Pitch: ");
+  Serial.print(LSM303CCompass::toCentiDegrees(attitude.pitch) / 100.0, 2);
+  Serial.print("  Roll: ");
+  Serial.println(LSM303CCompass::toCentiDegrees(attitude.roll) / 100.0, 2);
+
+  delay(200);//slow down output to make it easier to read, adjust as necessary
+}
@@ -0,0 +1,142 @@
+// No sensor needed
+//
+// Runs every public read path against the register-level emulator and
+// reports bus transactions, bytes and simulated 400 kHz I2C time per
+// delivered sample. Rerun after driver changes to catch throughput
+// regressions.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+#include "LSM303CEmulator.h"
+
+#define ROUNDS 200
+#define ACC_PERIOD_US 1250  // 800 Hz
+#define MAG_PERIOD_US 12500 // 80 Hz
+
+LSM303CEmulator emu(MODE_I2C, 400000L);
+LSM303C myIMU(emu);
+LSM303CSampleBuffer<8> accelQueue;
+
+// Each path delivers whatever it can per call and returns the sample count
+uint16_t accelPerAxis()
+{
+  myIMU.readAccelX();
+  myIMU.readAccelY();
+  myIMU.readAccelZ();
+  return 1;
+}
+
+uint16_t accelXYZ()
+{
+  float x, y, z;
+  return myIMU.readAccelXYZ(x, y, z) == IMU_SUCCESS;
+}
+
+uint16_t accelRaw()
+{
+  AxesRaw_t axes;
+  return myIMU.readAccelRaw(axes) == IMU_SUCCESS;
+}
+
+uint16_t magPerAxis()
+{
+  myIMU.readMagX();
+  myIMU.readMagY();
+  myIMU.readMagZ();
+  return 1;
+}
+
+uint16_t magXYZ()
+{
+  float x, y, z;
+  return myIMU.readMagXYZ(x, y, z) == IMU_SUCCESS;
+}
+
+uint16_t temperature()
+{
+  return !isnan(myIMU.readTempC());
+}
+
+uint16_t accelFifo()
+{
+  AxesRaw_t samples[ACC_FIFO_DEPTH];
+  return myIMU.readAccelFifo(samples, ACC_FIFO_DEPTH);
+}
+
+uint16_t accelInterrupt()
+{
+  AxesSample_t sample;
+  uint16_t count = 0;
+
+  // The emulator's INT_XL level stands in for the pin interrupt
+  if (emu.intXL())
+  {
+    myIMU.accelDataReadyISR();
+  }
+  myIMU.serviceInterrupts();
+  while (accelQueue.pop(sample))
+  {
+    count++;
+  }
+  return count;
+}
+
+void run(const char* label, uint16_t (*path)(void), uint32_t interval)
+{
+  uint32_t delivered = 0;
+
+  emu.resetCounters();
+  for (uint16_t i = 0; i < ROUNDS; i++)
+  {
+    emu.elapse(interval);
+    delivered += path();
+  }
+
+  Serial.print(label);
+  Serial.print(": ");
+  Serial.print((float)emu.transactions() / delivered, 2);
+  Serial.print(" transactions, ");
+  Serial.print((float)emu.bytes() / delivered, 1);
+  Serial.print(" bytes, ");
+  Serial.print((float)emu.busTimeMicros() / delivered, 1);
+  Serial.println(" us per sample");
+}
+
+void setup() {
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin(MODE_I2C, MAG_DO_80_Hz, MAG_FS_16_Ga, MAG_BDU_ENABLE,
+        MAG_OMXY_HIGH_PERFORMANCE, MAG_OMZ_HIGH_PERFORMANCE, MAG_MD_CONTINUOUS,
+        ACC_FS_2g, ACC_BDU_ENABLE, ACC_X_ENABLE | ACC_Y_ENABLE | ACC_Z_ENABLE,
+        ACC_ODR_800_Hz) != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+  Serial.print("begin(): ");
+  Serial.print(emu.transactions());
+  Serial.println(" transactions");
+}
+
+void loop()
+{
+  run("readAccelX/Y/Z  ", accelPerAxis, ACC_PERIOD_US);
+  run("readAccelXYZ    ", accelXYZ, ACC_PERIOD_US);
+  run("readAccelRaw    ", accelRaw, ACC_PERIOD_US);
+  run("readMagX/Y/Z    ", magPerAxis, MAG_PERIOD_US);
+  run("readMagXYZ      ", magXYZ, MAG_PERIOD_US);
+  run("readTempC       ", temperature, MAG_PERIOD_US);
+
+  myIMU.enableAccelFifo(ACC_FIFO_STREAM, 24);
+  run("readAccelFifo   ", accelFifo, 25 * ACC_PERIOD_US);
+  myIMU.enableAccelFifo(ACC_FIFO_BYPASS, 0);
+
+  myIMU.enableAccelDataReadyInterrupt(&accelQueue);
+  run("serviceInterrupts", accelInterrupt, ACC_PERIOD_US);
+  myIMU.enableAccelDataReadyInterrupt(NULL);
+
+  Serial.println();
+  delay(10000);
+}
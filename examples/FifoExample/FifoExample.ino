@@ -0,0 +1,65 @@
+// I2C interface by default
+//
+// Runs the accelerometer at 800 Hz with its FIFO in stream mode and drains
+// the queued samples in bursts, so the sketch only touches the bus once the
+// watermark is reached.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+
+#define WATERMARK 24
+
+LSM303C myIMU;
+AxesRaw_t samples[ACC_FIFO_DEPTH];
+
+void setup() {
+
+  Wire.begin();//set up I2C bus, comment out if using SPI mode
+  Wire.setClock(400000L);//clock stretching, comment out if using SPI mode
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin(MODE_I2C, MAG_DO_40_Hz, MAG_FS_16_Ga, MAG_BDU_ENABLE,
+        MAG_OMXY_HIGH_PERFORMANCE, MAG_OMZ_HIGH_PERFORMANCE, MAG_MD_CONTINUOUS,
+        ACC_FS_2g, ACC_BDU_ENABLE, ACC_X_ENABLE | ACC_Y_ENABLE | ACC_Z_ENABLE,
+        ACC_ODR_800_Hz) != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+
+  ///// FIFO mode options
+  //ACC_FIFO_BYPASS
+  //ACC_FIFO_FIFO
+  //ACC_FIFO_STREAM_TO_FIFO
+  if (myIMU.enableAccelFifo(ACC_FIFO_STREAM, WATERMARK) != IMU_SUCCESS)
+  {
+    Serial.println("Failed to enable FIFO.");
+    while (1);
+  }
+}
+
+void loop()
+{
+  uint8_t level;
+
+  if (myIMU.accelFifoLevel(level) != IMU_SUCCESS || level < WATERMARK)
+  {
+    // Free to do other work (or sleep) while the FIFO fills
+    return;
+  }
+
+  size_t count = myIMU.readAccelFifo(samples, ACC_FIFO_DEPTH);
+  long sumZ = 0;
+
+  for (size_t i = 0; i < count; i++)
+  {
+    sumZ += samples[i].zAxis;
+  }
+
+  Serial.print("Drained ");
+  Serial.print((int)count);
+  Serial.print(" samples, mean Z = ");
+  Serial.println(count ? (float)sumZ / count * SENSITIVITY_ACC : NAN, 4);
+}
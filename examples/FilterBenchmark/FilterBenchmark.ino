@@ -0,0 +1,116 @@
+// No sensor needed
+//
+// Times each fixed-point filter stage and the whole median + CIC + biquad
+// pipeline on a noisy simulated signal and prints CPU clocks per input
+// sample, next to the same biquad in float. On the host build run it with
+// --real-time (make timing), simulated time doesn't move here.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+#include "LSM303CFilter.h"
+
+#define SAMPLES 8000
+
+LSM303CMovingAverage<8>    average;
+LSM303CMedianFilter<3>     despike;
+LSM303CCICDecimator<3, 3>  decimate;
+LSM303CBiquad              lowPass(LSM303CBiquad::lowPass(20, 800));
+LSM303CBiquad              smooth(LSM303CBiquad::lowPass(20, 100));
+LSM303CFilterChainOf<3>    pipeline;
+
+// Results go through volatiles so the compiler can't drop the work
+volatile int16_t intSink;
+volatile float   floatSink;
+
+AxesRaw_t rawSample(uint16_t i)
+{
+  // 1 g on Z, a slow swing on X and a spike every 50 samples
+  int16_t noise = (int16_t)(i * 2654435761UL >> 26) - 32;
+  AxesRaw_t raw = {(int16_t)((i & 0xFF) * 16 - 2048 + noise),
+    noise, (int16_t)(16384 + noise + (i % 50 ? 0 : 4000))};
+  return raw;
+}
+
+float clocksPerSample(unsigned long elapsed)
+{
+  return (float)elapsed * (F_CPU / 1000000L) / SAMPLES;
+}
+
+unsigned long timeStage(LSM303CFilterStage& stage)
+{
+  unsigned long start = micros();
+  for (uint16_t i = 0; i < SAMPLES; i++)
+  {
+    AxesRaw_t raw = rawSample(i);
+    if (stage.process(raw))
+    {
+      intSink = raw.zAxis;
+    }
+  }
+  return micros() - start;
+}
+
+// Same 20 Hz low-pass at 800 Hz as lowPass, in float
+unsigned long timeFloatBiquad(void)
+{
+  float b0 = 0.005543f, b1 = 0.011086f, b2 = 0.005543f;
+  float a1 = -1.778632f, a2 = 0.800803f;
+  float x1[3] = {0}, x2[3] = {0}, y1[3] = {0}, y2[3] = {0};
+
+  unsigned long start = micros();
+  for (uint16_t i = 0; i < SAMPLES; i++)
+  {
+    AxesRaw_t raw = rawSample(i);
+    int16_t in[3] = {raw.xAxis, raw.yAxis, raw.zAxis};
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+      float y = b0 * in[axis] + b1 * x1[axis] + b2 * x2[axis] -
+        a1 * y1[axis] - a2 * y2[axis];
+      x2[axis] = x1[axis];
+      x1[axis] = in[axis];
+      y2[axis] = y1[axis];
+      y1[axis] = y;
+      floatSink = y;
+    }
+  }
+  return micros() - start;
+}
+
+void report(const char* name, unsigned long elapsed)
+{
+  Serial.print(name);
+  Serial.print(clocksPerSample(elapsed), 1);
+  Serial.println(" clocks/sample");
+}
+
+void setup() {
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  pipeline.add(despike);
+  pipeline.add(decimate);
+  pipeline.add(smooth);
+
+  report("Moving average (8)  : ", timeStage(average));
+  report("Median (3)          : ", timeStage(despike));
+  report("CIC (3rd order, /8) : ", timeStage(decimate));
+  report("Biquad, fixed point : ", timeStage(lowPass));
+  report("Biquad, float       : ", timeFloatBiquad());
+
+  pipeline.reset();
+  unsigned long start = micros();
+  for (uint16_t i = 0; i < SAMPLES; i++)
+  {
+    AxesRaw_t raw = rawSample(i);
+    if (pipeline.process(raw))
+    {
+      intSink = raw.zAxis;
+    }
+  }
+  report("Median + CIC + biquad: ", micros() - start);
+}
+
+void loop()
+{
+}
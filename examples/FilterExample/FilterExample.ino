@@ -0,0 +1,100 @@
+// I2C interface by default
+//
+// Samples the accelerometer at 800 Hz through the FIFO and runs every sample
+// through a fixed-point pipeline: a 3-point median to knock out spikes, a
+// CIC decimator down to 100 Hz and a 20 Hz biquad low-pass. Prints the
+// filtered output at 10 Hz along with the CPU time the pipeline costs.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+#include "LSM303CFilter.h"
+
+#define WATERMARK 24
+// Let the chip's high-pass strip gravity first (cutoff ODR/400 = 2 Hz)
+#define USE_CHIP_HIGH_PASS 0
+
+LSM303C myIMU;
+AxesRaw_t samples[ACC_FIFO_DEPTH];
+
+LSM303CMedianFilter<3>       despike;
+LSM303CCICDecimator<3, 3>    decimate; // 3rd order, 800 Hz / 2^3 = 100 Hz
+LSM303CBiquad                smooth(LSM303CBiquad::lowPass(20, 100));
+LSM303CFilterChainOf<3>      pipeline;
+
+unsigned long filterMicros = 0;
+unsigned long filterInputs = 0;
+
+void setup() {
+
+  Wire.begin();//set up I2C bus, comment out if using SPI mode
+  Wire.setClock(400000L);//clock stretching, comment out if using SPI mode
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin(MODE_I2C, MAG_DO_40_Hz, MAG_FS_16_Ga, MAG_BDU_ENABLE,
+        MAG_OMXY_HIGH_PERFORMANCE, MAG_OMZ_HIGH_PERFORMANCE, MAG_MD_CONTINUOUS,
+        ACC_FS_2g, ACC_BDU_ENABLE, ACC_X_ENABLE | ACC_Y_ENABLE | ACC_Z_ENABLE,
+        ACC_ODR_800_Hz) != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+
+#if USE_CHIP_HIGH_PASS
+  if (myIMU.setAccelHighPass(ACC_DFC_ODR_400) != IMU_SUCCESS)
+  {
+    Serial.println("Failed to enable high-pass.");
+    while (1);
+  }
+#endif
+
+  if (myIMU.enableAccelFifo(ACC_FIFO_STREAM, WATERMARK) != IMU_SUCCESS)
+  {
+    Serial.println("Failed to enable FIFO.");
+    while (1);
+  }
+
+  pipeline.add(despike);
+  pipeline.add(decimate);
+  pipeline.add(smooth);
+}
+
+void loop()
+{
+  static uint8_t outputs = 0;
+  uint8_t level;
+
+  if (myIMU.accelFifoLevel(level) != IMU_SUCCESS || level < WATERMARK)
+  {
+    return;
+  }
+
+  size_t count = myIMU.readAccelFifo(samples, ACC_FIFO_DEPTH);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    unsigned long start = micros();
+    bool ready = pipeline.process(samples[i]);
+    filterMicros += micros() - start;
+    filterInputs++;
+
+    // 100 Hz out of the pipeline, print every 10th
+    if (!ready || ++outputs < 10)
+    {
+      continue;
+    }
+    outputs = 0;
+
+    AxesRaw_t mg;
+    myIMU.accelMilliG(samples[i], mg);
+    Serial.print(mg.xAxis);
+    Serial.print(", ");
+    Serial.print(mg.yAxis);
+    Serial.print(", ");
+    Serial.print(mg.zAxis);
+    Serial.print(" mg, ");
+    Serial.print((float)filterMicros / filterInputs, 1);
+    Serial.println(" us/sample");
+  }
+}
@@ -0,0 +1,68 @@
+// No sensor needed
+//
+// Times converting a raw 3-axis sample to engineering units with the float
+// API against the integer (milli-g / micro-tesla) path and prints CPU clocks
+// per sample. Both follow the configured full scale. On the host build
+// run it with --real-time (make timing), simulated time doesn't move here.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+
+#define CONVERSIONS 10000
+
+LSM303C myIMU;
+
+// Results go through volatiles so the compiler can't drop the work
+volatile float   floatSink;
+volatile int16_t intSink;
+
+AxesRaw_t rawSample(uint16_t i)
+{
+  AxesRaw_t raw = {(int16_t)(i * 7), (int16_t)(-i * 13), (int16_t)(16384 + i)};
+  return raw;
+}
+
+float clocksPerSample(unsigned long elapsed)
+{
+  return (float)elapsed * (F_CPU / 1000000L) / CONVERSIONS;
+}
+
+void setup() {
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  unsigned long start = micros();
+  for (uint16_t i = 0; i < CONVERSIONS; i++)
+  {
+    AxesRaw_t raw = rawSample(i);
+    float scale = myIMU.accelSensitivity();
+    floatSink = raw.xAxis * scale;
+    floatSink = raw.yAxis * scale;
+    floatSink = raw.zAxis * scale;
+  }
+  unsigned long floatTime = micros() - start;
+
+  start = micros();
+  for (uint16_t i = 0; i < CONVERSIONS; i++)
+  {
+    AxesRaw_t raw = rawSample(i);
+    AxesRaw_t mg;
+    myIMU.accelMilliG(raw, mg);
+    intSink = mg.xAxis;
+    intSink = mg.yAxis;
+    intSink = mg.zAxis;
+  }
+  unsigned long intTime = micros() - start;
+
+  Serial.print("Float mg    : ");
+  Serial.print(clocksPerSample(floatTime), 1);
+  Serial.println(" clocks/sample");
+  Serial.print("Integer mg  : ");
+  Serial.print(clocksPerSample(intTime), 1);
+  Serial.println(" clocks/sample");
+}
+
+void loop()
+{
+}
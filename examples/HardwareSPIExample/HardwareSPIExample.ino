@@ -0,0 +1,58 @@
+// SPI interface on the SPI peripheral
+//
+// Uses the board's hardware SPI instead of the bit-banged Pro Mini pins, so
+// it runs on any board with an SPI library and the chip selects can go on
+// any free pins.
+//
+//  MOSI -> 1k resistor -> SDI/SDO
+//  MISO ------------------> SDI/SDO
+//  SCK  -> SCLK
+//  D9   -> CS_XL
+//  D8   -> CS_MAG
+#include "SPI.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CHardwareSPIBus.h"
+#include "LSM303CTypes.h"
+
+#define CS_MAG_PIN 8
+#define CS_XL_PIN  9
+
+LSM303CHardwareSPIBus spiBus(CS_MAG_PIN, CS_XL_PIN);
+LSM303C myIMU(spiBus);
+
+void setup() {
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+}
+
+void loop()
+{
+  float x, y, z;
+
+  Serial.print("\nAccelerometer:\n");
+  myIMU.readAccelXYZ(x, y, z);
+  Serial.print(" X = ");
+  Serial.println(x, 4);
+  Serial.print(" Y = ");
+  Serial.println(y, 4);
+  Serial.print(" Z = ");
+  Serial.println(z, 4);
+
+  Serial.print("\nMagnetometer:\n");
+  myIMU.readMagXYZ(x, y, z);
+  Serial.print(" X = ");
+  Serial.println(x, 4);
+  Serial.print(" Y = ");
+  Serial.println(y, 4);
+  Serial.print(" Z = ");
+  Serial.println(z, 4);
+
+  delay(1000);//slow down output to make it easier to read, adjust as necessary
+}
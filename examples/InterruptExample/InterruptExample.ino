@@ -0,0 +1,97 @@
+// I2C interface by default
+//
+// Lets the data-ready pins tell the sketch when a sample is waiting instead
+// of polling the status registers. Samples are queued with the time the
+// interrupt fired and printed whenever loop() gets around to it.
+//
+//  INT_XL   -> D2
+//  DRDY_MAG -> D3
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+
+#define INT_XL_PIN   2
+#define DRDY_MAG_PIN 3
+
+LSM303C myIMU;
+LSM303CSampleBuffer<16> accelQueue;
+LSM303CSampleBuffer<8>  magQueue;
+
+void accelISR() { myIMU.accelDataReadyISR(); }
+void magISR()   { myIMU.magDataReadyISR(); }
+
+void setup() {
+
+  Wire.begin();//set up I2C bus, comment out if using SPI mode
+  Wire.setClock(400000L);//clock stretching, comment out if using SPI mode
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+
+  pinMode(INT_XL_PIN, INPUT);
+  pinMode(DRDY_MAG_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(INT_XL_PIN), accelISR, RISING);
+  attachInterrupt(digitalPinToInterrupt(DRDY_MAG_PIN), magISR, RISING);
+
+  if (myIMU.enableAccelDataReadyInterrupt(&accelQueue) != IMU_SUCCESS ||
+      myIMU.enableMagDataReadyInterrupt(&magQueue) != IMU_SUCCESS)
+  {
+    Serial.println("Failed to enable interrupts.");
+    while (1);
+  }
+}
+
+void printSample(const char* label, const AxesSample_t& s, float scale)
+{
+  Serial.print(label);
+  Serial.print(" #");
+  Serial.print(s.sequence);
+  Serial.print(" @ ");
+  Serial.print(s.timestamp);
+  Serial.print(" us");
+  // The chip overwrote a sample before we got to it
+  Serial.print((s.flags & SAMPLE_OVERRUN) ? " (overrun): " : ": ");
+  Serial.print(s.axes.xAxis * scale, 4);
+  Serial.print(", ");
+  Serial.print(s.axes.yAxis * scale, 4);
+  Serial.print(", ");
+  Serial.println(s.axes.zAxis * scale, 4);
+}
+
+void loop()
+{
+  AxesSample_t sample;
+
+  // Only touches the bus when an interrupt flagged new data
+  myIMU.serviceInterrupts();
+
+  while (accelQueue.pop(sample))
+  {
+    printSample("Accel", sample, SENSITIVITY_ACC);
+  }
+
+  while (magQueue.pop(sample))
+  {
+    printSample("Mag  ", sample, SENSITIVITY_MAG);
+  }
+
+  // Printing at 57600 baud can't keep up with every sample, watch it fall
+  // behind
+  static unsigned long lastReport = 0;
+  if (millis() - lastReport > 5000)
+  {
+    lastReport = millis();
+    Serial.print("Accel samples/overruns/dropped: ");
+    Serial.print(myIMU.accelStats().samples);
+    Serial.print("/");
+    Serial.print(myIMU.accelStats().overruns);
+    Serial.print("/");
+    Serial.println(myIMU.accelStats().dropped);
+  }
+}
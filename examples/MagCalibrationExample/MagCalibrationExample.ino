@@ -0,0 +1,87 @@
+// I2C interface by default
+//
+// Slowly turn the board through every orientation. The calibrator fits an
+// ellipsoid to the magnetometer samples as they stream in, and once every
+// octant is covered the hard/soft-iron correction is applied to readMagXYZ().
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CMagCalibrator.h"
+#include "LSM303CTypes.h"
+
+#define MIN_SAMPLES 200
+
+LSM303C myIMU;
+LSM303CMagCalibrator calibrator;
+bool calibrated = false;
+
+void setup() {
+
+  Wire.begin();//set up I2C bus, comment out if using SPI mode
+  Wire.setClock(400000L);//clock stretching, comment out if using SPI mode
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+
+  Serial.println("Turn the board through every orientation...");
+}
+
+void loop()
+{
+  AxesRaw_t raw;
+
+  if (!calibrated)
+  {
+    if (myIMU.readMagRaw(raw) == IMU_SUCCESS && calibrator.add(raw) &&
+        calibrator.samples() % 50 == 0)
+    {
+      Serial.print("Samples: ");
+      Serial.print(calibrator.samples());
+      Serial.print("  Octants covered: ");
+      Serial.println(calibrator.coverage());
+    }
+
+    MagCalibration_t cal;
+    if (calibrator.samples() >= MIN_SAMPLES && calibrator.coverage() == 8 &&
+        calibrator.solve(cal))
+    {
+      myIMU.setMagCalibration(cal);
+      calibrated = true;
+
+      Serial.print("Offset: ");
+      Serial.print(cal.offset.xAxis);
+      Serial.print(", ");
+      Serial.print(cal.offset.yAxis);
+      Serial.print(", ");
+      Serial.print(cal.offset.zAxis);
+      Serial.print("  Gain (Q14): ");
+      Serial.print(cal.gain[0]);
+      Serial.print(", ");
+      Serial.print(cal.gain[1]);
+      Serial.print(", ");
+      Serial.print(cal.gain[2]);
+      Serial.print("  Fit error: ");
+      Serial.println(calibrator.fitError(), 4);
+    }
+    delay(20);
+    return;
+  }
+
+  float x, y, z;
+  myIMU.readMagXYZ(x, y, z);
+  Serial.print("Calibrated field: ");
+  Serial.print(x, 4);
+  Serial.print(", ");
+  Serial.print(y, 4);
+  Serial.print(", ");
+  Serial.print(z, 4);
+  Serial.print("  |B| = ");
+  Serial.println(sqrt(x * x + y * y + z * z), 4);
+
+  delay(500);//slow down output to make it easier to read, adjust as necessary
+}
@@ -0,0 +1,86 @@
+// I2C interface by default
+//
+// Door/lid sensor: a magnet on the door pushes the field past a threshold
+// and the magnetometer's INT_MAG pin wakes the sleeping MCU. The
+// accelerometer is powered down and the magnetometer runs at 5 Hz in low
+// power mode, so nothing polls while the door stays put.
+//
+//  INT_MAG -> D3
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+#include <avr/sleep.h>
+
+#define INT_MAG_PIN 3
+// Well above the earth's field (about 500 mG) plus the board's own offsets
+#define THRESHOLD_MILLIGAUSS 2000
+
+LSM303C myIMU;
+
+void wakeISR()
+{
+  // The pin stays low until the source is read, stop retriggering
+  detachInterrupt(digitalPinToInterrupt(INT_MAG_PIN));
+}
+
+void setup() {
+
+  Wire.begin();//set up I2C bus, comment out if using SPI mode
+  Wire.setClock(400000L);//clock stretching, comment out if using SPI mode
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+
+  pinMode(INT_MAG_PIN, INPUT);
+
+  if (myIMU.ACC_SetODR(ACC_ODR_POWER_DOWN) != IMU_SUCCESS ||
+      myIMU.MAG_SetODR(MAG_DO_5_Hz) != IMU_SUCCESS ||
+      myIMU.MAG_XY_AxOperativeMode(MAG_OMXY_LOW_POWER) != IMU_SUCCESS ||
+      myIMU.MAG_Z_AxOperativeMode(MAG_OMZ_LOW_PW) != IMU_SUCCESS ||
+      myIMU.setMagInterrupt(MAG_INT_ALL, THRESHOLD_MILLIGAUSS,
+        MAG_INT_LATCH | MAG_INT_ACTIVE_LOW) != IMU_SUCCESS)
+  {
+    Serial.println("Failed to set up interrupt.");
+    while (1);
+  }
+}
+
+void loop()
+{
+  static unsigned int events = 0;
+  uint8_t source;
+
+  Serial.flush();
+
+  // Sleep until INT_MAG goes low
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  noInterrupts();
+  attachInterrupt(digitalPinToInterrupt(INT_MAG_PIN), wakeISR, LOW);
+  interrupts();
+  sleep_cpu();
+  sleep_disable();
+
+  // Reading the source releases the latch and INT_MAG
+  if (myIMU.readMagInterruptSource(source) != IMU_SUCCESS)
+  {
+    Serial.println("Failed to read interrupt source.");
+    return;
+  }
+
+  if (source & MAG_INT_SRC_INT)
+  {
+    Serial.print("Magnet #");
+    Serial.print(++events);
+    Serial.print(":");
+    Serial.print((source & (MAG_INT_SRC_PTH_X | MAG_INT_SRC_NTH_X)) ? " X" : "");
+    Serial.print((source & (MAG_INT_SRC_PTH_Y | MAG_INT_SRC_NTH_Y)) ? " Y" : "");
+    Serial.println((source & (MAG_INT_SRC_PTH_Z | MAG_INT_SRC_NTH_Z)) ? " Z" : "");
+  }
+}
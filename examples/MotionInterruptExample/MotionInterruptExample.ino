@@ -0,0 +1,97 @@
+// I2C interface by default
+//
+// Puts the MCU to sleep and lets the accelerometer's interrupt generators
+// wake it: generator 1 on motion (any axis above 250 mg once gravity is
+// high-passed away), generator 2 on free-fall (every axis below 350 mg for
+// 30 ms). Both are latched on INT_XL, active low so the level interrupt can
+// wake an AVR from power-down.
+//
+//  INT_XL -> D2
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+#include <avr/sleep.h>
+
+#define INT_XL_PIN 2
+
+LSM303C myIMU;
+
+void wakeISR()
+{
+  // The pin stays low until the source is read, stop retriggering
+  detachInterrupt(digitalPinToInterrupt(INT_XL_PIN));
+}
+
+void setup() {
+
+  Wire.begin();//set up I2C bus, comment out if using SPI mode
+  Wire.setClock(400000L);//clock stretching, comment out if using SPI mode
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+
+  pinMode(INT_XL_PIN, INPUT);
+
+  ///// Combinations
+  //ACC_IG_OR          - any enabled event
+  //ACC_IG_AND         - all enabled events
+  //ACC_IG_6D_MOVEMENT - orientation changed
+  //ACC_IG_6D_POSITION - in the orientation picked by the events
+  if (myIMU.setAccelInterruptPin(true) != IMU_SUCCESS ||
+      myIMU.setAccelInterrupt(ACC_IG1, ACC_IG_ALL_HIGH | ACC_IG_OR, 250, 20,
+        ACC_IG_PIN | ACC_IG_LATCH | ACC_IG_HIGH_PASS) != IMU_SUCCESS ||
+      myIMU.setAccelInterrupt(ACC_IG2, ACC_IG_ALL_LOW | ACC_IG_AND, 350, 30,
+        ACC_IG_PIN | ACC_IG_LATCH) != IMU_SUCCESS)
+  {
+    Serial.println("Failed to set up interrupts.");
+    while (1);
+  }
+}
+
+void printSource(const char* label, uint8_t source)
+{
+  Serial.print(label);
+  Serial.print((source & ACC_IG_SRC_XH) ? " X" : "");
+  Serial.print((source & ACC_IG_SRC_YH) ? " Y" : "");
+  Serial.println((source & ACC_IG_SRC_ZH) ? " Z" : "");
+}
+
+void loop()
+{
+  uint8_t motion;
+  uint8_t fall;
+
+  Serial.flush();
+
+  // Sleep until INT_XL goes low
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  noInterrupts();
+  attachInterrupt(digitalPinToInterrupt(INT_XL_PIN), wakeISR, LOW);
+  interrupts();
+  sleep_cpu();
+  sleep_disable();
+
+  // Reading the sources releases the latch and INT_XL
+  if (myIMU.readAccelInterruptSource(ACC_IG1, motion) != IMU_SUCCESS ||
+      myIMU.readAccelInterruptSource(ACC_IG2, fall) != IMU_SUCCESS)
+  {
+    Serial.println("Failed to read interrupt source.");
+    return;
+  }
+
+  if (motion & ACC_IG_SRC_IA)
+  {
+    printSource("Motion on", motion);
+  }
+  if (fall & ACC_IG_SRC_IA)
+  {
+    Serial.println("Free-fall!");
+  }
+}
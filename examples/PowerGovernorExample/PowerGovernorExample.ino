@@ -0,0 +1,82 @@
+// I2C interface by default
+//
+// Lets LSM303CPowerGovernor pick the data rates: 100 Hz accelerometer and
+// 40 Hz high performance magnetometer while the board moves, stepping down
+// to 50 Hz / 10 Hz and then 10 Hz / 0.625 Hz low power once it has been
+// still for a while. At the low level the chip's inactivity detection also
+// drops the accelerometer to 10 Hz by itself once the board is still, well
+// before the governor's own idle time runs out. Prints every level change and
+// a report of the time spent at each level.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+#include "LSM303CPowerGovernor.h"
+
+LSM303C myIMU;
+LSM303CPowerGovernor governor(myIMU);
+
+const char* const LEVEL_NAMES[POWER_LEVEL_COUNT] = {"idle", "low", "active"};
+
+void setup() {
+
+  Wire.begin();//set up I2C bus, comment out if using SPI mode
+  Wire.setClock(400000L);//clock stretching, comment out if using SPI mode
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+
+  // Jump to active above 150 mg of motion, step down after 5 s under 50 mg
+  governor.setThresholds(150, 50, 5000);
+  // At 50 Hz, let the chip sleep at 10 Hz after 2 s within 100 mg
+  governor.setHardwareSleep(100, 2000);
+
+  if (governor.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed to start governor.");
+    while (1);
+  }
+}
+
+void loop()
+{
+  static POWER_LEVEL_t lastLevel = POWER_ACTIVE;
+  static unsigned long lastReport = 0;
+  AxesSample_t sample;
+
+  // Only fresh samples count, the rate changes under our feet
+  if (myIMU.readAccelSample(sample) == IMU_SUCCESS &&
+      !(sample.flags & SAMPLE_STALE))
+  {
+    governor.update(sample.axes);
+  }
+
+  if (governor.level() != lastLevel)
+  {
+    lastLevel = governor.level();
+    Serial.print("Now ");
+    Serial.print(LEVEL_NAMES[lastLevel]);
+    Serial.print(" (motion ");
+    Serial.print(governor.motion());
+    Serial.println(" mg)");
+  }
+
+  if (millis() - lastReport > 30000)
+  {
+    lastReport = millis();
+    for (uint8_t i = 0; i < POWER_LEVEL_COUNT; i++)
+    {
+      Serial.print(LEVEL_NAMES[i]);
+      Serial.print(": ");
+      Serial.print(governor.timeIn((POWER_LEVEL_t)i) / 1000);
+      Serial.print(" s  ");
+    }
+    Serial.print(governor.transitions());
+    Serial.println(" changes");
+  }
+}
@@ -0,0 +1,78 @@
+// I2C interface by default
+//
+// Times switching the accelerometer output data rate at runtime. The old
+// read-modify-write sequence is reproduced for comparison with the shadow
+// register path, which only writes.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+
+#define SWITCHES 200
+
+// Expose the protected register access so the old path can be reproduced
+class BenchIMU : public LSM303C
+{
+  public:
+    status_t readModifyWriteODR(ACC_ODR_t odr)
+    {
+      uint8_t value;
+      if (ACC_ReadReg(ACC_CTRL1, value))
+      {
+        return IMU_HW_ERROR;
+      }
+      value &= ~ACC_ODR_MASK;
+      value |= odr;
+      return (status_t)ACC_WriteReg(ACC_CTRL1, value);
+    }
+};
+
+BenchIMU myIMU;
+
+void setup() {
+
+  Wire.begin();//set up I2C bus
+  Wire.setClock(400000L);//clock stretching
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+}
+
+void loop()
+{
+  unsigned long start;
+
+  start = micros();
+  for (uint16_t i = 0; i < SWITCHES; i++)
+  {
+    myIMU.readModifyWriteODR((i & 1) ? ACC_ODR_100_Hz : ACC_ODR_200_Hz);
+  }
+  Serial.print("Read-modify-write: ");
+  Serial.print((float)(micros() - start) / SWITCHES, 1);
+  Serial.println(" us/switch");
+
+  // The shadow register went stale behind the library's back
+  myIMU.syncRegisters();
+
+  start = micros();
+  for (uint16_t i = 0; i < SWITCHES; i++)
+  {
+    myIMU.ACC_SetODR((i & 1) ? ACC_ODR_100_Hz : ACC_ODR_200_Hz);
+  }
+  Serial.print("Shadow register:   ");
+  Serial.print((float)(micros() - start) / SWITCHES, 1);
+  Serial.println(" us/switch");
+
+  if (myIMU.verifyRegisters() != IMU_SUCCESS)
+  {
+    Serial.println("Shadow registers out of sync!");
+  }
+
+  Serial.println();
+  delay(5000);
+}
@@ -0,0 +1,92 @@
+// No sensor needed
+//
+// Counts the bytes needed to send a simulated 100 Hz accelerometer + 40 Hz
+// magnetometer stream as text (the other examples' println(value, 4)) and as
+// LSM303CStream binary frames, and how much of a 57600 baud link each uses.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+#include "LSM303CStream.h"
+
+#define SECONDS   10
+#define ACCEL_ODR 100
+#define MAG_ODR   40
+// 8N1 framing: 10 bits on the wire per byte
+#define LINK_BYTES_PER_SECOND (57600L / 10)
+
+// Throws the output away, only counts it
+class CountingPrint : public Print
+{
+  public:
+    size_t count = 0;
+    size_t write(uint8_t) { count++; return 1; }
+};
+
+LSM303C myIMU;
+CountingPrint textOut;
+CountingPrint binaryOut;
+LSM303CStream stream(binaryOut);
+
+// A resting sensor: about 1 g on Z plus a few counts of noise
+AxesSample_t simulate(AxesSample_t s, uint16_t i, int16_t z, uint32_t period)
+{
+  s.axes.xAxis = (int16_t)(i * 37 % 21) - 10;
+  s.axes.yAxis = (int16_t)(i * 53 % 17) - 8;
+  s.axes.zAxis = z + (int16_t)(i * 29 % 13) - 6;
+  s.timestamp += period;
+  s.sequence++;
+  return s;
+}
+
+void sendText(const AxesSample_t& s, float scale)
+{
+  textOut.println(s.axes.xAxis * scale, 4);
+  textOut.println(s.axes.yAxis * scale, 4);
+  textOut.println(s.axes.zAxis * scale, 4);
+}
+
+void report(const char* name, size_t bytes, uint16_t samples)
+{
+  Serial.print(name);
+  Serial.print((float)bytes / samples, 1);
+  Serial.print(" bytes/sample, ");
+  Serial.print(100.0 * bytes / SECONDS / LINK_BYTES_PER_SECOND, 1);
+  Serial.println("% of 57600 baud");
+}
+
+void setup() {
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  AxesSample_t accel = {};
+  AxesSample_t mag = {};
+  uint16_t samples = 0;
+
+  stream.begin(myIMU);
+  binaryOut.count = 0;
+
+  for (uint16_t i = 0; i < SECONDS * ACCEL_ODR; i++)
+  {
+    accel = simulate(accel, i, 16384, 1000000L / ACCEL_ODR);
+    sendText(accel, myIMU.accelSensitivity() / 1000);
+    stream.writeAccel(accel);
+    samples++;
+
+    // The mag runs at 2/5 of the accelerometer rate
+    if (i % 5 == 0 || i % 5 == 3)
+    {
+      mag = simulate(mag, i, 3000, 1000000L / MAG_ODR);
+      sendText(mag, myIMU.magSensitivity());
+      stream.writeMag(mag);
+      samples++;
+    }
+  }
+
+  report("Text   : ", textOut.count, samples);
+  report("Binary : ", binaryOut.count, samples);
+}
+
+void loop()
+{
+}
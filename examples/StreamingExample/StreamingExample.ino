@@ -0,0 +1,80 @@
+// I2C interface by default
+//
+// Streams every accelerometer (100 Hz) and magnetometer (40 Hz) sample as
+// binary frames, which fits comfortably in 57600 baud where the text output
+// falls behind. The serial monitor will show garbage: decode on the host with
+// extras/StreamDecoder, e.g.
+//  lsm303c_decode < /dev/ttyUSB0
+//
+//  INT_XL   -> D2
+//  DRDY_MAG -> D3
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+#include "LSM303CStream.h"
+
+#define INT_XL_PIN   2
+#define DRDY_MAG_PIN 3
+
+LSM303C myIMU;
+LSM303CSampleBuffer<16> accelQueue;
+LSM303CSampleBuffer<8>  magQueue;
+LSM303CStream stream(Serial);
+
+void accelISR() { myIMU.accelDataReadyISR(); }
+void magISR()   { myIMU.magDataReadyISR(); }
+
+void setup() {
+
+  Wire.begin();//set up I2C bus, comment out if using SPI mode
+  Wire.setClock(400000L);//clock stretching, comment out if using SPI mode
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+
+  pinMode(INT_XL_PIN, INPUT);
+  pinMode(DRDY_MAG_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(INT_XL_PIN), accelISR, RISING);
+  attachInterrupt(digitalPinToInterrupt(DRDY_MAG_PIN), magISR, RISING);
+
+  if (myIMU.enableAccelDataReadyInterrupt(&accelQueue) != IMU_SUCCESS ||
+      myIMU.enableMagDataReadyInterrupt(&magQueue) != IMU_SUCCESS)
+  {
+    Serial.println("Failed to enable interrupts.");
+    while (1);
+  }
+
+  // Scales first so the decoder can print units
+  stream.begin(myIMU);
+}
+
+void loop()
+{
+  AxesSample_t sample;
+
+  myIMU.serviceInterrupts();
+
+  while (accelQueue.pop(sample))
+  {
+    stream.writeAccel(sample);
+  }
+
+  while (magQueue.pop(sample))
+  {
+    stream.writeMag(sample);
+  }
+
+  // Repeat the scales now and then for a decoder that attaches late
+  static unsigned long lastConfig = 0;
+  if (millis() - lastConfig > 5000)
+  {
+    lastConfig = millis();
+    stream.begin(myIMU);
+  }
+}
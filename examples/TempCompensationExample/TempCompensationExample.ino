@@ -0,0 +1,84 @@
+// I2C interface by default
+//
+// Temperature is only picked up every few seconds, riding along with a
+// magnetometer read, and drives a linear offset drift model for both
+// sensors. Measure the coefficients for your board by logging raw offsets
+// at two temperatures: (offset2 - offset1) / (T2 - T1) * 256.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+
+#define TEMP_INTERVAL_MS 5000
+
+LSM303C myIMU;
+
+// Reference 25 ˚C, counts/˚C in Q8 per axis (example values)
+const TempCompensation_t drift =
+{
+  2500,
+  {  64, -32, 96 },  // Accelerometer
+  { 128, 128,  0 }   // Magnetometer
+};
+
+void setup() {
+
+  Wire.begin();//set up I2C bus, comment out if using SPI mode
+  Wire.setClock(400000L);//clock stretching, comment out if using SPI mode
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+
+  if (myIMU.setTempInterval(TEMP_INTERVAL_MS) != IMU_SUCCESS)
+  {
+    Serial.println("Failed to enable the temperature sensor.");
+    while (1);
+  }
+  myIMU.setTempCompensation(drift);
+}
+
+void loop()
+{
+  AxesRaw_t mg;
+  AxesRaw_t uT;
+  int16_t centiC;
+
+  // Only one mag read in every TEMP_INTERVAL_MS fetches the temperature,
+  // the temperature read below is answered from the cache
+  if (myIMU.readAccelMilliG(mg) != IMU_SUCCESS ||
+      myIMU.readMagMicroTesla(uT) != IMU_SUCCESS ||
+      myIMU.readTempCentiC(centiC) != IMU_SUCCESS)
+  {
+    Serial.println("Read failed.");
+    return;
+  }
+
+  Serial.print("T: ");
+  if (centiC < 0)
+  {
+    Serial.print("-");
+    centiC = -centiC;
+  }
+  Serial.print(centiC / 100);
+  Serial.print(".");
+  Serial.print((centiC / 10) % 10);
+  Serial.print(" C  mg: ");
+  Serial.print(mg.xAxis);
+  Serial.print(", ");
+  Serial.print(mg.yAxis);
+  Serial.print(", ");
+  Serial.print(mg.zAxis);
+  Serial.print("  uT: ");
+  Serial.print(uT.xAxis);
+  Serial.print(", ");
+  Serial.print(uT.yAxis);
+  Serial.print(", ");
+  Serial.println(uT.zAxis);
+
+  delay(500);
+}
@@ -0,0 +1,77 @@
+// I2C interface by default
+//
+// Ten times a second, waits for a fresh accelerometer sample, fires one
+// magnetometer conversion right behind it and prints the pair. The
+// magnetometer sits powered down between shots instead of converting
+// continuously at its output data rate.
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CTypes.h"
+
+#define FRAME_INTERVAL_MS 100
+
+LSM303C myIMU;
+
+void setup() {
+
+  Wire.begin();//set up I2C bus, comment out if using SPI mode
+  Wire.setClock(400000L);//clock stretching, comment out if using SPI mode
+
+  Serial.begin(57600);//initialize serial monitor, maximum reliable baud for 3.3V/8Mhz ATmega328P is 57600
+
+  if (myIMU.begin() != IMU_SUCCESS)
+  {
+    Serial.println("Failed setup.");
+    while (1);
+  }
+
+  // Shots only from here on
+  if (myIMU.MAG_SetMode(MAG_MD_POWER_DOWN_2) != IMU_SUCCESS)
+  {
+    Serial.println("Failed to power down the magnetometer.");
+    while (1);
+  }
+}
+
+void loop()
+{
+  static uint32_t last = 0;
+  AxesSample_t accel;
+  AxesSample_t mag;
+  AxesRaw_t mg;
+  AxesRaw_t uT;
+
+  if (millis() - last < FRAME_INTERVAL_MS)
+  {
+    return;
+  }
+  last = millis();
+
+  if (myIMU.readTriggeredFrame(accel, mag) != IMU_SUCCESS)
+  {
+    Serial.println("Frame failed.");
+    return;
+  }
+
+  myIMU.accelMilliG(accel.axes, mg);
+  myIMU.magMicroTesla(mag.axes, uT);
+
+  Serial.print("#");
+  Serial.print(accel.sequence);
+  Serial.print(" mg: ");
+  Serial.print(mg.xAxis);
+  Serial.print(", ");
+  Serial.print(mg.yAxis);
+  Serial.print(", ");
+  Serial.print(mg.zAxis);
+  Serial.print("  uT: ");
+  Serial.print(uT.xAxis);
+  Serial.print(", ");
+  Serial.print(uT.yAxis);
+  Serial.print(", ");
+  Serial.print(uT.zAxis);
+  Serial.print("  mag lag: ");
+  Serial.print(mag.timestamp - accel.timestamp);
+  Serial.println(" us");
+}
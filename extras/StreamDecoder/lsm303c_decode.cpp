@@ -0,0 +1,52 @@
+// Host-side decoder for LSM303CStream output. Reads the binary stream on
+// stdin and prints one CSV line per sample:
+//  die,sequence,timestamp_us,x,y,z,flags
+// with the accelerometer in g and the magnetometer in gauss once a config
+// frame has been seen (raw counts until then, or always with -r).
+#include <stdio.h>
+#include <string.h>
+#include "LSM303CStreamCodec.h"
+
+int main(int argc, char** argv)
+{
+  bool raw = argc > 1 && !strcmp(argv[1], "-r");
+  LSM303CStreamDecoder decoder;
+  StreamRecord_t record;
+  unsigned long samples = 0;
+  int c;
+
+  printf("die,sequence,timestamp_us,x,y,z,flags\n");
+
+  while ((c = getchar()) != EOF)
+  {
+    if (!decoder.feed((uint8_t)c, record) || record.type == STREAM_CONFIG)
+    {
+      continue;
+    }
+
+    const AxesSample_t& s = record.sample;
+    bool accel = record.type == STREAM_ACCEL;
+    // mg/LSB for the accelerometer, Ga/LSB for the magnetometer
+    double scale = accel ? decoder.accelSensitivity() / 1000.0 :
+      decoder.magSensitivity();
+
+    samples++;
+    printf("%s,%u,%lu,", accel ? "accel" : "mag", s.sequence,
+        (unsigned long)s.timestamp);
+    if (raw || scale == 0)
+    {
+      printf("%d,%d,%d", s.axes.xAxis, s.axes.yAxis, s.axes.zAxis);
+    }
+    else
+    {
+      printf("%.4f,%.4f,%.4f", s.axes.xAxis * scale, s.axes.yAxis * scale,
+          s.axes.zAxis * scale);
+    }
+    printf(",%u\n", s.flags);
+    fflush(stdout);
+  }
+
+  fprintf(stderr, "%lu samples, %lu bad frames\n", samples,
+      (unsigned long)decoder.errors());
+  return 0;
+}
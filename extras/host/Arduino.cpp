@@ -0,0 +1,238 @@
+#include "Arduino.h"
+#include "Wire.h"
+#include "SPI.h"
+#include "EEPROM.h"
+#include <stdio.h>
+#include <time.h>
+
+HardwareSerial Serial;
+TwoWire Wire;
+SPIClass SPI;
+EEPROMClass EEPROM;
+
+////////////////////////////////////////////////////////////////////////////////
+////// Time
+
+static unsigned long nowMicros = 0;
+static bool realTime = false;
+
+static unsigned long hostClockMicros(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+unsigned long micros(void)
+{
+  return realTime ? nowMicros + hostClockMicros() : nowMicros;
+}
+unsigned long millis(void) { return micros() / 1000; }
+void delay(unsigned long ms) { nowMicros += ms * 1000; }
+void delayMicroseconds(unsigned int us) { nowMicros += us; }
+void hostElapse(unsigned long us) { nowMicros += us; }
+
+// Switching keeps micros() where it was
+void hostRealTime(bool on)
+{
+  if (on != realTime)
+  {
+    nowMicros += on ? -hostClockMicros() : hostClockMicros();
+    realTime = on;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////// Pins and interrupts
+
+static uint8_t pinLevel[NUM_DIGITAL_PINS];
+static void (*pinHandler[NUM_DIGITAL_PINS])(void);
+static int pinEdge[NUM_DIGITAL_PINS];
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if (pin < NUM_DIGITAL_PINS && mode == INPUT_PULLUP)
+  {
+    pinLevel[pin] = HIGH;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t level)
+{
+  if (pin < NUM_DIGITAL_PINS)
+  {
+    pinLevel[pin] = level ? HIGH : LOW;
+  }
+}
+
+int digitalRead(uint8_t pin)
+{
+  return pin < NUM_DIGITAL_PINS ? pinLevel[pin] : LOW;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode)
+{
+  if (pin < NUM_DIGITAL_PINS)
+  {
+    pinHandler[pin] = handler;
+    pinEdge[pin] = mode;
+  }
+}
+
+void detachInterrupt(uint8_t pin)
+{
+  if (pin < NUM_DIGITAL_PINS)
+  {
+    pinHandler[pin] = NULL;
+  }
+}
+
+void interrupts(void) { }
+void noInterrupts(void) { }
+
+void hostSetPin(uint8_t pin, int level)
+{
+  if (pin >= NUM_DIGITAL_PINS)
+  {
+    return;
+  }
+
+  uint8_t was = pinLevel[pin];
+  pinLevel[pin] = level ? HIGH : LOW;
+  if (!pinHandler[pin] || was == pinLevel[pin])
+  {
+    return;
+  }
+  if (pinEdge[pin] == CHANGE ||
+      (pinEdge[pin] == RISING && pinLevel[pin] == HIGH) ||
+      (pinEdge[pin] == FALLING && pinLevel[pin] == LOW))
+  {
+    pinHandler[pin]();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////// Print
+
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+  size_t n = 0;
+  while (size--)
+  {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base)
+{
+  char buf[8 * sizeof(long) + 1];
+  char* str = &buf[sizeof(buf) - 1];
+
+  *str = '\0';
+  if (base < 2)
+  {
+    base = 10;
+  }
+  do
+  {
+    char c = n % base;
+    n /= base;
+    *--str = c < 10 ? c + '0' : c + 'A' - 10;
+  } while (n);
+  return write(str);
+}
+
+// Same rounding and digit-by-digit output as the AVR core
+size_t Print::printFloat(double number, uint8_t digits)
+{
+  size_t n = 0;
+
+  if (isnan(number)) return print("nan");
+  if (isinf(number)) return print("inf");
+  if (number > 4294967040.0) return print("ovf");
+  if (number < -4294967040.0) return print("ovf");
+
+  if (number < 0.0)
+  {
+    n += print('-');
+    number = -number;
+  }
+
+  double rounding = 0.5;
+  for (uint8_t i = 0; i < digits; ++i)
+  {
+    rounding /= 10.0;
+  }
+  number += rounding;
+
+  unsigned long intPart = (unsigned long)number;
+  double remainder = number - (double)intPart;
+  n += printNumber(intPart, 10);
+
+  if (digits > 0)
+  {
+    n += print('.');
+  }
+  while (digits-- > 0)
+  {
+    remainder *= 10.0;
+    unsigned int toPrint = (unsigned int)remainder;
+    n += printNumber(toPrint, 10);
+    remainder -= toPrint;
+  }
+  return n;
+}
+
+size_t Print::print(const char* str) { return write(str); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(unsigned char b, int base) { return print((unsigned long)b, base); }
+size_t Print::print(int n, int base) { return print((long)n, base); }
+size_t Print::print(unsigned int n, int base) { return print((unsigned long)n, base); }
+
+size_t Print::print(long n, int base)
+{
+  if (base == 10 && n < 0)
+  {
+    return print('-') + printNumber(-(unsigned long)n, 10);
+  }
+  if (base == 10)
+  {
+    return printNumber(n, 10);
+  }
+  // Other bases print the two's complement, 32 bits wide like the AVR core
+  return printNumber((uint32_t)n, base);
+}
+
+size_t Print::print(unsigned long n, int base) { return printNumber(n, base); }
+size_t Print::print(double n, int digits) { return printFloat(n, digits); }
+
+// Host line endings, not the core's \r\n
+size_t Print::println(void) { return write("\n"); }
+size_t Print::println(const char* str) { return print(str) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(unsigned char b, int base) { return print(b, base) + println(); }
+size_t Print::println(int n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned int n, int base) { return print(n, base) + println(); }
+size_t Print::println(long n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned long n, int base) { return print(n, base) + println(); }
+size_t Print::println(double n, int digits) { return print(n, digits) + println(); }
+
+////////////////////////////////////////////////////////////////////////////////
+////// Serial
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+  return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush(void)
+{
+  fflush(stdout);
+}
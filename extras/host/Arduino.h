@@ -0,0 +1,138 @@
+// Host stand-in for the parts of the Arduino core the library and its
+// examples use. Time is simulated: it only moves on delay(),
+// delayMicroseconds() and hostElapse(), so runs are repeatable. With
+// hostRealTime() micros() also follows the host's clock, for sketches that
+// time CPU work. Serial
+// writes to stdout and pins are plain variables that hostSetPin() drives.
+#ifndef __HOST_ARDUINO_H__
+#define __HOST_ARDUINO_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PI 3.1415926535897932384626433832795
+
+// Nominal desktop clock, so the benchmarks' clock counts (micros() times
+// F_CPU) come out near host cycles
+#define F_CPU 3000000000UL
+
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define sq(x) ((x)*(x))
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) \
+  ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+#define _BV(bit) (1 << (bit))
+
+#define digitalPinToInterrupt(p) (p)
+#define NUM_DIGITAL_PINS 32
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+unsigned long micros(void);
+unsigned long millis(void);
+void delay(unsigned long);
+void delayMicroseconds(unsigned int);
+
+void pinMode(uint8_t, uint8_t);
+void digitalWrite(uint8_t, uint8_t);
+int  digitalRead(uint8_t);
+
+void attachInterrupt(uint8_t, void (*)(void), int);
+void detachInterrupt(uint8_t);
+void interrupts(void);
+void noInterrupts(void);
+
+// Host only: advance simulated time, and drive an input pin from outside.
+// A level change on a pin with an attached interrupt calls its handler when
+// the edge matches the mode.
+void hostElapse(unsigned long us);
+void hostSetPin(uint8_t pin, int level);
+void hostRealTime(bool on);
+
+class Print
+{
+  public:
+    virtual ~Print() { }
+
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+
+    size_t print(const char*);
+    size_t print(char);
+    size_t print(unsigned char, int = DEC);
+    size_t print(int, int = DEC);
+    size_t print(unsigned int, int = DEC);
+    size_t print(long, int = DEC);
+    size_t print(unsigned long, int = DEC);
+    size_t print(double, int = 2);
+
+    size_t println(const char*);
+    size_t println(char);
+    size_t println(unsigned char, int = DEC);
+    size_t println(int, int = DEC);
+    size_t println(unsigned int, int = DEC);
+    size_t println(long, int = DEC);
+    size_t println(unsigned long, int = DEC);
+    size_t println(double, int = 2);
+    size_t println(void);
+
+  private:
+    size_t printNumber(unsigned long, uint8_t);
+    size_t printFloat(double, uint8_t);
+};
+
+class Stream : public Print
+{
+  public:
+    virtual int available(void) = 0;
+    virtual int read(void) = 0;
+    virtual int peek(void) { return -1; }
+};
+
+// stdout; nothing ever arrives on the receive side
+class HardwareSerial : public Stream
+{
+  public:
+    void begin(unsigned long) { }
+    void end(void) { }
+    void flush(void);
+    int  available(void) { return 0; }
+    int  read(void) { return -1; }
+    size_t write(uint8_t);
+    size_t write(const uint8_t*, size_t);
+    using Print::write;
+    operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
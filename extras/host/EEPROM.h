@@ -0,0 +1,36 @@
+// Host stand-in for EEPROM: 1 KiB in memory, erased (0xFF) at start.
+#ifndef __HOST_EEPROM_H__
+#define __HOST_EEPROM_H__
+
+#include "Arduino.h"
+
+#define HOST_EEPROM_SIZE 1024
+
+class EEPROMClass
+{
+  public:
+    EEPROMClass() { memset(cells, 0xFF, sizeof(cells)); }
+
+    uint8_t read(int address) { return cells[address]; }
+    void write(int address, uint8_t value) { cells[address] = value; }
+    void update(int address, uint8_t value) { cells[address] = value; }
+    uint16_t length(void) { return HOST_EEPROM_SIZE; }
+
+    template <typename T> T& get(int address, T& t)
+    {
+      memcpy(&t, cells + address, sizeof(T));
+      return t;
+    }
+    template <typename T> const T& put(int address, const T& t)
+    {
+      memcpy(cells + address, &t, sizeof(T));
+      return t;
+    }
+
+  private:
+    uint8_t cells[HOST_EEPROM_SIZE];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,31 @@
+// Host stand-in for SPI. Nothing is attached: MISO reads back 0xFF.
+#ifndef __HOST_SPI_H__
+#define __HOST_SPI_H__
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings
+{
+  public:
+    SPISettings() { }
+    SPISettings(uint32_t, uint8_t, uint8_t) { }
+};
+
+class SPIClass
+{
+  public:
+    void begin(void) { }
+    void end(void) { }
+    void beginTransaction(SPISettings) { }
+    void endTransaction(void) { }
+    uint8_t transfer(uint8_t) { return 0xFF; }
+};
+
+extern SPIClass SPI;
+
+#endif
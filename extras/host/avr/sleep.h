@@ -0,0 +1,14 @@
+// Host stand-in for avr/sleep.h: sleeping returns at once.
+#ifndef __HOST_AVR_SLEEP_H__
+#define __HOST_AVR_SLEEP_H__
+
+#define SLEEP_MODE_IDLE     0
+#define SLEEP_MODE_PWR_DOWN 2
+
+inline void set_sleep_mode(int) { }
+inline void sleep_enable(void) { }
+inline void sleep_disable(void) { }
+inline void sleep_cpu(void) { }
+inline void sleep_mode(void) { }
+
+#endif
@@ -0,0 +1,33 @@
+// Runs a sketch on the host: setup() once, then loop() the number of times
+// given on the command line (once by default). --real-time lets micros()
+// follow the host's clock, see hostRealTime().
+#include "Arduino.h"
+#include <string.h>
+
+void setup(void);
+void loop(void);
+
+int main(int argc, char** argv)
+{
+  long loops = 1;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--real-time") == 0)
+    {
+      hostRealTime(true);
+    }
+    else
+    {
+      loops = atol(argv[i]);
+    }
+  }
+
+  setup();
+  while (loops-- > 0)
+  {
+    loop();
+  }
+  Serial.flush();
+  return 0;
+}
@@ -0,0 +1,129 @@
+// Accelerometer calibration edge cases: corrections saturate instead of
+// wrapping, and a full-scale change drops a calibration whose offsets were
+// counts at the old scale, REFERENCE registers included.
+#include "Arduino.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CEmulator.h"
+#include "LSM303CAccelCalibrator.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, \
+    __LINE__, #cond); failures++; } } while (0)
+
+LSM303CEmulator emu;
+LSM303C imu(emu);
+
+static AccelCalibration_t calibration(ACC_FS_t fullScale, int16_t x, int16_t y,
+    int16_t z, int16_t gain)
+{
+  AccelCalibration_t cal = AccelCalibration_t();
+
+  cal.version = ACC_CAL_VERSION;
+  cal.fullScale = fullScale;
+  cal.offset.xAxis = x;
+  cal.offset.yAxis = y;
+  cal.offset.zAxis = z;
+  cal.gain[0] = cal.gain[1] = cal.gain[2] = gain;
+  LSM303CAccelCalibrator::seal(cal);
+  return cal;
+}
+
+static AxesRaw_t reference()
+{
+  uint8_t ref[6];
+  AxesRaw_t axes = {0, 0, 0};
+
+  CHECK(emu.readRegs(ACC, ACC_XL_REFERENCE, ref, sizeof(ref)) == IMU_SUCCESS);
+  axes.xAxis = (int16_t)((ref[1] << 8) | ref[0]);
+  axes.yAxis = (int16_t)((ref[3] << 8) | ref[2]);
+  axes.zAxis = (int16_t)((ref[5] << 8) | ref[4]);
+  return axes;
+}
+
+static uint8_t highPassMode()
+{
+  uint8_t ctrl2 = 0;
+
+  CHECK(emu.readRegs(ACC, ACC_CTRL2, &ctrl2, 1) == IMU_SUCCESS);
+  return ctrl2 & ACC_HPM_MASK;
+}
+
+// Offsets and gains that push a reading past int16_t clamp at the rails
+static void testSaturation()
+{
+  AxesRaw_t raw = {32000, -32000, 100};
+  AxesRaw_t out;
+
+  CHECK(imu.setAccelCalibration(
+        calibration(ACC_FS_2g, -2000, 2000, 0, 19661)) == IMU_SUCCESS);
+  imu.correctAccel(raw, out);
+  CHECK(out.xAxis == 32767);
+  CHECK(out.yAxis == -32768);
+  CHECK(out.zAxis == 120);
+
+  raw.xAxis = -32768;
+  raw.yAxis = 32767;
+  imu.correctAccel(raw, out);
+  CHECK(out.xAxis == -32768);
+  CHECK(out.yAxis == 32767);
+
+  CHECK(imu.clearAccelCalibration() == IMU_SUCCESS);
+}
+
+static void testFullScaleChange()
+{
+  AccelCalibration_t cal = calibration(ACC_FS_2g, 300, -200, 100, 16384);
+  AxesRaw_t source = {1000, 1000, 1000};
+  AxesRaw_t raw;
+
+  emu.setAccel(source);
+  CHECK(imu.setAccelCalibration(cal, true) == IMU_SUCCESS);
+  CHECK(highPassMode() == ACC_HPM_REFERENCE);
+  CHECK(reference().xAxis == 300);
+  emu.elapse(10000);
+  CHECK(imu.readAccelRaw(raw) == IMU_SUCCESS);
+  CHECK(raw.xAxis == 700 && raw.yAxis == 1200 && raw.zAxis == 900);
+
+  // Same scale again: nothing changes
+  CHECK(imu.ACC_SetFullScale(ACC_FS_2g) == IMU_SUCCESS);
+  CHECK(highPassMode() == ACC_HPM_REFERENCE);
+
+  // New scale: the chip stops subtracting and holds no stale offsets
+  CHECK(imu.ACC_SetFullScale(ACC_FS_8g) == IMU_SUCCESS);
+  CHECK(highPassMode() == ACC_HPM_NORMAL);
+  CHECK(reference().xAxis == 0 && reference().yAxis == 0 &&
+      reference().zAxis == 0);
+  emu.elapse(10000);
+  CHECK(imu.readAccelRaw(raw) == IMU_SUCCESS);
+  CHECK(raw.xAxis == 1000 && raw.yAxis == 1000 && raw.zAxis == 1000);
+
+  // Software offsets go too, and the old blob no longer applies
+  CHECK(imu.setAccelCalibration(cal) == IMU_GENERIC_ERROR);
+  CHECK(imu.setAccelCalibration(
+        calibration(ACC_FS_8g, 50, 0, 0, 16384)) == IMU_SUCCESS);
+  CHECK(imu.ACC_SetFullScale(ACC_FS_4g) == IMU_SUCCESS);
+  imu.correctAccel(source, raw);
+  CHECK(raw.xAxis == 1000);
+}
+
+int main()
+{
+  CHECK(imu.begin(MODE_I2C, MAG_DO_80_Hz, MAG_FS_16_Ga, MAG_BDU_ENABLE,
+        MAG_OMXY_HIGH_PERFORMANCE, MAG_OMZ_HIGH_PERFORMANCE, MAG_MD_CONTINUOUS,
+        ACC_FS_2g, ACC_BDU_ENABLE, ACC_X_ENABLE | ACC_Y_ENABLE | ACC_Z_ENABLE,
+        ACC_ODR_800_Hz) == IMU_SUCCESS);
+
+  testSaturation();
+  testFullScaleChange();
+
+  if (failures)
+  {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,159 @@
+// LSM303CArray with one device going dead and coming back: it drops out of
+// frames instead of stalling them, is only retried now and then, and rejoins
+// on its first fresh sample. Covered for both schedules.
+#include "Arduino.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CEmulator.h"
+#include "LSM303CArray.h"
+#include <stdio.h>
+
+#define ACC_PERIOD_US 1250 // 800 Hz
+#define FRAME_TIMEOUT_US 5000
+
+static int failures = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, \
+    __LINE__, #cond); failures++; } } while (0)
+
+// An emulator that can be unplugged
+class FlakyEmulator : public LSM303CEmulator
+{
+  public:
+    bool dead = false;
+    uint32_t attempts = 0;
+
+    status_t readRegs(CHIP_t chip, uint8_t reg, uint8_t* data, uint8_t len)
+    {
+      attempts++;
+      return dead ? IMU_HW_ERROR : LSM303CEmulator::readRegs(chip, reg, data, len);
+    }
+    status_t writeRegs(CHIP_t chip, uint8_t reg, const uint8_t* data,
+        uint8_t len)
+    {
+      attempts++;
+      return dead ? IMU_HW_ERROR : LSM303CEmulator::writeRegs(chip, reg, data, len);
+    }
+};
+
+FlakyEmulator emu[2];
+LSM303C imu0(emu[0]);
+LSM303C imu1(emu[1]);
+LSM303C* imus[2] = {&imu0, &imu1};
+LSM303CArraySlot_t frame[2];
+
+// One sample period on every clock. With data-ready scheduling the
+// emulated INT_XL level stands in for the pin interrupt, and a dead device
+// never raises it.
+static void tick(bool dataReady)
+{
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    emu[i].elapse(ACC_PERIOD_US);
+    if (dataReady && !emu[i].dead && emu[i].intXL())
+    {
+      imus[i]->accelDataReadyISR();
+    }
+  }
+  hostElapse(ACC_PERIOD_US);
+}
+
+// Runs n periods and returns how many frames came out. mask gets the
+// LSM303C_FRESH_ACCEL bit of each device that was in the last frame.
+static uint16_t run(LSM303CArray& array, uint16_t n, bool dataReady,
+    uint8_t& mask)
+{
+  uint16_t frames = 0;
+
+  for (uint16_t i = 0; i < n; i++)
+  {
+    tick(dataReady);
+    array.poll();
+    if (array.readFrame(frame))
+    {
+      frames++;
+      mask = 0;
+      for (uint8_t d = 0; d < 2; d++)
+      {
+        if (frame[d].fresh & LSM303C_FRESH_ACCEL)
+        {
+          mask |= 1 << d;
+        }
+      }
+    }
+  }
+  return frames;
+}
+
+static void testSchedule(ARRAY_SCHEDULE_t schedule)
+{
+  LSM303CArrayOf<2> array;
+  bool dataReady = schedule == ARRAY_DATA_READY;
+  uint8_t mask = 0;
+  uint32_t attempts;
+
+  emu[0].dead = emu[1].dead = false;
+  CHECK(array.add(imu0) == IMU_SUCCESS);
+  CHECK(array.add(imu1) == IMU_SUCCESS);
+  CHECK(array.setSchedule(schedule) == IMU_SUCCESS);
+  array.setFrameTimeout(FRAME_TIMEOUT_US);
+
+  // Both healthy: a frame every period with both devices in it
+  CHECK(run(array, 20, dataReady, mask) >= 18);
+  CHECK(mask == 0x03);
+  CHECK(array.onlineCount() == 2);
+
+  // Device 1 dies. Round robin sees errors, data-ready only sees frames it
+  // misses; either way it's out after a few periods and frames keep coming.
+  emu[1].dead = true;
+  run(array, 4 * FRAME_TIMEOUT_US / ACC_PERIOD_US, dataReady, mask);
+  CHECK(!array.online(1));
+  CHECK(array.online(0));
+  CHECK(run(array, 40, dataReady, mask) >= 38);
+  CHECK(mask == 0x01);
+  CHECK(frame[1].fresh == 0);
+  CHECK(frame[1].errors >= LSM303C_ARRAY_FAIL_LIMIT);
+
+  // Out devices are only retried every LSM303C_ARRAY_RETRY_PASSES passes
+  attempts = emu[1].attempts;
+  run(array, 4 * LSM303C_ARRAY_RETRY_PASSES, dataReady, mask);
+  CHECK(emu[1].attempts - attempts <= 4 * 2);
+  CHECK(!array.online(1));
+
+  // Back again: it rejoins on its first fresh sample
+  emu[1].dead = false;
+  run(array, LSM303C_ARRAY_RETRY_PASSES + 2, dataReady, mask);
+  CHECK(array.online(1));
+  CHECK(run(array, 20, dataReady, mask) >= 18);
+  CHECK(mask == 0x03);
+
+  // Everything dead: no frames at all, rather than empty ones. Data-ready
+  // scheduling never hears from any of them, so it has nothing to count.
+  emu[0].dead = emu[1].dead = true;
+  run(array, 4 * FRAME_TIMEOUT_US / ACC_PERIOD_US, dataReady, mask);
+  CHECK(dataReady || array.onlineCount() == 0);
+  CHECK(run(array, 40, dataReady, mask) == 0);
+}
+
+int main()
+{
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    CHECK(imus[i]->begin(MODE_I2C, MAG_DO_80_Hz, MAG_FS_16_Ga, MAG_BDU_ENABLE,
+          MAG_OMXY_HIGH_PERFORMANCE, MAG_OMZ_HIGH_PERFORMANCE,
+          MAG_MD_CONTINUOUS, ACC_FS_2g, ACC_BDU_ENABLE,
+          ACC_X_ENABLE | ACC_Y_ENABLE | ACC_Z_ENABLE,
+          ACC_ODR_800_Hz) == IMU_SUCCESS);
+  }
+
+  testSchedule(ARRAY_ROUND_ROBIN);
+  testSchedule(ARRAY_DATA_READY);
+
+  if (failures)
+  {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,116 @@
+// Bus instrumentation through setBusStats(). This file is built without
+// LSM303C_INSTRUMENTATION and linked against both library builds, so it
+// also checks that a sketch doesn't need the flag to match the library's.
+// Run with "instrumented" against the instrumented one.
+#include "Arduino.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CEmulator.h"
+#include "LSM303CBusStats.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, \
+    __LINE__, #cond); failures++; } } while (0)
+
+LSM303CEmulator emu;
+LSM303C imu(emu);
+LSM303CBusStats stats;
+
+static uint32_t transfers()
+{
+  uint32_t n = 0;
+
+  for (uint8_t chip = 0; chip < 2; chip++)
+  {
+    for (uint8_t dir = 0; dir < BUS_OP_COUNT; dir++)
+    {
+      n += stats.op((CHIP_t)chip, (BUS_OP_t)dir).transfers;
+    }
+  }
+  return n;
+}
+
+static void readBoth(uint8_t n)
+{
+  AxesSample_t accel;
+  AxesSample_t mag;
+
+  for (uint8_t i = 0; i < n; i++)
+  {
+    emu.elapse(12500);
+    hostElapse(12500);
+    imu.readAccelSample(accel);
+    imu.readMagSample(mag);
+  }
+}
+
+static void testInstrumented()
+{
+  CHECK(imu.setBusStats(&stats) == IMU_SUCCESS);
+  CHECK(imu.begin(MODE_I2C, MAG_DO_80_Hz, MAG_FS_16_Ga, MAG_BDU_ENABLE,
+        MAG_OMXY_HIGH_PERFORMANCE, MAG_OMZ_HIGH_PERFORMANCE, MAG_MD_CONTINUOUS,
+        ACC_FS_2g, ACC_BDU_ENABLE, ACC_X_ENABLE | ACC_Y_ENABLE | ACC_Z_ENABLE,
+        ACC_ODR_100_Hz) == IMU_SUCCESS);
+  // begin() is counted too
+  CHECK(transfers() > 0);
+
+  // Every transfer the chip sees is filed once
+  stats.reset();
+  emu.resetCounters();
+  readBoth(10);
+  CHECK(transfers() == emu.transactions());
+  CHECK(stats.op(ACC, BUS_OP_READ).transfers > 0);
+  CHECK(stats.op(MAG, BUS_OP_READ).transfers > 0);
+  CHECK(stats.op(ACC, BUS_OP_READ).errors == 0);
+
+  // The transport files the cause of a failure
+  imu.setAutoRecover(false);
+  emu.hangBus();
+  readBoth(1);
+  CHECK(stats.op(ACC, BUS_OP_READ).errors > 0);
+  CHECK(stats.faults(BUS_FAULT_TIMEOUT) > 0);
+  CHECK(emu.recover() == IMU_SUCCESS);
+
+  // Detached: nothing more is counted
+  CHECK(imu.setBusStats(NULL) == IMU_SUCCESS);
+  stats.reset();
+  readBoth(10);
+  CHECK(transfers() == 0);
+  CHECK(stats.faults(BUS_FAULT_TIMEOUT) == 0);
+}
+
+// Compiled out: refused, and the stats are never touched
+static void testCompiledOut()
+{
+  CHECK(imu.setBusStats(&stats) == IMU_NOT_SUPPORTED);
+  CHECK(imu.begin() == IMU_SUCCESS);
+  emu.hangBus();
+  readBoth(10);
+  CHECK(emu.recover() == IMU_SUCCESS);
+  CHECK(transfers() == 0);
+  CHECK(stats.faults(BUS_FAULT_TIMEOUT) == 0);
+  CHECK(imu.setBusStats(NULL) == IMU_SUCCESS);
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 1 && strcmp(argv[1], "instrumented") == 0)
+  {
+    testInstrumented();
+  }
+  else
+  {
+    testCompiledOut();
+  }
+
+  if (failures)
+  {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,154 @@
+// LSM303CCompass against double-precision atan2 and the AN4248 tilt
+// compensation it implements: the bounds promised in LSM303CCompass.h,
+// 0.01 degrees for atan2() and 0.05 degrees for heading, pitch and roll.
+#include "LSM303CCompass.h"
+#include <math.h>
+#include <stdio.h>
+
+#define ATAN2_BOUND_DEG    0.01
+#define ATTITUDE_BOUND_DEG 0.05
+#define DEG_PER_COUNT      (360.0 / 65536)
+
+static int failures = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, \
+    __LINE__, #cond); failures++; } } while (0)
+
+static uint32_t seed = 1;
+
+static double uniform()
+{
+  seed = seed * 1664525UL + 1013904223UL;
+  return (seed >> 8) / 16777216.0;
+}
+
+// Difference of two angles in degrees, wrapped to +-180
+static double angleError(double binaryAngle, double radians)
+{
+  double d = binaryAngle * DEG_PER_COUNT - radians * 180 / M_PI;
+
+  d = fmod(d + 540, 360) - 180;
+  return fabs(d);
+}
+
+// Every direction at lengths from a few counts to the full int32 range
+static void testAtan2()
+{
+  const int32_t lengths[] = {3, 100, 1000, 32767, 1000000, 0x7FFFFFF, 0x3FFFFFFF};
+  double worst = 0;
+
+  for (uint8_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+  {
+    for (uint16_t i = 0; i < 3600; i++)
+    {
+      double a = i * M_PI / 1800 + 0.0001;
+      int32_t x = (int32_t)lround(lengths[l] * cos(a));
+      int32_t y = (int32_t)lround(lengths[l] * sin(a));
+      double e = angleError(LSM303CCompass::atan2(y, x), atan2((double)y, (double)x));
+      if (e > worst)
+      {
+        worst = e;
+      }
+    }
+  }
+  CHECK(LSM303CCompass::atan2(0, 0) == 0);
+  CHECK(worst <= ATAN2_BOUND_DEG);
+}
+
+// Random gravity and field vectors of sensor-like size. Near-vertical
+// attitudes and fields with little horizontal component are skipped,
+// heading isn't defined well enough there to compare.
+static void testUpdate()
+{
+  double worst[3] = {0, 0, 0};
+  uint16_t tested = 0;
+
+  while (tested < 20000)
+  {
+    AxesRaw_t g, b;
+    Attitude_t att;
+    double v[3];
+    double len = 0;
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+      v[i] = uniform() * 2 - 1;
+      len += v[i] * v[i];
+    }
+    len = sqrt(len);
+    g.xAxis = (int16_t)lround(16384 * v[0] / len);
+    g.yAxis = (int16_t)lround(16384 * v[1] / len);
+    g.zAxis = (int16_t)lround(16384 * v[2] / len);
+    b.xAxis = (int16_t)lround((uniform() * 2 - 1) * 3000);
+    b.yAxis = (int16_t)lround((uniform() * 2 - 1) * 3000);
+    b.zAxis = (int16_t)lround((uniform() * 2 - 1) * 3000);
+
+    double roll = atan2((double)g.yAxis, (double)g.zAxis);
+    double sr = sin(roll), cr = cos(roll);
+    double pitch = atan2(-(double)g.xAxis, g.yAxis * sr + g.zAxis * cr);
+    double sp = sin(pitch), cp = cos(pitch);
+    double bfy = b.zAxis * sr - b.yAxis * cr;
+    double bfx = b.xAxis * cp + (b.yAxis * sr + b.zAxis * cr) * sp;
+    double field = sqrt((double)b.xAxis * b.xAxis + (double)b.yAxis * b.yAxis +
+        (double)b.zAxis * b.zAxis);
+
+    if (fabs(pitch) > 80 * M_PI / 180 || hypot(bfx, bfy) < 0.3 * field ||
+        field < 1000)
+    {
+      continue;
+    }
+    tested++;
+
+    LSM303CCompass::update(g, b, att);
+    double e[3] =
+    {
+      angleError(att.heading, atan2(bfy, bfx)),
+      angleError(att.pitch, pitch),
+      angleError(att.roll, roll)
+    };
+    for (uint8_t i = 0; i < 3; i++)
+    {
+      if (e[i] > worst[i])
+      {
+        worst[i] = e[i];
+      }
+    }
+  }
+
+  CHECK(worst[0] <= ATTITUDE_BOUND_DEG);
+  CHECK(worst[1] <= ATTITUDE_BOUND_DEG);
+  CHECK(worst[2] <= ATTITUDE_BOUND_DEG);
+}
+
+// Flat and pointing at magnetic north, east, south, west
+static void testCardinal()
+{
+  const AxesRaw_t flat = {0, 0, 16384};
+  const AxesRaw_t fields[4] = {{2000, 0, 1500}, {0, -2000, 1500},
+    {-2000, 0, 1500}, {0, 2000, 1500}};
+  Attitude_t att;
+
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    LSM303CCompass::update(flat, fields[i], att);
+    CHECK(angleError(att.heading, i * M_PI / 2) <= ATTITUDE_BOUND_DEG);
+    CHECK(angleError(att.pitch, 0) <= ATTITUDE_BOUND_DEG);
+    CHECK(angleError(att.roll, 0) <= ATTITUDE_BOUND_DEG);
+  }
+}
+
+int main()
+{
+  testAtan2();
+  testUpdate();
+  testCardinal();
+
+  if (failures)
+  {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,196 @@
+// Fixed-point filter stages: biquad DC gain and step response against the
+// same difference equation in double, CIC decimation ratio and gain, the
+// median dropping spikes, the moving average, and a chain of them.
+#include "LSM303CFilter.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int failures = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, \
+    __LINE__, #cond); failures++; } } while (0)
+
+static AxesRaw_t axes(int16_t v)
+{
+  AxesRaw_t a = {v, (int16_t)-v, (int16_t)(v / 2)};
+  return a;
+}
+
+// Steady at 0, then a step to 1000. Tracks the unquantized filter with the
+// same coefficients, checks the overshoot of a Q = 0.7071 low-pass (4.3%)
+// and that it settles exactly.
+static void testBiquadStep()
+{
+  BiquadCoeffs_t c = LSM303CBiquad::lowPass(20, 800);
+  LSM303CBiquad lowPass(c);
+  const double k = 1.0 / (1 << FILTER_COEFF_SHIFT);
+  double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+  int16_t peak = 0;
+  int worst = 0;
+
+  // Exactly unity at DC
+  CHECK(c.b0 + c.b1 + c.b2 == (1 << FILTER_COEFF_SHIFT) + c.a1 + c.a2);
+
+  AxesRaw_t s = axes(0);
+  lowPass.process(s);
+  for (uint16_t i = 0; i < 400; i++)
+  {
+    s = axes(1000);
+    lowPass.process(s);
+
+    double y = k * (c.b0 * 1000.0 + c.b1 * x1 + c.b2 * x2 - c.a1 * y1 - c.a2 * y2);
+    x2 = x1;
+    x1 = 1000;
+    y2 = y1;
+    y1 = y;
+    int e = abs(s.xAxis - (int)lround(y));
+    worst = e > worst ? e : worst;
+    peak = s.xAxis > peak ? s.xAxis : peak;
+  }
+  CHECK(worst <= 2);
+  CHECK(peak >= 1030 && peak <= 1055);
+  CHECK(s.xAxis == 1000 && s.yAxis == -1000 && s.zAxis == 500);
+}
+
+// Starting from a steady input there is no transient; high-pass removes DC
+static void testBiquadDc()
+{
+  LSM303CBiquad lowPass(LSM303CBiquad::lowPass(5, 100));
+  LSM303CBiquad highPass(LSM303CBiquad::highPass(5, 100));
+  AxesRaw_t s;
+
+  for (uint16_t i = 0; i < 200; i++)
+  {
+    s = axes(-12345);
+    lowPass.process(s);
+    CHECK(s.xAxis == -12345 && s.yAxis == 12345 && s.zAxis == -6172);
+  }
+
+  s = axes(0);
+  highPass.process(s);
+  for (uint16_t i = 0; i < 400; i++)
+  {
+    s = axes(1000);
+    highPass.process(s);
+  }
+  CHECK(s.xAxis == 0 && s.yAxis == 0 && s.zAxis == 0);
+}
+
+// One output per 2^LOG2_RATE inputs, DC gain exactly 1
+static void testCic()
+{
+  LSM303CCICDecimator<3, 3> cic;
+  uint16_t outputs = 0;
+  AxesRaw_t s;
+
+  for (uint16_t i = 0; i < 800; i++)
+  {
+    s = axes(1234);
+    if (cic.process(s))
+    {
+      outputs++;
+      CHECK(s.xAxis == 1234 && s.yAxis == -1234 && s.zAxis == 617);
+    }
+  }
+  CHECK(outputs == 100);
+
+  // A step settles within ORDER outputs
+  for (uint16_t i = 0; i < 8 * 3; i++)
+  {
+    s = axes(-20000);
+    cic.process(s);
+  }
+  CHECK(s.xAxis == -20000 && s.yAxis == 20000 && s.zAxis == -10000);
+
+  // And a full-scale input doesn't overflow
+  cic.reset();
+  for (uint16_t i = 0; i < 64; i++)
+  {
+    s = axes(32767);
+    if (cic.process(s))
+    {
+      CHECK(s.xAxis == 32767);
+    }
+  }
+}
+
+// A lone spike never reaches the output, a step still gets through
+static void testMedian()
+{
+  LSM303CMedianFilter<3> median;
+  AxesRaw_t s;
+
+  for (uint16_t i = 0; i < 50; i++)
+  {
+    s = axes(i == 20 ? 5000 : 100);
+    median.process(s);
+    CHECK(s.xAxis == 100 && s.yAxis == -100 && s.zAxis == 50);
+  }
+
+  s = axes(300);
+  median.process(s);
+  CHECK(s.xAxis == 100);
+  s = axes(300);
+  median.process(s);
+  CHECK(s.xAxis == 300);
+}
+
+static void testMovingAverage()
+{
+  LSM303CMovingAverage<8> average;
+  AxesRaw_t s = axes(0);
+
+  average.process(s);
+  for (uint8_t i = 1; i <= 8; i++)
+  {
+    s = axes(800);
+    average.process(s);
+    CHECK(s.xAxis == 100 * i);
+  }
+}
+
+static void testChain()
+{
+  LSM303CMedianFilter<3> median;
+  LSM303CCICDecimator<2, 2> cic;
+  LSM303CBiquad lowPass(LSM303CBiquad::lowPass(10, 200));
+  LSM303CFilterChainOf<2> full;
+  LSM303CFilterChainOf<3> chain;
+  uint16_t outputs = 0;
+  AxesRaw_t s;
+
+  CHECK(chain.add(median) && chain.add(cic) && chain.add(lowPass));
+  CHECK(!full.add(median) || !full.add(cic) || !full.add(lowPass));
+  CHECK(chain.size() == 3);
+
+  for (uint16_t i = 0; i < 400; i++)
+  {
+    s = axes(i % 37 == 36 ? -30000 : 2000); // Lone spikes
+    if (chain.process(s))
+    {
+      outputs++;
+      CHECK(s.xAxis == 2000);
+    }
+  }
+  CHECK(outputs == 100);
+}
+
+int main()
+{
+  testBiquadStep();
+  testBiquadDc();
+  testCic();
+  testMedian();
+  testMovingAverage();
+  testChain();
+
+  if (failures)
+  {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,53 @@
+// LSM303CI2CBus::recover() restarts Wire at the clock it was given and
+// otherwise leaves the clock to Wire.begin(), rather than picking one.
+#include "Arduino.h"
+#include "Wire.h"
+#include "LSM303CBus.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, \
+    __LINE__, #cond); failures++; } } while (0)
+
+// A sketch running its bus at 100 kHz keeps it after a recovery
+static void testDefaultClock()
+{
+  LSM303CI2CBus bus(Wire);
+
+  Wire.begin();
+  Wire.setClock(100000);
+  CHECK(bus.recover() == IMU_SUCCESS);
+  CHECK(Wire.getClock() == 100000);
+}
+
+static void testExplicitClock()
+{
+  LSM303CI2CBus bus(Wire);
+
+  Wire.begin();
+  Wire.setClock(1000000);
+  bus.setRecoveryClock(1000000);
+  CHECK(bus.recover() == IMU_SUCCESS);
+  CHECK(Wire.getClock() == 1000000);
+
+  // Setting the pins doesn't touch the clock
+  bus.setRecoveryPins(LSM303C_NO_PIN, LSM303C_NO_PIN);
+  CHECK(bus.recover() == IMU_SUCCESS);
+  CHECK(Wire.getClock() == 1000000);
+}
+
+int main()
+{
+  testDefaultClock();
+  testExplicitClock();
+
+  if (failures)
+  {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,194 @@
+// Interrupt pipeline against the emulator: the INT_XL level is mirrored onto
+// a pin with an attached handler, so accelDataReadyISR() runs on real rising
+// edges and serviceInterrupts() fills an LSM303CSampleQueue.
+#include "Arduino.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CEmulator.h"
+#include <stdio.h>
+
+#define INT_XL_PIN 2
+#define STEP_US 10
+#define ACC_PERIOD_US 1250 // 800 Hz
+
+static int failures = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, \
+    __LINE__, #cond); failures++; } } while (0)
+
+LSM303CEmulator emu;
+LSM303C imu(emu);
+LSM303CSampleBuffer<4> queue;
+
+static uint8_t  edges = 0;
+static uint32_t lastEdge = 0;
+
+void intXLHandler()
+{
+  edges++;
+  lastEdge = micros();
+  imu.accelDataReadyISR();
+}
+
+// Steps both clocks and copies the emulated INT_XL level onto the pin
+static void run(uint32_t us)
+{
+  for (uint32_t t = 0; t < us; t += STEP_US)
+  {
+    emu.elapse(STEP_US);
+    hostElapse(STEP_US);
+    hostSetPin(INT_XL_PIN, emu.intXL());
+  }
+}
+
+// Runs until the next rising edge and returns its micros() time
+static uint32_t nextEdge()
+{
+  uint8_t seen = edges;
+
+  for (uint16_t i = 0; i < 2 * ACC_PERIOD_US / STEP_US && edges == seen; i++)
+  {
+    run(STEP_US);
+  }
+  CHECK(edges == seen + 1);
+  return lastEdge;
+}
+
+static AxesRaw_t axes(int16_t x)
+{
+  AxesRaw_t a = {x, (int16_t)-x, 16384};
+  return a;
+}
+
+static void drain()
+{
+  AxesSample_t s = AxesSample_t();
+  while (queue.pop(s)) { }
+}
+
+// Each edge is serviced before the next: samples come out in order with the
+// time of their edge, not the time they were read
+static void testOrderAndTimestamps()
+{
+  uint32_t edgeTime[4];
+  uint16_t firstSequence = 0;
+  AxesSample_t s = AxesSample_t();
+
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    emu.setAccel(axes(100 + i));
+    edgeTime[i] = nextEdge();
+    hostElapse(300); // The sketch gets around to it later
+    CHECK(imu.serviceInterrupts() == IMU_SUCCESS);
+  }
+
+  CHECK(queue.available() == 4);
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    CHECK(queue.pop(s));
+    if (i == 0)
+    {
+      firstSequence = s.sequence;
+    }
+    CHECK(s.axes.xAxis == 100 + i);
+    CHECK(s.axes.yAxis == -(100 + i));
+    CHECK(s.timestamp == edgeTime[i]);
+    CHECK(s.sequence == (uint16_t)(firstSequence + i));
+    CHECK(s.flags == 0);
+  }
+  CHECK(queue.empty());
+  CHECK(imu.accelStats().dropped == 0);
+  CHECK(imu.accelStats().overruns == 0);
+}
+
+// Nothing pops: the queue keeps the oldest samples and counts the rest
+static void testDropsWhenFull()
+{
+  uint32_t edgeTime[6];
+  AxesSample_t s = AxesSample_t();
+
+  imu.resetStats();
+  for (uint8_t i = 0; i < 6; i++)
+  {
+    emu.setAccel(axes(200 + i));
+    edgeTime[i] = nextEdge();
+    CHECK(imu.serviceInterrupts() == IMU_SUCCESS);
+  }
+
+  CHECK(queue.available() == queue.capacity());
+  CHECK(imu.accelStats().samples == 6);
+  CHECK(imu.accelStats().dropped == 2);
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    CHECK(queue.pop(s));
+    CHECK(s.axes.xAxis == 200 + i);
+    CHECK(s.timestamp == edgeTime[i]);
+    CHECK(s.sequence == i);
+  }
+  CHECK(!queue.pop(s));
+}
+
+// A conversion lands before the first was serviced: INT_XL never drops, so
+// there is no second edge, and the one sample read is flagged as an overrun
+static void testMissedService()
+{
+  AxesSample_t s = AxesSample_t();
+  uint32_t edge;
+  uint8_t seen;
+
+  drain();
+  imu.resetStats();
+  emu.setAccel(axes(300));
+  edge = nextEdge();
+  seen = edges;
+  emu.setAccel(axes(301));
+  run(ACC_PERIOD_US + 100);
+  CHECK(edges == seen);
+  CHECK(imu.serviceInterrupts() == IMU_SUCCESS);
+
+  CHECK(queue.pop(s));
+  CHECK(s.axes.xAxis == 301);
+  CHECK(s.timestamp == edge);
+  CHECK(s.flags & SAMPLE_OVERRUN);
+  CHECK(imu.accelStats().overruns == 1);
+  CHECK(!queue.pop(s));
+
+  // Reading released the pin, the next conversion raises a new edge
+  emu.setAccel(axes(302));
+  nextEdge();
+  CHECK(imu.serviceInterrupts() == IMU_SUCCESS);
+  CHECK(queue.pop(s));
+  CHECK(s.axes.xAxis == 302);
+  CHECK(!(s.flags & SAMPLE_OVERRUN));
+}
+
+int main()
+{
+  CHECK(imu.begin(MODE_I2C, MAG_DO_80_Hz, MAG_FS_16_Ga, MAG_BDU_ENABLE,
+        MAG_OMXY_HIGH_PERFORMANCE, MAG_OMZ_HIGH_PERFORMANCE, MAG_MD_CONTINUOUS,
+        ACC_FS_2g, ACC_BDU_ENABLE, ACC_X_ENABLE | ACC_Y_ENABLE | ACC_Z_ENABLE,
+        ACC_ODR_800_Hz) == IMU_SUCCESS);
+
+  pinMode(INT_XL_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(INT_XL_PIN), intXLHandler, RISING);
+  CHECK(imu.enableAccelDataReadyInterrupt(&queue) == IMU_SUCCESS);
+  hostSetPin(INT_XL_PIN, emu.intXL());
+  CHECK(edges == 0);
+
+  // The first edge only clears whatever converted during setup
+  nextEdge();
+  CHECK(imu.serviceInterrupts() == IMU_SUCCESS);
+  drain();
+
+  testOrderAndTimestamps();
+  testDropsWhenFull();
+  testMissedService();
+
+  if (failures)
+  {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
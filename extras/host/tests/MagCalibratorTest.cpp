@@ -0,0 +1,121 @@
+// LSM303CMagCalibrator on synthetic ellipsoids: the fit has to hold for
+// hard-iron offsets well beyond the field radius, and the reported fit error
+// has to track the noise rather than the sample count.
+#include "LSM303CMagCalibrator.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RADIUS 860 // Earth's field at 16 gauss full scale, roughly
+
+static int failures = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, \
+    __LINE__, #cond); failures++; } } while (0)
+
+static uint32_t seed = 1;
+
+static double uniform()
+{
+  seed = seed * 1664525UL + 1013904223UL;
+  return (seed >> 8) / 16777216.0;
+}
+
+static double gaussian()
+{
+  double u = uniform() + 1e-12;
+  return sqrt(-2 * log(u)) * cos(2 * M_PI * uniform());
+}
+
+// Feeds n points of a sphere of RADIUS, stretched per axis by scale and
+// moved by offset, with Gaussian noise of sigma counts
+static void feed(LSM303CMagCalibrator& cal, uint16_t n, const double offset[3],
+    const double scale[3], double sigma)
+{
+  uint16_t added = 0;
+
+  while (added < n)
+  {
+    double v[3] = {gaussian(), gaussian(), gaussian()};
+    double len = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    AxesRaw_t raw;
+
+    raw.xAxis = (int16_t)lround(offset[0] + RADIUS * scale[0] * v[0] / len + sigma * gaussian());
+    raw.yAxis = (int16_t)lround(offset[1] + RADIUS * scale[1] * v[1] / len + sigma * gaussian());
+    raw.zAxis = (int16_t)lround(offset[2] + RADIUS * scale[2] * v[2] / len + sigma * gaussian());
+    added += cal.add(raw);
+  }
+}
+
+static void testOffset(double k, uint16_t n)
+{
+  const double offset[3] = {1000 * k, -1000 * k, 500 * k};
+  const double scale[3] = {1.05, 0.95, 1.0};
+  LSM303CMagCalibrator cal;
+  MagCalibration_t fit;
+
+  feed(cal, n, offset, scale, 2);
+  CHECK(cal.coverage() == 8);
+  if (!cal.solve(fit))
+  {
+    printf("  offset x%.1f, %u samples: no fit\n", k, n);
+    failures++;
+    return;
+  }
+  CHECK(labs(fit.offset.xAxis - lround(offset[0])) <= 3);
+  CHECK(labs(fit.offset.yAxis - lround(offset[1])) <= 3);
+  CHECK(labs(fit.offset.zAxis - lround(offset[2])) <= 3);
+  // Gains stretch each axis to the mean radius
+  CHECK(fabs(fit.gain[0] * scale[0] - fit.gain[2] * scale[2]) < 40);
+  CHECK(fabs(fit.gain[1] * scale[1] - fit.gain[2] * scale[2]) < 40);
+  CHECK(cal.fitError() > 0.001f && cal.fitError() < 0.005f);
+}
+
+// Same data quality, up to 30 times the samples: same error
+static void testErrorAgainstCount()
+{
+  const double offset[3] = {-300, 200, 100};
+  const double scale[3] = {1, 1, 1};
+  LSM303CMagCalibrator cal;
+  MagCalibration_t fit;
+  float small, large;
+
+  feed(cal, 2000, offset, scale, 2);
+  CHECK(cal.solve(fit));
+  small = cal.fitError();
+  feed(cal, 18000, offset, scale, 2);
+  CHECK(cal.solve(fit));
+  large = cal.fitError();
+  CHECK(fabs(large - small) < 0.1f * small);
+  feed(cal, 40000, offset, scale, 2);
+  CHECK(cal.solve(fit));
+  CHECK(fabs(cal.fitError() - small) < 0.1f * small);
+
+  // And it still sees worse data
+  cal.reset();
+  feed(cal, 20000, offset, scale, 10);
+  CHECK(cal.solve(fit));
+  CHECK(cal.fitError() > 3 * small);
+}
+
+int main()
+{
+  const double ks[] = {0, 0.5, 1, 2, 4, 8};
+
+  for (uint8_t i = 0; i < sizeof(ks) / sizeof(ks[0]); i++)
+  {
+    testOffset(ks[i], 200);
+    testOffset(ks[i], 2000);
+    testOffset(ks[i], 20000);
+  }
+  testErrorAgainstCount();
+
+  if (failures)
+  {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
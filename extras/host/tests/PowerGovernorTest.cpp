@@ -0,0 +1,142 @@
+// LSM303CPowerGovernor against the emulator: motion above the up threshold
+// jumps straight to active, quiet steps down one level per idle time,
+// motion between the thresholds holds the level, and the time and
+// transition report adds up. The chip sees each level's profile.
+#include "Arduino.h"
+#include "SparkFunLSM303C.h"
+#include "LSM303CEmulator.h"
+#include "LSM303CPowerGovernor.h"
+#include <stdio.h>
+
+#define SAMPLE_MS 10
+#define IDLE_MS 5000
+#define MG 16 // Counts per mg at 2 g full scale, near enough (0.061 mg/LSB)
+
+static int failures = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, \
+    __LINE__, #cond); failures++; } } while (0)
+
+LSM303CEmulator emu;
+LSM303C imu(emu);
+LSM303CPowerGovernor governor(imu);
+
+static uint8_t accReg(uint8_t reg)
+{
+  uint8_t value = 0;
+
+  CHECK(emu.readRegs(ACC, reg, &value, 1) == IMU_SUCCESS);
+  return value;
+}
+
+// Feeds a sample every SAMPLE_MS for ms, lying flat plus xMg on x
+static void feed(uint32_t ms, int16_t xMg = 0)
+{
+  AxesRaw_t raw = {(int16_t)(xMg * MG), 0, 1000 * MG};
+
+  for (uint32_t t = 0; t < ms; t += SAMPLE_MS)
+  {
+    hostElapse(SAMPLE_MS * 1000UL);
+    CHECK(governor.update(raw) == IMU_SUCCESS);
+  }
+}
+
+// One sample off by xMg, then back to still
+static void bump(int16_t xMg)
+{
+  feed(SAMPLE_MS, xMg);
+  feed(SAMPLE_MS);
+}
+
+static void testSteps()
+{
+  CHECK(governor.begin() == IMU_SUCCESS);
+  CHECK(governor.level() == POWER_ACTIVE);
+  CHECK((accReg(ACC_CTRL1) & ACC_ODR_MASK) == ACC_ODR_100_Hz);
+  CHECK(accReg(ACC_ACT_TSH) == 0);
+
+  // Quiet, but not yet for a whole idle time
+  feed(IDLE_MS - 100);
+  CHECK(governor.level() == POWER_ACTIVE);
+
+  // One step per idle time, not straight to the bottom
+  feed(200);
+  CHECK(governor.level() == POWER_LOW);
+  CHECK((accReg(ACC_CTRL1) & ACC_ODR_MASK) == ACC_ODR_50_Hz);
+  // Faster than the chip's 10 Hz sleep rate, so inactivity is armed
+  CHECK(accReg(ACC_ACT_TSH) != 0);
+  feed(IDLE_MS - 300);
+  CHECK(governor.level() == POWER_LOW);
+
+  // Motion between the thresholds restarts the idle time without waking up
+  bump(100);
+  CHECK(governor.level() == POWER_LOW);
+  feed(IDLE_MS - 100);
+  CHECK(governor.level() == POWER_LOW);
+  feed(200);
+  CHECK(governor.level() == POWER_IDLE);
+  CHECK((accReg(ACC_CTRL1) & ACC_ODR_MASK) == ACC_ODR_10_Hz);
+  // Already at the sleep rate: nothing to gain
+  CHECK(accReg(ACC_ACT_TSH) == 0);
+
+  // Past the up threshold: straight to active from the bottom
+  feed(SAMPLE_MS, 300);
+  CHECK(governor.motion() >= 290 && governor.motion() <= 310);
+  CHECK(governor.level() == POWER_ACTIVE);
+  CHECK((accReg(ACC_CTRL1) & ACC_ODR_MASK) == ACC_ODR_100_Hz);
+  CHECK(accReg(ACC_ACT_TSH) == 0);
+}
+
+static void testReport()
+{
+  uint32_t total;
+
+  CHECK(governor.begin() == IMU_SUCCESS);
+  CHECK(governor.transitions() == 0);
+
+  feed(IDLE_MS);            // Active -> low
+  feed(IDLE_MS);            // Low -> idle
+  feed(1000);
+  bump(300);                // Idle -> active
+  feed(2000);
+
+  CHECK(governor.transitions() == 3);
+  CHECK(governor.timeIn(POWER_ACTIVE) >= IDLE_MS + 2000 &&
+      governor.timeIn(POWER_ACTIVE) <= IDLE_MS + 2000 + 3 * SAMPLE_MS);
+  CHECK(governor.timeIn(POWER_LOW) >= IDLE_MS - SAMPLE_MS &&
+      governor.timeIn(POWER_LOW) <= IDLE_MS + SAMPLE_MS);
+  CHECK(governor.timeIn(POWER_IDLE) >= 1000 &&
+      governor.timeIn(POWER_IDLE) <= 1000 + 2 * SAMPLE_MS);
+  total = governor.timeIn(POWER_IDLE) + governor.timeIn(POWER_LOW) +
+      governor.timeIn(POWER_ACTIVE);
+  CHECK(total == 2 * IDLE_MS + 1000 + 2 * SAMPLE_MS + 2000);
+
+  // The current stretch counts as it goes
+  hostElapse(500000UL);
+  CHECK(governor.timeIn(POWER_ACTIVE) - (total - governor.timeIn(POWER_IDLE) -
+      governor.timeIn(POWER_LOW)) == 500);
+
+  governor.resetReport();
+  CHECK(governor.transitions() == 0);
+  CHECK(governor.timeIn(POWER_ACTIVE) == 0);
+  CHECK(governor.timeIn(POWER_LOW) == 0);
+}
+
+int main()
+{
+  CHECK(imu.begin() == IMU_SUCCESS);
+  governor.setThresholds(150, 50, IDLE_MS);
+  governor.setHardwareSleep(100, 2000);
+
+  testSteps();
+  testReport();
+
+  if (failures)
+  {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
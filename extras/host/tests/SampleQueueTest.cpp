@@ -0,0 +1,94 @@
+// LSM303CSampleQueue indexing: capacities that aren't a power of two, and
+// the head/tail counters wrapping past 255.
+#include "Arduino.h"
+#include "LSM303CSampleQueue.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, \
+    __LINE__, #cond); failures++; } } while (0)
+
+static AxesSample_t sample(uint16_t sequence)
+{
+  AxesSample_t s = AxesSample_t();
+  s.sequence = sequence;
+  return s;
+}
+
+// Fills the queue past capacity and checks nothing lands outside storage
+static void testCapacity(uint8_t requested, uint8_t expected)
+{
+  AxesSample_t storage[200];
+  AxesSample_t guard = sample(0xBEEF);
+  AxesSample_t s = AxesSample_t();
+  uint16_t pushed = 0;
+
+  for (uint8_t i = 0; i < 200; i++)
+  {
+    storage[i] = guard;
+  }
+
+  LSM303CSampleQueue queue(storage, requested);
+  CHECK(queue.capacity() == expected);
+  while (queue.push(sample(pushed)) && pushed < 300)
+  {
+    pushed++;
+  }
+  CHECK(pushed == expected);
+  CHECK(queue.available() == expected);
+  for (uint16_t i = expected; i < 200; i++)
+  {
+    CHECK(storage[i].sequence == 0xBEEF);
+  }
+  for (uint16_t i = 0; i < expected; i++)
+  {
+    CHECK(queue.pop(s));
+    CHECK(s.sequence == i);
+  }
+  CHECK(!queue.pop(s));
+}
+
+// Interleaved pushes and pops run the 8-bit indexes round several times
+static void testWrap()
+{
+  LSM303CSampleBuffer<8> queue;
+  AxesSample_t s = AxesSample_t();
+  uint16_t in = 0;
+  uint16_t out = 0;
+
+  while (in < 1000)
+  {
+    for (uint8_t i = 0; i < 5; i++)
+    {
+      CHECK(queue.push(sample(in++)));
+    }
+    for (uint8_t i = 0; i < 5; i++)
+    {
+      CHECK(queue.pop(s));
+      CHECK(s.sequence == out++);
+    }
+  }
+  CHECK(queue.empty());
+}
+
+int main()
+{
+  testCapacity(1, 1);
+  testCapacity(8, 8);
+  testCapacity(12, 8);
+  testCapacity(100, 64);
+  testCapacity(128, 128);
+  testCapacity(200, 128);
+  testCapacity(0, 1);
+  testWrap();
+
+  if (failures)
+  {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,252 @@
+// LSM303CStreamEncoder into LSM303CStreamDecoder: the round trip, keyframe
+// spacing, resync after a corrupted byte and deltas that have nothing to
+// apply to.
+#include "LSM303CStreamCodec.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SAMPLES 200
+// A config frame, then accel and mag for each sample
+#define FRAMES (1 + 2 * SAMPLES)
+
+static int failures = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, \
+    __LINE__, #cond); failures++; } } while (0)
+
+static uint8_t stream[FRAMES * STREAM_MAX_ENCODED];
+static size_t start[FRAMES + 1];
+
+static uint16_t frameOf(CHIP_t chip, uint16_t i)
+{
+  return 1 + 2 * i + (chip == MAG);
+}
+
+static CHIP_t chipOf(uint16_t frame)
+{
+  return frame % 2 ? ACC : MAG;
+}
+
+static uint16_t sampleOf(uint16_t frame)
+{
+  return (frame - 1) / 2;
+}
+
+// Slow ramps with a jump too big for a delta every 50 samples, and the
+// sequence and timestamp wrapping partway through
+static AxesSample_t sampleAt(CHIP_t chip, uint16_t i)
+{
+  AxesSample_t s = AxesSample_t();
+  int16_t jump = i % 50 == 25 ? 1000 : 0;
+
+  s.axes.xAxis = (int16_t)(i * 3 - 600 + jump);
+  s.axes.yAxis = (int16_t)(-5 * (int16_t)i);
+  s.axes.zAxis = (int16_t)(16384 + (i & 7) * 10);
+  if (chip == MAG)
+  {
+    int16_t x = s.axes.xAxis;
+    s.axes.xAxis = s.axes.yAxis;
+    s.axes.yAxis = x;
+  }
+  s.timestamp = 0xFFFF0000UL + i * 10000UL + (chip == MAG ? 1234 : 0);
+  s.sequence = (uint16_t)(0xFFF0 + i);
+  s.flags = i % 60 == 7 ? SAMPLE_OVERRUN : 0;
+  return s;
+}
+
+static void encode()
+{
+  LSM303CStreamEncoder encoder;
+
+  start[0] = 0;
+  start[1] = encoder.config(0.061f, 0.00058f, stream);
+  for (uint16_t i = 0; i < SAMPLES; i++)
+  {
+    for (uint8_t c = 0; c < 2; c++)
+    {
+      CHIP_t chip = c ? MAG : ACC;
+      uint16_t f = frameOf(chip, i);
+      start[f + 1] = start[f] + encoder.sample(chip, sampleAt(chip, i),
+          stream + start[f]);
+    }
+  }
+}
+
+static bool isKeyframe(uint16_t frame)
+{
+  return start[frame + 1] - start[frame] == STREAM_MAX_ENCODED;
+}
+
+// Feeds one frame's bytes. True if it produced a record, only ever on the
+// delimiter.
+static bool feedFrame(LSM303CStreamDecoder& decoder, const uint8_t* bytes,
+    uint16_t frame, StreamRecord_t& out)
+{
+  bool got = false;
+
+  for (size_t b = start[frame]; b < start[frame + 1]; b++)
+  {
+    if (decoder.feed(bytes[b], out))
+    {
+      CHECK(!got && b == start[frame + 1] - 1);
+      got = true;
+    }
+  }
+  return got;
+}
+
+static bool matches(const StreamRecord_t& r, uint16_t frame)
+{
+  CHIP_t chip = chipOf(frame);
+  AxesSample_t s = sampleAt(chip, sampleOf(frame));
+
+  return r.type == (chip == ACC ? STREAM_ACCEL : STREAM_MAG) &&
+    r.sample.axes.xAxis == s.axes.xAxis &&
+    r.sample.axes.yAxis == s.axes.yAxis &&
+    r.sample.axes.zAxis == s.axes.zAxis &&
+    r.sample.timestamp == s.timestamp && r.sample.sequence == s.sequence &&
+    r.sample.flags == s.flags;
+}
+
+static void testRoundTrip()
+{
+  LSM303CStreamDecoder decoder;
+  StreamRecord_t r;
+  uint16_t deltas = 0;
+
+  CHECK(feedFrame(decoder, stream, 0, r));
+  CHECK(r.type == STREAM_CONFIG);
+  CHECK(decoder.accelSensitivity() == 0.061f);
+  CHECK(decoder.magSensitivity() == 0.00058f);
+
+  for (uint16_t f = 1; f < FRAMES; f++)
+  {
+    CHECK(feedFrame(decoder, stream, f, r) && matches(r, f));
+    deltas += !isKeyframe(f);
+  }
+  CHECK(decoder.errors() == 0);
+  // Deltas actually carry most of the stream
+  CHECK(deltas > FRAMES * 3 / 4);
+}
+
+// Each die starts with a keyframe, sends one when the change doesn't fit a
+// delta and never goes longer than STREAM_KEYFRAME_INTERVAL without one
+static void testKeyframes()
+{
+  for (uint8_t c = 0; c < 2; c++)
+  {
+    CHIP_t chip = c ? MAG : ACC;
+    uint16_t since = 0;
+
+    CHECK(isKeyframe(frameOf(chip, 0)));
+    for (uint16_t i = 0; i < SAMPLES; i++)
+    {
+      since = isKeyframe(frameOf(chip, i)) ? 1 : since + 1;
+      CHECK(since <= STREAM_KEYFRAME_INTERVAL);
+      if (i % 50 == 25 || i % 50 == 26)
+      {
+        CHECK(isKeyframe(frameOf(chip, i)));
+      }
+    }
+  }
+}
+
+// A flipped byte costs that frame, the next frame decodes again, and the
+// corrupted die's deltas are refused until its next keyframe
+static void testCorruption()
+{
+  static uint8_t bad[sizeof(stream)];
+  const uint16_t hit = frameOf(ACC, 5);
+  LSM303CStreamDecoder decoder;
+  StreamRecord_t r;
+  uint32_t lost = 0;
+  bool waiting = false;
+
+  CHECK(!isKeyframe(hit));
+  memcpy(bad, stream, sizeof(bad));
+  bad[start[hit] + 3] ^= 0x40;
+  CHECK(bad[start[hit] + 3] != 0);
+
+  for (uint16_t f = 0; f < FRAMES; f++)
+  {
+    bool got = feedFrame(decoder, bad, f, r);
+
+    if (f == hit)
+    {
+      CHECK(!got);
+      CHECK(decoder.errors() == 1);
+      waiting = true;
+    }
+    else if (waiting && chipOf(f) == ACC && !isKeyframe(f))
+    {
+      CHECK(!got);
+    }
+    else
+    {
+      CHECK(got);
+      if (f > 0)
+      {
+        CHECK(matches(r, f));
+      }
+      if (chipOf(f) == ACC)
+      {
+        waiting = false;
+      }
+    }
+    lost += !got;
+  }
+  CHECK(!waiting);
+  CHECK(lost > 1);
+  CHECK(decoder.errors() == lost);
+}
+
+// A delta with no sample before it, or after a gap, is refused rather than
+// applied to the wrong base
+static void testDeltaWithoutBase()
+{
+  LSM303CStreamDecoder decoder;
+  StreamRecord_t r;
+
+  CHECK(isKeyframe(frameOf(ACC, 0)));
+  CHECK(!isKeyframe(frameOf(ACC, 1)) && !isKeyframe(frameOf(ACC, 2)) &&
+    !isKeyframe(frameOf(ACC, 3)));
+
+  // Joined after the keyframe
+  CHECK(!feedFrame(decoder, stream, frameOf(ACC, 1), r));
+  CHECK(decoder.errors() == 1);
+
+  CHECK(feedFrame(decoder, stream, frameOf(ACC, 0), r));
+  CHECK(matches(r, frameOf(ACC, 0)));
+  // The mag die still has no base of its own
+  CHECK(!feedFrame(decoder, stream, frameOf(MAG, 1), r));
+  CHECK(decoder.errors() == 2);
+
+  // Skipping a sample, and the consecutive delta after the refused one
+  CHECK(!feedFrame(decoder, stream, frameOf(ACC, 2), r));
+  CHECK(!feedFrame(decoder, stream, frameOf(ACC, 3), r));
+  CHECK(decoder.errors() == 4);
+
+  CHECK(feedFrame(decoder, stream, frameOf(ACC, 0), r));
+  CHECK(feedFrame(decoder, stream, frameOf(ACC, 1), r));
+  CHECK(matches(r, frameOf(ACC, 1)));
+  CHECK(decoder.errors() == 4);
+}
+
+int main()
+{
+  encode();
+
+  testRoundTrip();
+  testKeyframes();
+  testCorruption();
+  testDeltaWithoutBase();
+
+  if (failures)
+  {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
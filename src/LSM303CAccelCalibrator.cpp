@@ -0,0 +1,99 @@
+#include "LSM303CAccelCalibrator.h"
+
+void LSM303CAccelCalibrator::reset()
+{
+  for (uint8_t i = 0; i < ACC_CAL_POSITIONS; i++)
+  {
+    sum[i] = 0;
+    count[i] = 0;
+  }
+}
+
+void LSM303CAccelCalibrator::add(ACC_CAL_POSITION_t pos, const AxesRaw_t& raw)
+{
+  const int16_t* axes = &raw.xAxis;
+
+  if (pos >= ACC_CAL_POSITIONS || count[pos] == 0xFFFF)
+  {
+    return;
+  }
+
+  // ACC_CAL_X_UP/X_DOWN -> x, Y_* -> y, Z_* -> z
+  sum[pos] += axes[pos >> 1];
+  count[pos]++;
+}
+
+uint8_t LSM303CAccelCalibrator::positions() const
+{
+  uint8_t bits = 0;
+
+  for (uint8_t i = 0; i < ACC_CAL_POSITIONS; i++)
+  {
+    if (count[i])
+    {
+      bits |= 1 << i;
+    }
+  }
+
+  return bits;
+}
+
+bool LSM303CAccelCalibrator::solve(ACC_FS_t fullScale, int16_t oneG,
+    AccelCalibration_t& cal) const
+{
+  int16_t* offset = &cal.offset.xAxis;
+
+  if (positions() != (1 << ACC_CAL_POSITIONS) - 1 || oneG <= 0)
+  {
+    return false;
+  }
+
+  for (uint8_t axis = 0; axis < 3; axis++)
+  {
+    int32_t up = sum[2 * axis] / count[2 * axis];
+    int32_t down = sum[2 * axis + 1] / count[2 * axis + 1];
+    if (up <= 0 || down >= 0)
+    {
+      return false;
+    }
+
+    offset[axis] = (int16_t)((up + down) / 2);
+    // gain = 2 g / (up - down) in Q14
+    int32_t gain = ((int32_t)oneG << 15) / (up - down);
+    cal.gain[axis] = (int16_t)((gain > 32767) ? 32767 : gain);
+  }
+
+  cal.version = ACC_CAL_VERSION;
+  cal.fullScale = fullScale;
+  cal.reserved = 0;
+  seal(cal);
+  return true;
+}
+
+// CRC-8, polynomial 0x07, over everything but the checksum itself
+uint8_t LSM303CAccelCalibrator::crc8(const AccelCalibration_t& cal)
+{
+  const uint8_t* data = (const uint8_t*)&cal;
+  uint8_t crc = 0;
+
+  for (uint8_t i = 0; i < offsetof(AccelCalibration_t, checksum); i++)
+  {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+  }
+
+  return crc;
+}
+
+void LSM303CAccelCalibrator::seal(AccelCalibration_t& cal)
+{
+  cal.checksum = crc8(cal);
+}
+
+bool LSM303CAccelCalibrator::valid(const AccelCalibration_t& cal)
+{
+  return cal.version == ACC_CAL_VERSION && cal.checksum == crc8(cal);
+}
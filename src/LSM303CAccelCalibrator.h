@@ -0,0 +1,56 @@
+// Six-position accelerometer calibration. Hold the board still with each
+// face up in turn, feed samples for that position, and solve() gives per
+// axis offsets (midpoint of the up/down pair) and gains (1 g over half the
+// up/down span) as a sealed AccelCalibration_t.
+//
+// Plain C++ with no Arduino dependencies, so it also builds on a host.
+#ifndef __LSM303C_ACCEL_CALIBRATOR_H__
+#define __LSM303C_ACCEL_CALIBRATOR_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "LSM303CTypes.h"
+
+#define ACC_CAL_VERSION 1
+
+// Which axis points up (against gravity) while samples are added
+typedef enum
+{
+  ACC_CAL_X_UP,
+  ACC_CAL_X_DOWN,
+  ACC_CAL_Y_UP,
+  ACC_CAL_Y_DOWN,
+  ACC_CAL_Z_UP,
+  ACC_CAL_Z_DOWN,
+  ACC_CAL_POSITIONS
+} ACC_CAL_POSITION_t;
+
+class LSM303CAccelCalibrator
+{
+  public:
+    LSM303CAccelCalibrator() { reset(); }
+
+    void reset(void);
+    void add(ACC_CAL_POSITION_t, const AxesRaw_t&);
+    // Bit n set: position n has samples
+    uint8_t positions(void) const;
+    uint16_t samples(ACC_CAL_POSITION_t pos) const { return count[pos]; }
+
+    // oneG is 1 g in counts at fullScale (16384 at 2 g). False until all
+    // six positions have samples or if a pair doesn't straddle zero.
+    bool solve(ACC_FS_t fullScale, int16_t oneG, AccelCalibration_t&) const;
+
+    // Check a blob read back from storage
+    static bool valid(const AccelCalibration_t&);
+    static void seal(AccelCalibration_t&);
+
+  protected:
+    // Sum of the axis along gravity only, the other two read ~0 in any
+    // position and add nothing to a six-position fit
+    int32_t  sum[ACC_CAL_POSITIONS];
+    uint16_t count[ACC_CAL_POSITIONS];
+
+    static uint8_t crc8(const AccelCalibration_t&);
+};
+
+#endif
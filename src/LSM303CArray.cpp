@@ -0,0 +1,239 @@
+#include "LSM303CArray.h"
+
+status_t LSM303CArray::add(LSM303C& imu)
+{
+  if (count >= maxDevices)
+  {
+    return IMU_OUT_OF_BOUNDS;
+  }
+
+  devices[count] = &imu;
+  slots[count].fresh = 0;
+  slots[count].errors = 0;
+  count++;
+
+  return IMU_SUCCESS;
+}
+
+status_t LSM303CArray::setSchedule(ARRAY_SCHEDULE_t s)
+{
+  status_t ret = IMU_SUCCESS;
+  uint8_t drdy = (s == ARRAY_DATA_READY) ? ACC_INT_XL_DRDY : 0;
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    LSM303C& imu = *devices[i];
+    AxesRaw_t discard;
+
+    if (imu.ACC_UpdateReg(ACC_CTRL3, ACC_INT_XL_DRDY, drdy))
+    {
+      ret = IMU_HW_ERROR;
+      continue;
+    }
+
+    // Clear any waiting sample so the first rising edge actually arrives
+    noInterrupts();
+    imu.accelIrqPending = 0;
+    imu.magIrqPending = 0;
+    interrupts();
+    if (imu.ACC_GetAccRaw(discard) || imu.MAG_GetMagRaw(discard))
+    {
+      ret = IMU_HW_ERROR;
+    }
+  }
+
+  schedule = s;
+  return ret;
+}
+
+status_t LSM303CArray::poll()
+{
+  status_t ret = IMU_SUCCESS;
+  bool retry = ++pass % LSM303C_ARRAY_RETRY_PASSES == 0;
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    LSM303C& imu = *devices[i];
+    LSM303CArraySlot_t& slot = slots[i];
+    uint32_t before = imu.accelCounters.samples + imu.magCounters.samples;
+
+    if (!online(i) && !retry)
+    {
+      continue;
+    }
+    if (pollDevice(imu, slot) != IMU_SUCCESS)
+    {
+      ret = IMU_HW_ERROR;
+      countError(i);
+      continue;
+    }
+    // Only new data proves a device is alive: with data-ready scheduling a
+    // dead one polls fine, it just never has anything
+    if (imu.accelCounters.samples + imu.magCounters.samples != before)
+    {
+      slot.errors = 0;
+      if (!collecting)
+      {
+        collecting = true;
+        frameStart = micros();
+      }
+    }
+  }
+
+  return ret;
+}
+
+void LSM303CArray::countError(uint8_t i)
+{
+  if (slots[i].errors < 255)
+  {
+    slots[i].errors++;
+  }
+  if (!online(i))
+  {
+    // Whatever it had is stale by the time it comes back
+    slots[i].fresh = 0;
+  }
+}
+
+uint8_t LSM303CArray::onlineCount() const
+{
+  uint8_t n = 0;
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    n += online(i);
+  }
+
+  return n;
+}
+
+// At most one burst per die
+status_t LSM303CArray::pollDevice(LSM303C& imu, LSM303CArraySlot_t& slot)
+{
+  AxesSample_t sample;
+  uint8_t status;
+  uint8_t pending;
+
+  if (schedule == ARRAY_DATA_READY)
+  {
+    // The ISR already said there is data, skip the status register (no
+    // overrun flags in this mode)
+    noInterrupts();
+    pending = imu.accelIrqPending;
+    sample.timestamp = imu.accelIrqTime;
+    imu.accelIrqPending = 0;
+    interrupts();
+    if (pending)
+    {
+      if (imu.ACC_GetAccRaw(sample.axes))
+      {
+        debug_println(AERROR);
+        return IMU_HW_ERROR;
+      }
+      imu.stampSample(sample, imu.accelCounters,
+          imu.countSample(imu.accelCounters, false));
+      slot.accel = sample;
+      slot.fresh |= LSM303C_FRESH_ACCEL;
+    }
+
+    noInterrupts();
+    pending = imu.magIrqPending;
+    sample.timestamp = imu.magIrqTime;
+    imu.magIrqPending = 0;
+    interrupts();
+    if (pending)
+    {
+      if (imu.MAG_GetMagRaw(sample.axes))
+      {
+        debug_println(MERROR);
+        return IMU_HW_ERROR;
+      }
+      imu.stampSample(sample, imu.magCounters,
+          imu.countSample(imu.magCounters, false));
+      slot.mag = sample;
+      slot.fresh |= LSM303C_FRESH_MAG;
+    }
+
+    return IMU_SUCCESS;
+  }
+
+  // Round robin: status and data come back in the same burst
+  sample.timestamp = micros();
+  if (imu.ACC_GetAccRawStatus(sample.axes, status))
+  {
+    debug_println(AERROR);
+    return IMU_HW_ERROR;
+  }
+  if (status & ACC_ZYX_NEW_DATA_AVAILABLE)
+  {
+    imu.stampSample(sample, imu.accelCounters,
+        imu.countSample(imu.accelCounters, status & ACC_ZYX_OVERRUN));
+    slot.accel = sample;
+    slot.fresh |= LSM303C_FRESH_ACCEL;
+  }
+
+  sample.timestamp = micros();
+  if (imu.MAG_GetMagRawStatus(sample.axes, status))
+  {
+    debug_println(MERROR);
+    return IMU_HW_ERROR;
+  }
+  if (status & MAG_XYZDA_YES)
+  {
+    imu.stampSample(sample, imu.magCounters,
+        imu.countSample(imu.magCounters, status & MAG_ZYXOR_YES));
+    slot.mag = sample;
+    slot.fresh |= LSM303C_FRESH_MAG;
+  }
+
+  return IMU_SUCCESS;
+}
+
+bool LSM303CArray::frameReady() const
+{
+  bool any = false;
+  bool complete = true;
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (!online(i))
+    {
+      continue;
+    }
+    any = true;
+    if ((slots[i].fresh & frameMask) != frameMask)
+    {
+      complete = false;
+    }
+  }
+
+  if (!any)
+  {
+    return false;
+  }
+  return complete ||
+    (collecting && frameTimeout && micros() - frameStart >= frameTimeout);
+}
+
+bool LSM303CArray::readFrame(LSM303CArraySlot_t* out)
+{
+  if (!frameReady())
+  {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    // Held up by the timeout: a miss counts against the device
+    if (online(i) && (slots[i].fresh & frameMask) != frameMask)
+    {
+      countError(i);
+    }
+    out[i] = slots[i];
+    slots[i].fresh = 0;
+  }
+  collecting = false;
+
+  return true;
+}
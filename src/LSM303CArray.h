@@ -0,0 +1,113 @@
+// Runs several LSM303C breakouts (separate chip selects or bus segments) as
+// one sensor. poll() makes one pass over the devices, reading only the dies
+// that have something new, and a frame is published once every working
+// device has delivered a fresh sample. Each device keeps its own timestamps.
+// A device that keeps failing or missing frames is taken out of the frame
+// and only retried now and then, so it can't hold up or slow down the others.
+#ifndef __LSM303C_ARRAY_H__
+#define __LSM303C_ARRAY_H__
+
+#include "SparkFunLSM303C.h"
+
+// LSM303CArraySlot_t::fresh bits
+#define LSM303C_FRESH_ACCEL 0x01
+#define LSM303C_FRESH_MAG   0x02
+
+// Failed polls and missed frames before a device is left out of frames
+#define LSM303C_ARRAY_FAIL_LIMIT 3
+// Passes between retries of a device that is out
+#define LSM303C_ARRAY_RETRY_PASSES 32
+// A frame goes out incomplete this long after its first fresh sample
+#define LSM303C_ARRAY_FRAME_TIMEOUT_US 250000UL
+
+typedef enum
+{
+  // Read status + data from every device on each pass
+  ARRAY_ROUND_ROBIN,
+  // Only read dies whose data-ready ISR has fired since the last pass. Call
+  // each device's accelDataReadyISR()/magDataReadyISR() from the handlers.
+  ARRAY_DATA_READY
+} ARRAY_SCHEDULE_t;
+
+// One device's part of a frame
+typedef struct
+{
+  AxesSample_t accel;
+  AxesSample_t mag;
+  uint8_t fresh;  // LSM303C_FRESH_* bits updated since the last frame
+  uint8_t errors; // Failed polls and missed frames since the last fresh
+                  // sample, saturates at 255
+} LSM303CArraySlot_t;
+
+class LSM303CArray
+{
+  public:
+    LSM303CArray(LSM303C** deviceStorage, LSM303CArraySlot_t* slotStorage,
+        uint8_t capacity)
+      : devices(deviceStorage), slots(slotStorage), maxDevices(capacity) { }
+
+    // Devices must already be begun. IMU_OUT_OF_BOUNDS when the array is full
+    status_t add(LSM303C&);
+    uint8_t  size(void) const { return count; }
+
+    // ARRAY_DATA_READY routes data-ready to INT_XL on every device
+    status_t setSchedule(ARRAY_SCHEDULE_t);
+    // Which LSM303C_FRESH_* bits every device needs before a frame is
+    // published (accelerometer only by default, the mag runs much slower)
+    void     setFrameMask(uint8_t mask) { frameMask = mask; }
+    // Failed polls and missed frames in a row before a device is out (at
+    // least 1)
+    void     setFailLimit(uint8_t limit) { failLimit = limit ? limit : 1; }
+    // How long a frame waits for its slowest device after the first fresh
+    // sample arrived, 0 to wait forever. Should cover a few sample periods.
+    void     setFrameTimeout(uint32_t us) { frameTimeout = us; }
+
+    // One pass over all devices. Keeps going past a failing device, but
+    // reports IMU_HW_ERROR. A device that is out is only tried every
+    // LSM303C_ARRAY_RETRY_PASSES passes, and a fresh sample brings it back.
+    status_t poll(void);
+
+    // Whether device i (in add() order) is still taking part in frames
+    bool    online(uint8_t i) const { return slots[i].errors < failLimit; }
+    uint8_t onlineCount(void) const;
+
+    // Every online device has the frame mask fresh, or the frame timeout
+    // ran out. Never true while all devices are out.
+    bool frameReady(void) const;
+    // Copies out one slot per device and starts collecting the next frame.
+    // Check fresh: a frame released by the timeout lacks the late devices,
+    // and each one it lacks counts a miss. Slots of devices that are out
+    // come back with fresh == 0 and their error count. Returns false if
+    // the frame isn't ready yet.
+    bool readFrame(LSM303CArraySlot_t*);
+
+  protected:
+    LSM303C** const devices;
+    LSM303CArraySlot_t* const slots;
+    const uint8_t maxDevices;
+    uint8_t count = 0;
+    ARRAY_SCHEDULE_t schedule = ARRAY_ROUND_ROBIN;
+    uint8_t frameMask = LSM303C_FRESH_ACCEL;
+    uint8_t failLimit = LSM303C_ARRAY_FAIL_LIMIT;
+    uint8_t pass = 0;
+    uint32_t frameTimeout = LSM303C_ARRAY_FRAME_TIMEOUT_US;
+    uint32_t frameStart = 0;
+    bool collecting = false; // Some fresh sample since the last frame
+
+    status_t pollDevice(LSM303C&, LSM303CArraySlot_t&);
+    void     countError(uint8_t);
+};
+
+// Array that owns its bookkeeping: LSM303CArrayOf<4> sensors;
+template <uint8_t N>
+class LSM303CArrayOf : public LSM303CArray
+{
+  public:
+    LSM303CArrayOf() : LSM303CArray(deviceStorage, slotStorage, N) { }
+
+  private:
+    LSM303C* deviceStorage[N];
+    LSM303CArraySlot_t slotStorage[N];
+};
+
+#endif
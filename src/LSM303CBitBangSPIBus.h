@@ -0,0 +1,209 @@
+// Half-duplex 3-wire SPI bit-banged on plain AVR port pins.
+//
+// The pins are template parameters, so every port access is a constant
+// address and avr-gcc turns each one into a single sbi/cbi/sbis, and each
+// byte is clocked by straight-line code instead of a counted loop. Any number
+// of sensors can be bit-banged, one instantiation per set of pins.
+#ifndef __LSM303C_BITBANG_SPI_BUS_H__
+#define __LSM303C_BITBANG_SPI_BUS_H__
+
+#include "LSM303CBus.h"
+
+// The bit-banged SPI transport drives AVR port registers directly
+#if defined(PORTB)
+#define LSM303C_HAS_BITBANG_SPI 1
+
+// Declares a pin for LSM303CBitBangSPI, e.g. LSM303C_AVR_PIN(MyCS, D, 4) for
+// PD4 (D4 on an Uno). Port registers can't be template arguments themselves,
+// so they are wrapped in static functions instead.
+#define LSM303C_AVR_PIN(name, port, bit) \
+  struct name \
+  { \
+    static inline void high(void)   { PORT##port |= _BV(bit); } \
+    static inline void low(void)    { PORT##port &= ~_BV(bit); } \
+    static inline bool read(void)   { return PIN##port & _BV(bit); } \
+    static inline void output(void) { DDR##port |= _BV(bit); } \
+    static inline void input(void)  { DDR##port &= ~_BV(bit); } \
+  }
+
+template<class CS_MAG, class CS_XL, class CLK, class DATA>
+class LSM303CBitBangSPI : public LSM303CBus
+{
+  public:
+    status_t begin(void)
+    {
+      debug_println("Setting up SPI");
+      // CS & CLK must be outputs
+      CS_MAG::output();
+      CS_XL::output();
+      CLK::output();
+      // Deselect SPI chips
+      CS_MAG::high();
+      CS_XL::high();
+      // Clock polarity (CPOL) = 1
+      CLK::high();
+
+      return IMU_SUCCESS;
+    }
+
+    InterfaceMode_t mode(void) const { return MODE_SPI; }
+
+    // Clocks out the address once, then keeps clocking in bytes while the
+    // chip auto-increments the register address.
+    status_t readRegs(CHIP_t chip, uint8_t reg, uint8_t* data, uint8_t len)
+    {
+      debug_print("Reading register 0x");
+      debug_printlns(reg, HEX);
+
+      if (chip == MAG && len > 1)
+      {
+        reg |= MAG_SPI_AUTO_INCREMENT;
+      }
+
+      DATA::output();
+      noInterrupts();
+      select(chip);
+
+      // Set the read/write bit (bit 7) to do a read
+      sendByte(reg | _BV(7));
+
+      // Switch data pin to input, the chip drives it from here on
+      DATA::input();
+      while (len--)
+      {
+        *data++ = receiveByte();
+      }
+
+      deselect();
+      interrupts();
+
+      return IMU_SUCCESS;
+    }
+
+    // Clocks out the address once followed by every data byte; the chip
+    // auto-increments the register address between bytes.
+    status_t writeRegs(CHIP_t chip, uint8_t reg, const uint8_t* data,
+        uint8_t len)
+    {
+      debug_print("Writing ");
+      debug_prints(len);
+      debug_prints(" byte(s) to register 0x");
+      debug_printlns(reg, HEX);
+
+      if (chip == MAG && len > 1)
+      {
+        reg |= MAG_SPI_AUTO_INCREMENT;
+      }
+
+      DATA::output();
+      noInterrupts();
+      select(chip);
+
+      // Clear the read/write bit (bit 7) to do a write
+      sendByte(reg & ~_BV(7));
+      while (len--)
+      {
+        sendByte(*data++);
+      }
+
+      deselect();
+      interrupts();
+      DATA::input();
+
+      // Is there a way to verify true success?
+      return IMU_SUCCESS;
+    }
+
+  protected:
+    // Select the chip & deselect the other
+    static inline void select(CHIP_t chip)
+    {
+      if (chip == MAG)
+      {
+        CS_XL::high();
+        CS_MAG::low();
+      }
+      else
+      {
+        CS_MAG::high();
+        CS_XL::low();
+      }
+    }
+
+    static inline void deselect(void)
+    {
+      CS_MAG::high();
+      CS_XL::high();
+    }
+
+    // Data is setup, then the chip latches it on the rising clock edge
+    template<uint8_t MASK>
+    static inline void sendBit(uint8_t value)
+    {
+      if (value & MASK)
+      {
+        DATA::high();
+      }
+      else
+      {
+        DATA::low();
+      }
+      CLK::low();
+      CLK::high();
+    }
+
+    // The chip shifts out on the falling edge, sample after the rising one
+    template<uint8_t MASK>
+    static inline void receiveBit(uint8_t& value)
+    {
+      CLK::low();
+      CLK::high();
+      if (DATA::read())
+      {
+        value |= MASK;
+      }
+    }
+
+    static inline void sendByte(uint8_t value)
+    {
+      sendBit<0x80>(value);
+      sendBit<0x40>(value);
+      sendBit<0x20>(value);
+      sendBit<0x10>(value);
+      sendBit<0x08>(value);
+      sendBit<0x04>(value);
+      sendBit<0x02>(value);
+      sendBit<0x01>(value);
+    }
+
+    static inline uint8_t receiveByte(void)
+    {
+      uint8_t value = 0;
+      receiveBit<0x80>(value);
+      receiveBit<0x40>(value);
+      receiveBit<0x20>(value);
+      receiveBit<0x10>(value);
+      receiveBit<0x08>(value);
+      receiveBit<0x04>(value);
+      receiveBit<0x02>(value);
+      receiveBit<0x01>(value);
+      return value;
+    }
+};
+
+// Default SPI pins (Pro Mini), used by LSM303C::begin(MODE_SPI, ...)
+//  D10 -> SDI/SDO
+//  D11 -> SCLK
+//  D12 -> CS_XL
+//  D13 -> CS_MAG
+LSM303C_AVR_PIN(LSM303CProMiniCSMag, B, 5);
+LSM303C_AVR_PIN(LSM303CProMiniCSXL,  B, 4);
+LSM303C_AVR_PIN(LSM303CProMiniCLK,   B, 3);
+LSM303C_AVR_PIN(LSM303CProMiniData,  B, 2);
+
+typedef LSM303CBitBangSPI<LSM303CProMiniCSMag, LSM303CProMiniCSXL,
+    LSM303CProMiniCLK, LSM303CProMiniData> LSM303CBitBangSPIBus;
+
+#endif
+
+#endif
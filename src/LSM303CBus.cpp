@@ -0,0 +1,216 @@
+#include "LSM303CBus.h"
+#include "stdint.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////// I2C
+
+status_t LSM303CI2CBus::begin()
+{
+#ifdef WIRE_HAS_TIMEOUT
+  // Reset the TWI hardware on a timeout so the next transfer can go
+  wire.setWireTimeout(timeoutUs, true);
+  wire.clearWireTimeoutFlag();
+#endif
+  return IMU_SUCCESS;
+}
+
+// Either Wire gave up on the transfer or it ran past the deadline anyway
+bool LSM303CI2CBus::timedOut(uint32_t start)
+{
+#ifdef WIRE_HAS_TIMEOUT
+  if (wire.getWireTimeoutFlag())
+  {
+    wire.clearWireTimeoutFlag();
+    return true;
+  }
+#endif
+  return timeoutUs && micros() - start > timeoutUs;
+}
+
+status_t LSM303CI2CBus::readRegs(CHIP_t chip, uint8_t reg, uint8_t* data,
+    uint8_t len)
+{
+  status_t ret = startRead(chip, reg, len);
+
+  if (ret != IMU_SUCCESS)
+  {
+    return ret;
+  }
+  return finishRead(data, len);
+}
+
+// Address phase: sends the register address and leaves the bus waiting for
+// the repeated start that finishRead() issues
+status_t LSM303CI2CBus::startRead(CHIP_t chip, uint8_t reg, uint8_t len)
+{
+  uint8_t slaveAddress = (chip == MAG) ? MAG_I2C_ADDR : ACC_I2C_ADDR;
+  uint32_t start = micros();
+  uint8_t code;
+
+  if (chip == MAG && len > 1)
+  {
+    reg |= MAG_I2C_AUTO_INCREMENT;
+  }
+
+  debug_print("Reading from I2C address: 0x");
+  debug_prints(slaveAddress, HEX);
+  debug_prints(", register 0x");
+  debug_printlns(reg, HEX);
+  wire.beginTransmission(slaveAddress); // Initialize the Tx buffer
+  if (!wire.write(reg))  // Put slave register address in Tx buff
+  {
+    debug_println("Error: couldn't send slave register address");
+    noteFault(BUS_FAULT_TOO_LONG);
+    return IMU_GENERIC_ERROR;
+  }
+  code = wire.endTransmission(false);  // Send Tx, send restart to keep alive
+  if (code == BUS_FAULT_TIMEOUT || timedOut(start))
+  {
+    noteFault(BUS_FAULT_TIMEOUT);
+    return IMU_TIMEOUT;
+  }
+  if (code)
+  {
+    noteFault(code);
+    debug_println("Error: I2C buffer didn't get sent!");
+    debug_print("Slave address: 0x");
+    debug_printlns(slaveAddress, HEX);
+    debug_print("Register: 0x");
+    debug_printlns(reg, HEX);
+    return IMU_HW_ERROR;
+  }
+
+  pendingAddress = slaveAddress;
+  return IMU_SUCCESS;
+}
+
+// Data phase: clocks in len bytes from the address set up by startRead()
+status_t LSM303CI2CBus::finishRead(uint8_t* data, uint8_t len)
+{
+  uint32_t start = micros();
+  uint8_t received = wire.requestFrom(pendingAddress, len);
+
+  if (timedOut(start))
+  {
+    // Whatever came in may be garbage
+    while (wire.available())
+    {
+      wire.read();
+    }
+    noteFault(BUS_FAULT_TIMEOUT);
+    return IMU_TIMEOUT;
+  }
+  if (received != len)
+  {
+    debug_println("IMU_HW_ERROR");
+    noteFault(BUS_FAULT_SHORT_READ);
+    return IMU_HW_ERROR;
+  }
+
+  for (uint8_t i = 0; i < len; i++)
+  {
+    data[i] = wire.read();
+  }
+  debug_print("Read: 0x");
+  debug_printlns(data[0], HEX);
+  return IMU_SUCCESS;
+}
+
+status_t LSM303CI2CBus::writeRegs(CHIP_t chip, uint8_t reg,
+    const uint8_t* data, uint8_t len)
+{
+  uint8_t slaveAddress = (chip == MAG) ? MAG_I2C_ADDR : ACC_I2C_ADDR;
+  uint32_t start = micros();
+
+  if (chip == MAG && len > 1)
+  {
+    reg |= MAG_I2C_AUTO_INCREMENT;
+  }
+
+  wire.beginTransmission(slaveAddress);  // Initialize the Tx buffer
+  // returns num bytes written
+  if (wire.write(reg) != 1 || wire.write(data, len) != len)
+  {
+    noteFault(BUS_FAULT_TOO_LONG);
+    return IMU_HW_ERROR;
+  }
+
+  debug_print("Wrote: 0x");
+  debug_printlns(data[0], HEX);
+  uint8_t code = wire.endTransmission();
+  if (code == BUS_FAULT_TIMEOUT || timedOut(start))
+  {
+    noteFault(BUS_FAULT_TIMEOUT);
+    return IMU_TIMEOUT;
+  }
+  switch (code)
+  {
+  case 0:
+    return IMU_SUCCESS;
+  case 1: // Data too long to fit in transmit buffer
+  case 2: // Received NACK on transmit of address
+  case 3: // Received NACK on transmit of data
+  case 4: // Other Error
+  default:
+    noteFault(code);
+    return IMU_HW_ERROR;
+  }
+}
+
+// Half a 100 kHz clock period, slow enough for any slave
+#define RECOVERY_HALF_CLOCK_US 5
+
+// Open-drain by hand: drive low, or let the pull-up take the line high
+static void releaseLine(uint8_t pin)
+{
+  pinMode(pin, INPUT_PULLUP);
+  delayMicroseconds(RECOVERY_HALF_CLOCK_US);
+}
+
+static void pullLine(uint8_t pin)
+{
+  digitalWrite(pin, LOW);
+  pinMode(pin, OUTPUT);
+  delayMicroseconds(RECOVERY_HALF_CLOCK_US);
+}
+
+// A slave cut off mid-read keeps SDA low waiting for clocks. Up to nine
+// clocks finish its byte, then a STOP returns it to idle.
+status_t LSM303CI2CBus::recover()
+{
+  status_t ret = IMU_SUCCESS;
+
+  debug_println(EMPTY);
+  wire.end();
+
+  if (sdaPin != LSM303C_NO_PIN && sclPin != LSM303C_NO_PIN)
+  {
+    releaseLine(sdaPin);
+    releaseLine(sclPin);
+
+    for (uint8_t i = 0; i < 9 && !digitalRead(sdaPin); i++)
+    {
+      pullLine(sclPin);
+      releaseLine(sclPin);
+    }
+
+    // STOP: SDA rises while SCL is high
+    pullLine(sclPin);
+    pullLine(sdaPin);
+    releaseLine(sclPin);
+    releaseLine(sdaPin);
+
+    if (!digitalRead(sdaPin) || !digitalRead(sclPin))
+    {
+      ret = IMU_HW_ERROR; // Still held, needs a power cycle
+    }
+  }
+
+  wire.begin();
+  if (clock)
+  {
+    wire.setClock(clock);
+  }
+  begin();
+  return ret;
+}
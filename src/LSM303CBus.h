@@ -0,0 +1,125 @@
+// Bus transports for the LSM303C. The driver only ever talks to the chip
+// through LSM303CBus, so other backends (hardware SPI, a mock, ...) can be
+// plugged in without touching the register logic.
+#ifndef __LSM303C_BUS_H__
+#define __LSM303C_BUS_H__
+
+#include "Wire.h"
+#include "SparkFunIMU.h"
+#include "LSM303CTypes.h"
+#include "LSM303CBusStats.h"
+#include "DebugMacros.h"
+
+// The magnetometer only auto-increments the register address on multi-byte
+// transfers when this bit is set in the sub-address. The accelerometer
+// increments on its own while IF_ADD_INC in ACC_CTRL4 is set (default).
+#define MAG_I2C_AUTO_INCREMENT 0x80
+#define MAG_SPI_AUTO_INCREMENT 0x40
+
+// Default deadline for one I2C transfer phase, see LSM303CI2CBus::setTimeout()
+#define LSM303C_I2C_TIMEOUT_US 10000
+
+// No pin / pin not known, e.g. for LSM303CI2CBus::setRecoveryPins()
+#define LSM303C_NO_PIN 0xFF
+
+class LSM303CBus
+{
+  public:
+    // Pin and peripheral setup, called from LSM303C::begin()
+    virtual status_t begin(void) { return IMU_SUCCESS; }
+    virtual InterfaceMode_t mode(void) const = 0;
+
+    // len consecutive registers starting at reg, using the chip's address
+    // auto-increment
+    virtual status_t readRegs(CHIP_t, uint8_t, uint8_t*, uint8_t) = 0;
+    virtual status_t writeRegs(CHIP_t, uint8_t, const uint8_t*, uint8_t) = 0;
+
+    virtual status_t readReg(CHIP_t chip, uint8_t reg, uint8_t& data)
+    {
+      return readRegs(chip, reg, &data, 1);
+    }
+    virtual status_t writeReg(CHIP_t chip, uint8_t reg, uint8_t data)
+    {
+      return writeRegs(chip, reg, &data, 1);
+    }
+
+    // Split-phase read for LSM303C::pollSampleRead(): startRead() addresses
+    // the register, finishRead() collects the bytes, and the sketch gets
+    // control back in between. Transports that can't split a transfer do it
+    // all in finishRead().
+    virtual status_t startRead(CHIP_t chip, uint8_t reg, uint8_t)
+    {
+      splitChip = chip;
+      splitReg = reg;
+      return IMU_SUCCESS;
+    }
+    virtual status_t finishRead(uint8_t* data, uint8_t len)
+    {
+      return readRegs(splitChip, splitReg, data, len);
+    }
+
+    // Gets a hung bus going again after an IMU_TIMEOUT. The chip's
+    // registers are LSM303C::recoverBus()'s business.
+    virtual status_t recover(void) { return IMU_NOT_SUPPORTED; }
+
+    virtual ~LSM303CBus() { }
+
+    // Where the transport files the cause of its failures
+    void attachStats(LSM303CBusStats* s) { stats = s; }
+
+  protected:
+    CHIP_t  splitChip = ACC;
+    uint8_t splitReg = 0;
+
+    LSM303CBusStats* stats = NULL;
+    void noteFault(uint8_t code) { if (stats) stats->fault(code); }
+};
+
+// I2C through any TwoWire instance. Wire.begin() stays in the sketch's setup()
+class LSM303CI2CBus : public LSM303CBus
+{
+  public:
+    LSM303CI2CBus(TwoWire& wirePort = Wire) : wire(wirePort) { }
+
+    status_t begin(void);
+    InterfaceMode_t mode(void) const { return MODE_I2C; }
+    status_t readRegs(CHIP_t, uint8_t, uint8_t*, uint8_t);
+    status_t writeRegs(CHIP_t, uint8_t, const uint8_t*, uint8_t);
+    // Nothing else may use the Wire port between these two, the bus is
+    // held for the repeated start
+    status_t startRead(CHIP_t, uint8_t, uint8_t);
+    status_t finishRead(uint8_t*, uint8_t);
+
+    // Deadline for each transfer phase, 0 to wait as long as Wire does.
+    // Where the core has WIRE_HAS_TIMEOUT, Wire aborts a hung transfer at
+    // the deadline (the setting applies to the whole Wire port); elsewhere a
+    // transfer that overran is only reported once it returns. Either way
+    // it comes back as IMU_TIMEOUT. Takes effect at begin().
+    void setTimeout(uint32_t us) { timeoutUs = us; }
+    // Pins for recover(). Defaults to the board's Wire pins where the core
+    // names them.
+    void setRecoveryPins(uint8_t sda, uint8_t scl) { sdaPin = sda; sclPin = scl; }
+    // Clock recover() restarts Wire at, normally what setup() passed to
+    // Wire.setClock(). 0 (the default) leaves whatever Wire.begin() sets.
+    void setRecoveryClock(uint32_t hz) { clock = hz; }
+    // Clocks SCL until a slave stuck mid-byte lets go of SDA, sends a STOP
+    // and restarts Wire
+    status_t recover(void);
+
+  protected:
+    TwoWire& wire;
+    uint8_t pendingAddress = ACC_I2C_ADDR;
+    uint32_t timeoutUs = LSM303C_I2C_TIMEOUT_US;
+#if defined(PIN_WIRE_SDA) && defined(PIN_WIRE_SCL)
+    uint8_t sdaPin = PIN_WIRE_SDA;
+    uint8_t sclPin = PIN_WIRE_SCL;
+#else
+    uint8_t sdaPin = LSM303C_NO_PIN;
+    uint8_t sclPin = LSM303C_NO_PIN;
+#endif
+    uint32_t clock = 0;
+
+    bool timedOut(uint32_t start);
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "LSM303CBusStats.h"
+#include <string.h>
+
+void LSM303CBusStats::reset()
+{
+  memset(ops, 0, sizeof(ops));
+  memset(faultCount, 0, sizeof(faultCount));
+}
+
+void LSM303CBusStats::record(CHIP_t chip, BUS_OP_t dir, uint8_t bytes,
+    uint32_t us, status_t result)
+{
+  BusOpStats_t& s = ops[chip][dir];
+  uint8_t bucket = 0;
+
+  s.transfers++;
+  s.bytes += bytes;
+  if (result != IMU_SUCCESS && s.errors < 0xFFFF)
+  {
+    s.errors++;
+  }
+  if (us > s.maxMicros)
+  {
+    s.maxMicros = us > 0xFFFF ? 0xFFFF : us;
+  }
+
+  for (uint32_t limit = BUS_HIST_FIRST_US;
+      us >= limit && bucket < BUS_HIST_BUCKETS - 1; limit <<= 1)
+  {
+    bucket++;
+  }
+  if (s.histogram[bucket] < 0xFFFF)
+  {
+    s.histogram[bucket]++;
+  }
+}
+
+void LSM303CBusStats::fault(uint8_t code)
+{
+  if (!code || code >= BUS_FAULT_COUNT)
+  {
+    code = BUS_FAULT_OTHER;
+  }
+  if (faultCount[code] < 0xFFFF)
+  {
+    faultCount[code]++;
+  }
+}
+
+void LSM303CBusStats::report(Print& out) const
+{
+  static const char DIE[] = "MA";
+  static const char* const DIR[BUS_OP_COUNT] = {" rd ", " wr "};
+
+  for (uint8_t chip = 0; chip < 2; chip++)
+  {
+    for (uint8_t dir = 0; dir < BUS_OP_COUNT; dir++)
+    {
+      const BusOpStats_t& s = ops[chip][dir];
+
+      out.print(DIE[chip]);
+      out.print(DIR[dir]);
+      out.print(s.transfers);
+      out.print(' ');
+      out.print(s.bytes);
+      out.print(' ');
+      out.print(s.errors);
+      out.print(' ');
+      out.print(s.maxMicros);
+      out.print(" |");
+      for (uint8_t i = 0; i < BUS_HIST_BUCKETS; i++)
+      {
+        out.print(' ');
+        out.print(s.histogram[i]);
+      }
+      out.println();
+    }
+  }
+
+  out.print("faults");
+  for (uint8_t i = 1; i < BUS_FAULT_COUNT; i++)
+  {
+    out.print(' ');
+    out.print(faultCount[i]);
+  }
+  out.println();
+}
@@ -0,0 +1,83 @@
+// Bus instrumentation: transfers, bytes, errors and latency histograms per
+// die and direction, plus the I2C failure codes behind the errors.
+//
+// Compiled out unless the library is built with LSM303C_INSTRUMENTATION=1
+// (a compiler flag, -DLSM303C_INSTRUMENTATION=1), in which case every
+// register access of an LSM303C given one of these with setBusStats() is
+// timed with micros() and filed here. With it at 0 the driver makes no
+// timing calls at all. Only the library's .cpp files look at the setting,
+// so the classes have the same layout either way and a sketch built
+// without the flag still links against an instrumented library.
+#ifndef __LSM303C_BUS_STATS_H__
+#define __LSM303C_BUS_STATS_H__
+
+#include "SparkFunIMU.h"
+#include "LSM303CTypes.h"
+
+#ifndef LSM303C_INSTRUMENTATION
+#define LSM303C_INSTRUMENTATION 0
+#endif
+
+// Bucket n counts transfers under 32 << n microseconds, the last one
+// everything slower
+#define BUS_HIST_BUCKETS 8
+#define BUS_HIST_FIRST_US 32
+
+typedef enum
+{
+  BUS_OP_READ,
+  BUS_OP_WRITE,
+  BUS_OP_COUNT
+} BUS_OP_t;
+
+// Why a transfer failed. 1-5 are the Wire endTransmission() codes.
+typedef enum
+{
+  BUS_FAULT_TOO_LONG   = 1, // Data too long for the transmit buffer
+  BUS_FAULT_NACK_ADDR  = 2, // NACK on the slave address
+  BUS_FAULT_NACK_DATA  = 3, // NACK on a data byte
+  BUS_FAULT_OTHER      = 4,
+  BUS_FAULT_TIMEOUT    = 5,
+  BUS_FAULT_SHORT_READ = 6, // requestFrom() came back with fewer bytes
+  BUS_FAULT_COUNT
+} BUS_FAULT_t;
+
+typedef struct
+{
+  uint32_t transfers;
+  uint32_t bytes;
+  uint16_t errors;
+  uint16_t maxMicros;
+  uint16_t histogram[BUS_HIST_BUCKETS]; // Saturate at 65535
+} BusOpStats_t;
+
+class LSM303CBusStats
+{
+  public:
+    LSM303CBusStats() { reset(); }
+
+    void reset(void);
+
+    // One finished transfer, successful or not
+    void record(CHIP_t, BUS_OP_t, uint8_t bytes, uint32_t us, status_t);
+    // Cause of a failure, from the transport. Unknown codes count as OTHER.
+    void fault(uint8_t);
+
+    const BusOpStats_t& op(CHIP_t chip, BUS_OP_t dir) const
+    {
+      return ops[chip][dir];
+    }
+    uint16_t faults(BUS_FAULT_t f) const { return faultCount[f]; }
+
+    // One line per die and direction:
+    //  A rd 1200 8400 0 312 | 0 0 4 1196 0 0 0 0
+    // die, direction, transfers, bytes, errors, slowest us | histogram,
+    // then the fault counts by BUS_FAULT_t
+    void report(Print&) const;
+
+  protected:
+    BusOpStats_t ops[2][BUS_OP_COUNT]; // [CHIP_t][BUS_OP_t]
+    uint16_t faultCount[BUS_FAULT_COUNT];
+};
+
+#endif
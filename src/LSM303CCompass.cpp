@@ -0,0 +1,162 @@
+#include "LSM303CCompass.h"
+
+// CORDIC works with 16 extra fractional angle bits: 2^20 counts per turn
+#define CORDIC_ANGLE_SHIFT 4
+#define CORDIC_HALF_TURN   (1L << 19)
+#define CORDIC_QUARTER     (1L << 18)
+#define CORDIC_STEPS       16
+
+// Raw samples are moved up by this much so the shifts in late iterations
+// still have bits to work with (int16 << 12 plus the CORDIC gain < 2^30)
+#define CORDIC_INPUT_SHIFT 12
+
+// atan(2^-i) in 2^20 counts per turn
+static const int32_t CORDIC_ATAN[CORDIC_STEPS] =
+{
+  131072, 77376, 40884, 20753, 10417, 5213, 2607, 1304,
+  652, 326, 163, 81, 41, 20, 10, 5
+};
+
+// Multiply by 1/K = 0.607253 (the CORDIC gain) with shifts only, so large
+// intermediates can't overflow 32 bits. Within 1e-4 of the exact value.
+static inline int32_t removeGain(int32_t v)
+{
+  return (v >> 1) + (v >> 3) - (v >> 6) - (v >> 9) - (v >> 13);
+}
+
+void LSM303CCompass::rotate(int32_t& x, int32_t& y, int16_t angle)
+{
+  int32_t z = (int32_t)angle << CORDIC_ANGLE_SHIFT;
+
+  // CORDIC converges within +-99 degrees, flip the rest by half a turn
+  if (z > CORDIC_QUARTER)
+  {
+    x = -x;
+    y = -y;
+    z -= CORDIC_HALF_TURN;
+  }
+  else if (z < -CORDIC_QUARTER)
+  {
+    x = -x;
+    y = -y;
+    z += CORDIC_HALF_TURN;
+  }
+
+  for (uint8_t i = 0; i < CORDIC_STEPS; i++)
+  {
+    int32_t dx = x >> i;
+    int32_t dy = y >> i;
+    if (z >= 0)
+    {
+      x -= dy;
+      y += dx;
+      z -= CORDIC_ATAN[i];
+    }
+    else
+    {
+      x += dy;
+      y -= dx;
+      z += CORDIC_ATAN[i];
+    }
+  }
+
+  x = removeGain(x);
+  y = removeGain(y);
+}
+
+int16_t LSM303CCompass::vector(int32_t& x, int32_t& y)
+{
+  int32_t z = 0;
+
+  // Start from the right half plane
+  if (x < 0)
+  {
+    x = -x;
+    y = -y;
+    z = CORDIC_HALF_TURN;
+  }
+
+  for (uint8_t i = 0; i < CORDIC_STEPS; i++)
+  {
+    int32_t dx = x >> i;
+    int32_t dy = y >> i;
+    if (y > 0)
+    {
+      x += dy;
+      y -= dx;
+      z += CORDIC_ATAN[i];
+    }
+    else
+    {
+      x -= dy;
+      y += dx;
+      z -= CORDIC_ATAN[i];
+    }
+  }
+
+  x = removeGain(x);
+  // Round back to 16 bits, wrapping past half a turn
+  return (int16_t)(uint16_t)((z + (1 << (CORDIC_ANGLE_SHIFT - 1))) >>
+      CORDIC_ANGLE_SHIFT);
+}
+
+int16_t LSM303CCompass::atan2(int32_t y, int32_t x)
+{
+  // Scale so the larger component sits just under 2^28
+  int32_t big = (x < 0 ? -x : x) | (y < 0 ? -y : y);
+
+  if (!big)
+  {
+    return 0;
+  }
+  while (big >= (1L << 28))
+  {
+    x >>= 1;
+    y >>= 1;
+    big >>= 1;
+  }
+  while (big < (1L << 27))
+  {
+    x <<= 1;
+    y <<= 1;
+    big <<= 1;
+  }
+
+  return vector(x, y);
+}
+
+// Tilt compensation after Freescale AN4248, in the x forward, y right,
+// z down body frame:
+//  roll    = atan2(Gy, Gz)
+//  pitch   = atan2(-Gx, Gy sin(roll) + Gz cos(roll))
+//  heading = atan2(Bz sin(roll) - By cos(roll),
+//                  Bx cos(pitch) + (By sin(roll) + Bz cos(roll)) sin(pitch))
+// Every sin/cos pair is one CORDIC rotation.
+void LSM303CCompass::update(const AxesRaw_t& accel, const AxesRaw_t& mag,
+    Attitude_t& out)
+{
+  int32_t gx = (int32_t)accel.xAxis << CORDIC_INPUT_SHIFT;
+  int32_t gy = (int32_t)accel.yAxis << CORDIC_INPUT_SHIFT;
+  int32_t gz = (int32_t)accel.zAxis << CORDIC_INPUT_SHIFT;
+  int32_t bx = (int32_t)mag.xAxis << CORDIC_INPUT_SHIFT;
+  int32_t by = (int32_t)mag.yAxis << CORDIC_INPUT_SHIFT;
+  int32_t bz = (int32_t)mag.zAxis << CORDIC_INPUT_SHIFT;
+
+  // Roll, leaves gz = Gy sin(roll) + Gz cos(roll)
+  int16_t roll = vector(gz, gy);
+
+  // De-roll the field: bz = By sin(roll) + Bz cos(roll),
+  // by = By cos(roll) - Bz sin(roll)
+  rotate(bz, by, (int16_t)-roll);
+
+  gx = -gx;
+  int16_t pitch = vector(gz, gx);
+
+  // De-pitch: bx = Bx cos(pitch) + bz sin(pitch)
+  rotate(bx, bz, (int16_t)-pitch);
+
+  by = -by;
+  out.heading = (uint16_t)vector(bx, by);
+  out.pitch = pitch;
+  out.roll = roll;
+}
@@ -0,0 +1,54 @@
+// Tilt-compensated eCompass on integer CORDIC: heading, pitch and roll from
+// one accelerometer + magnetometer sample without atan2/sqrt/sin/cos.
+//
+// Angles are binary: 65536 counts per turn, so they wrap for free and
+// 1 count = 0.0055 degrees. The CORDIC itself adds at most 0.01 degrees to
+// atan2(); heading, pitch and roll stay within 0.05 degrees of the exact
+// result for fields of a few thousand counts, so sensor noise dominates.
+//
+// Plain C++ with no Arduino dependencies, so it also builds on a host.
+#ifndef __LSM303C_COMPASS_H__
+#define __LSM303C_COMPASS_H__
+
+#include <stdint.h>
+#include "LSM303CTypes.h"
+
+typedef struct
+{
+  uint16_t heading; // Clockwise from magnetic north, 0 to one turn
+  int16_t  pitch;   // Nose up positive, +-90 degrees
+  int16_t  roll;    // Right side down positive, +-180 degrees
+} Attitude_t;
+
+class LSM303CCompass
+{
+  public:
+    // Accelerometer and magnetometer axes are taken as aligned, in any units
+    // and at any full scale (only ratios matter). Mag offsets should already
+    // be removed.
+    static void update(const AxesRaw_t& accel, const AxesRaw_t& mag,
+        Attitude_t& out);
+
+    // Binary angle of the vector (x, y), like atan2(y, x)
+    static int16_t atan2(int32_t y, int32_t x);
+
+    // Binary angle to hundredths of a degree
+    static int16_t toCentiDegrees(int16_t angle)
+    {
+      return ((int32_t)angle * 36000L) >> 16;
+    }
+    static uint16_t headingCentiDegrees(uint16_t heading)
+    {
+      return ((uint32_t)heading * 36000UL) >> 16;
+    }
+
+  protected:
+    // Rotates (x, y) counter-clockwise by angle. Like vector(), the result
+    // comes out already divided by the CORDIC gain.
+    static void rotate(int32_t& x, int32_t& y, int16_t angle);
+    // Rotates (x, y) onto the positive x axis. Returns the angle it had and
+    // leaves its length in x.
+    static int16_t vector(int32_t& x, int32_t& y);
+};
+
+#endif
@@ -0,0 +1,675 @@
+#include "LSM303CEmulator.h"
+#include "stdint.h"
+
+// Register bits the model cares about
+#define EMU_ACC_IF_ADD_INC 0x04 // ACC_CTRL4
+#define EMU_ACC_H_LACTIVE  0x02 // ACC_CTRL5
+#define EMU_ACC_BDU        0x08 // ACC_CTRL1
+#define EMU_MAG_BDU        0x40 // MAG_CTRL_REG5
+#define EMU_MAG_MD_MASK    0x03 // MAG_CTRL_REG3
+#define EMU_ZYXDA          0x08 // Both STATUS registers share this layout
+#define EMU_DA_MASK        0x0F
+#define EMU_OR_MASK        0xF0
+#define EMU_IG_EVENT_MASK  0x3F // IG_CFG/IG_SRC axis events
+#define EMU_IG_DUR_MASK    0x7F
+// Threshold steps are 1/256 of the full scale, which is always 2^15 counts
+#define EMU_IG_THS_SHIFT   7
+
+// Conversion periods in microseconds, indexed by the ODR/DO field
+static const uint32_t ACC_PERIOD_US[8] =
+    {0, 100000, 20000, 10000, 5000, 2500, 1250, 0};
+static const uint32_t MAG_PERIOD_US[8] =
+    {1600000, 800000, 400000, 200000, 100000, 50000, 25000, 12500};
+
+LSM303CEmulator::LSM303CEmulator(InterfaceMode_t emulatedMode,
+    uint32_t clockHz)
+  : busMode(emulatedMode), busClock(clockHz)
+{
+  powerOn();
+}
+
+void LSM303CEmulator::powerOn()
+{
+  memset(acc, 0, sizeof(acc));
+  memset(mag, 0, sizeof(mag));
+
+  // Power-on values
+  acc[ACC_WHO_AM_I] = 0x41;
+  acc[ACC_CTRL1]    = 0x07;
+  acc[ACC_CTRL4]    = EMU_ACC_IF_ADD_INC;
+  mag[MAG_WHO_AM_I] = 0x3D;
+  mag[MAG_CTRL_REG1] = MAG_DO_10_Hz;
+  mag[MAG_CTRL_REG2] = MAG_FS_16_Ga;
+  mag[MAG_CTRL_REG3] = MAG_MD_POWER_DOWN_2;
+  mag[MAG_INT_CFG]   = MAG_INT_ALL | MAG_INT_RESERVED;
+  fifoHead = fifoCount = 0;
+  fifoOverrun = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////// Bus interface
+
+status_t LSM303CEmulator::readRegs(CHIP_t chip, uint8_t reg, uint8_t* data,
+    uint8_t len)
+{
+  if (hung)
+  {
+    return hangTransfer();
+  }
+
+  // Conversions due before the transfer starts are visible to it
+  update();
+  account(true, len);
+
+  for (uint8_t i = 0; i < len; i++)
+  {
+    if (chip == ACC)
+    {
+      data[i] = readAcc(reg);
+      // With the FIFO on, the output address rolls over to stream samples
+      if (fifoEnabled() && reg == ACC_OUT_Z_H)
+      {
+        reg = ACC_OUT_X_L;
+      }
+      else if (acc[ACC_CTRL4] & EMU_ACC_IF_ADD_INC)
+      {
+        reg++;
+      }
+    }
+    else
+    {
+      data[i] = readMag(reg);
+      reg++; // Transports set the auto-increment bit on every burst
+    }
+    reg &= EMU_REG_COUNT - 1;
+  }
+
+  return IMU_SUCCESS;
+}
+
+status_t LSM303CEmulator::writeRegs(CHIP_t chip, uint8_t reg,
+    const uint8_t* data, uint8_t len)
+{
+  if (hung)
+  {
+    return hangTransfer();
+  }
+
+  update();
+  account(false, len);
+
+  for (uint8_t i = 0; i < len; i++)
+  {
+    if (chip == ACC)
+    {
+      writeAcc(reg, data[i]);
+      if (acc[ACC_CTRL4] & EMU_ACC_IF_ADD_INC)
+      {
+        reg++;
+      }
+    }
+    else
+    {
+      writeMag(reg, data[i]);
+      reg++;
+    }
+    reg &= EMU_REG_COUNT - 1;
+  }
+
+  return IMU_SUCCESS;
+}
+
+// The transport waits out its deadline, then gives up
+status_t LSM303CEmulator::hangTransfer()
+{
+  transactionCount++;
+  elapse(LSM303C_I2C_TIMEOUT_US);
+  noteFault(BUS_FAULT_TIMEOUT);
+  return IMU_TIMEOUT;
+}
+
+status_t LSM303CEmulator::recover()
+{
+  // Nine clocks and a STOP at the 100 kHz recovery pace
+  elapse(200);
+
+  if (hung && lostPower)
+  {
+    powerOn();
+  }
+  hung = lostPower = false;
+  return IMU_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////// Time and accounting
+
+void LSM303CEmulator::elapse(uint32_t us)
+{
+  clock += us;
+  update();
+}
+
+// Bit times on the wire: I2C sends 9 bits per byte plus start/restart/stop,
+// SPI 8 bits per byte plus chip select setup
+void LSM303CEmulator::account(bool read, uint8_t len)
+{
+  uint8_t  wireBytes;
+  uint16_t bits;
+
+  if (busMode == MODE_I2C)
+  {
+    wireBytes = (read ? 3 : 2) + len;
+    bits = 9 * wireBytes + (read ? 3 : 2);
+  }
+  else
+  {
+    wireBytes = 1 + len;
+    bits = 8 * wireBytes + 2;
+  }
+
+  transactionCount++;
+  byteCount += wireBytes;
+  bitCount += bits;
+
+  // Advance simulated time by the transfer, carrying the sub-microsecond part
+  clockRemainder += (uint32_t)bits * 1000000UL;
+  clock += clockRemainder / busClock;
+  clockRemainder %= busClock;
+}
+
+uint32_t LSM303CEmulator::busTimeMicros() const
+{
+  return (uint64_t)bitCount * 1000000UL / busClock;
+}
+
+void LSM303CEmulator::resetCounters()
+{
+  transactionCount = 0;
+  byteCount = 0;
+  bitCount = 0;
+  accelConversions = 0;
+  magConversions = 0;
+}
+
+uint32_t LSM303CEmulator::accelPeriod() const
+{
+  return ACC_PERIOD_US[(acc[ACC_CTRL1] >> 4) & 0x07];
+}
+
+uint32_t LSM303CEmulator::magPeriod() const
+{
+  switch (mag[MAG_CTRL_REG3] & EMU_MAG_MD_MASK)
+  {
+  case MAG_MD_CONTINUOUS:
+  case MAG_MD_SINGLE:
+    return MAG_PERIOD_US[(mag[MAG_CTRL_REG1] >> 2) & 0x07];
+  default:
+    return 0; // Powered down
+  }
+}
+
+// Runs every conversion that became due since the last call
+void LSM303CEmulator::update()
+{
+  uint32_t period;
+  uint8_t n;
+
+  period = accelPeriod();
+  for (n = 0; period && (int32_t)(clock - nextAccel) >= 0; n++)
+  {
+    // Far behind: only the last FIFO's worth of conversions matter
+    if (n > 2 * ACC_FIFO_DEPTH)
+    {
+      nextAccel = clock + period;
+      break;
+    }
+    convertAccel();
+    nextAccel += period;
+  }
+
+  period = magPeriod();
+  for (n = 0; period && (int32_t)(clock - nextMag) >= 0; n++)
+  {
+    if (n > 2)
+    {
+      nextMag = clock + period;
+      break;
+    }
+    convertMag();
+    nextMag += period;
+    // A single conversion drops back to idle on its own
+    if ((mag[MAG_CTRL_REG3] & EMU_MAG_MD_MASK) == MAG_MD_SINGLE)
+    {
+      mag[MAG_CTRL_REG3] |= MAG_MD_POWER_DOWN_2;
+      break;
+    }
+    period = magPeriod();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////// Conversions
+
+static void latch(uint8_t* regs, uint8_t first, const AxesRaw_t& axes)
+{
+  regs[first + 0] = axes.xAxis & 0xFF;
+  regs[first + 1] = (uint16_t)axes.xAxis >> 8;
+  regs[first + 2] = axes.yAxis & 0xFF;
+  regs[first + 3] = (uint16_t)axes.yAxis >> 8;
+  regs[first + 4] = axes.zAxis & 0xFF;
+  regs[first + 5] = (uint16_t)axes.zAxis >> 8;
+}
+
+// Data not read since the previous conversion is flagged as overrun
+static void flagNewData(uint8_t& status)
+{
+  status |= (status & EMU_DA_MASK) << 4;
+  status |= EMU_DA_MASK;
+}
+
+// High-pass filter in reference mode with filtered data selected: the
+// chip outputs the input minus the REFERENCE registers
+AxesRaw_t LSM303CEmulator::accelOutput() const
+{
+  AxesRaw_t out = accelSource;
+
+  if ((acc[ACC_CTRL2] & (ACC_HPM_MASK | ACC_FDS)) ==
+      (ACC_HPM_REFERENCE | ACC_FDS))
+  {
+    out.xAxis -= (int16_t)((acc[ACC_XH_REFERENCE] << 8) | acc[ACC_XL_REFERENCE]);
+    out.yAxis -= (int16_t)((acc[ACC_YH_REFERENCE] << 8) | acc[ACC_YL_REFERENCE]);
+    out.zAxis -= (int16_t)((acc[ACC_ZH_REFERENCE] << 8) | acc[ACC_ZL_REFERENCE]);
+  }
+
+  return out;
+}
+
+void LSM303CEmulator::convertAccel()
+{
+  accelConversions++;
+  AxesRaw_t sample = accelOutput();
+
+  if (fifoEnabled())
+  {
+    if (fifoCount < fifoDepth())
+    {
+      fifo[(fifoHead + fifoCount++) % ACC_FIFO_DEPTH] = sample;
+    }
+    else if ((acc[ACC_FIFO_CTRL] & ACC_FIFO_MODE_MASK) == ACC_FIFO_FIFO)
+    {
+      fifoOverrun = true; // FIFO mode stops collecting once full
+    }
+    else
+    {
+      // Stream modes overwrite the oldest sample
+      fifoHead = (fifoHead + 1) % ACC_FIFO_DEPTH;
+      fifo[(fifoHead + fifoCount - 1) % ACC_FIFO_DEPTH] = sample;
+      fifoOverrun = true;
+    }
+  }
+
+  if ((acc[ACC_CTRL1] & EMU_ACC_BDU) && accelHalfRead)
+  {
+    accelPending = sample;
+    accelHeld = true;
+  }
+  else
+  {
+    latch(acc, ACC_OUT_X_L, sample);
+  }
+
+  evaluateGenerator(ACC_IG1, sample);
+  evaluateGenerator(ACC_IG2, sample);
+  flagNewData(acc[ACC_STATUS]);
+}
+
+// Generator 1 has a threshold per axis, generator 2 one for all. The 6D
+// modes, the wait bit and the high-pass path are not modelled.
+void LSM303CEmulator::evaluateGenerator(ACC_IG_t generator,
+    const AxesRaw_t& sample)
+{
+  bool first = generator == ACC_IG1;
+  uint8_t config = acc[first ? ACC_IG_CFG1 : ACC_IG_CFG2];
+  uint8_t& source = acc[first ? ACC_IG_SRC1 : ACC_IG_SRC2];
+  uint8_t duration = acc[first ? ACC_IG_DUR1 : ACC_IG_DUR2] & EMU_IG_DUR_MASK;
+  bool latched = acc[ACC_CTRL7] & (first ? ACC_LIR1 : ACC_LIR2);
+  uint8_t& counter = igCounter[generator];
+  const int16_t axes[3] = {sample.xAxis, sample.yAxis, sample.zAxis};
+  uint8_t events = 0;
+
+  if (latched && (source & ACC_IG_SRC_IA))
+  {
+    return; // Held until the source is read
+  }
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    int32_t threshold = (int32_t)acc[first ? ACC_IG_THS_X1 + i : ACC_IG_THS2]
+        << EMU_IG_THS_SHIFT;
+    int32_t magnitude = axes[i] < 0 ? -(int32_t)axes[i] : axes[i];
+    events |= (magnitude > threshold ? ACC_IG_XH : ACC_IG_XL) << (2 * i);
+  }
+
+  uint8_t enabled = config & EMU_IG_EVENT_MASK;
+  bool active = false;
+  if (enabled && !(config & ACC_IG_6D_MOVEMENT))
+  {
+    active = (config & ACC_IG_AND) ? (events & enabled) == enabled :
+        (events & enabled) != 0;
+  }
+
+  if (!active)
+  {
+    counter = 0;
+  }
+  else if (counter < 0xFF)
+  {
+    counter++;
+  }
+
+  source = events | (active && counter > duration ? ACC_IG_SRC_IA : 0);
+}
+
+void LSM303CEmulator::convertMag()
+{
+  magConversions++;
+
+  if ((mag[MAG_CTRL_REG5] & EMU_MAG_BDU) && magHalfRead)
+  {
+    magPending = magSource;
+    magHeld = true;
+  }
+  else
+  {
+    latch(mag, MAG_OUTX_L, magSource);
+  }
+
+  if (mag[MAG_CTRL_REG1] & MAG_TEMP_EN_ENABLE)
+  {
+    mag[MAG_TEMP_OUT_L] = tempSource & 0xFF;
+    mag[MAG_TEMP_OUT_H] = (uint16_t)tempSource >> 8;
+  }
+
+  evaluateMagThreshold();
+  flagNewData(mag[MAG_STATUS_REG]);
+}
+
+// Compares every enabled axis against +-MAG_INT_THS. MAG_INT_LIR clear
+// holds an event until MAG_INT_SRC is read.
+void LSM303CEmulator::evaluateMagThreshold()
+{
+  uint8_t config = mag[MAG_INT_CFG];
+  uint8_t& source = mag[MAG_INT_SRC];
+  int32_t threshold = ((mag[MAG_INT_THS_H] << 8) | mag[MAG_INT_THS_L]) & 0x7FFF;
+  const int16_t axes[3] = {magSource.xAxis, magSource.yAxis, magSource.zAxis};
+  uint8_t events = 0;
+
+  if (!(config & MAG_INT_LIR) && (source & MAG_INT_SRC_INT))
+  {
+    return;
+  }
+
+  // X, Y, Z enable bits run downwards from bit 7, like the PTH/NTH bits
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    if (!(config & (MAG_INT_X >> i)))
+    {
+      continue;
+    }
+    if (axes[i] > threshold)
+    {
+      events |= MAG_INT_SRC_PTH_X >> i;
+    }
+    else if (axes[i] < -threshold)
+    {
+      events |= MAG_INT_SRC_NTH_X >> i;
+    }
+  }
+
+  source = events ? events | MAG_INT_SRC_INT : 0;
+}
+
+bool LSM303CEmulator::fifoEnabled() const
+{
+  if (!(acc[ACC_CTRL3] & ACC_FIFO_EN))
+  {
+    return false;
+  }
+
+  // The bypass-to-* modes wait for a trigger event that is not modelled
+  switch (acc[ACC_FIFO_CTRL] & ACC_FIFO_MODE_MASK)
+  {
+  case ACC_FIFO_FIFO:
+  case ACC_FIFO_STREAM:
+  case ACC_FIFO_STREAM_TO_FIFO:
+    return true;
+  default:
+    return false;
+  }
+}
+
+uint8_t LSM303CEmulator::fifoDepth() const
+{
+  if (acc[ACC_CTRL3] & ACC_STOP_FTH)
+  {
+    return (acc[ACC_FIFO_CTRL] & ACC_FIFO_FSS_MASK) + 1;
+  }
+  return ACC_FIFO_DEPTH;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////// Register file
+
+// Reading an axis' high byte acknowledges it. Block data update holds new
+// conversions back until both bytes of every started axis have been read.
+static void readOutput(uint8_t offset, uint8_t& status, uint8_t& halfRead)
+{
+  uint8_t axis = offset >> 1;
+
+  if (offset & 1)
+  {
+    bitClear(halfRead, axis);
+    status &= ~(0x11 << axis);
+    if (!(status & 0x07))
+    {
+      status &= ~(EMU_ZYXDA | 0x80);
+    }
+  }
+  else
+  {
+    bitSet(halfRead, axis);
+  }
+}
+
+uint8_t LSM303CEmulator::readAcc(uint8_t reg)
+{
+  uint8_t value;
+
+  if (reg >= ACC_OUT_X_L && reg <= ACC_OUT_Z_H && fifoEnabled())
+  {
+    AxesRaw_t sample = fifoCount ? fifo[fifoHead] : accelOutput();
+    uint8_t raw[6];
+
+    latch(raw, 0, sample);
+    value = raw[reg - ACC_OUT_X_L];
+    if (reg == ACC_OUT_Z_H && fifoCount)
+    {
+      fifoHead = (fifoHead + 1) % ACC_FIFO_DEPTH;
+      fifoCount--;
+      fifoOverrun = false;
+    }
+    return value;
+  }
+
+  if (reg >= ACC_OUT_X_L && reg <= ACC_OUT_Z_H)
+  {
+    value = acc[reg];
+    readOutput(reg - ACC_OUT_X_L, acc[ACC_STATUS], accelHalfRead);
+    if (accelHeld && !accelHalfRead)
+    {
+      latch(acc, ACC_OUT_X_L, accelPending);
+      accelHeld = false;
+    }
+    return value;
+  }
+
+  if (reg == ACC_IG_SRC1 || reg == ACC_IG_SRC2)
+  {
+    value = acc[reg];
+    bool first = reg == ACC_IG_SRC1;
+    // Reading the source releases a latched interrupt
+    if (acc[ACC_CTRL7] & (first ? ACC_LIR1 : ACC_LIR2))
+    {
+      acc[reg] = 0;
+      igCounter[first ? ACC_IG1 : ACC_IG2] = 0;
+    }
+    return value;
+  }
+
+  if (reg == ACC_FIFO_SRC)
+  {
+    uint8_t threshold = acc[ACC_FIFO_CTRL] & ACC_FIFO_FSS_MASK;
+
+    value = fifoCount & ACC_FIFO_FSS_MASK;
+    if (fifoCount == 0)
+    {
+      value |= ACC_FIFO_EMPTY;
+    }
+    if (fifoOverrun)
+    {
+      value |= ACC_FIFO_OVR;
+    }
+    if (fifoCount >= threshold)
+    {
+      value |= ACC_FIFO_FTH;
+    }
+    return value;
+  }
+
+  return acc[reg];
+}
+
+uint8_t LSM303CEmulator::readMag(uint8_t reg)
+{
+  uint8_t value = mag[reg];
+
+  if (reg == MAG_INT_SRC && !(mag[MAG_INT_CFG] & MAG_INT_LIR))
+  {
+    mag[reg] = 0; // Releases a latched event
+  }
+
+  if (reg >= MAG_OUTX_L && reg <= MAG_OUTZ_H)
+  {
+    readOutput(reg - MAG_OUTX_L, mag[MAG_STATUS_REG], magHalfRead);
+    if (magHeld && !magHalfRead)
+    {
+      latch(mag, MAG_OUTX_L, magPending);
+      magHeld = false;
+    }
+  }
+
+  return value;
+}
+
+void LSM303CEmulator::writeAcc(uint8_t reg, uint8_t value)
+{
+  uint8_t old = acc[reg];
+
+  switch (reg)
+  {
+  case ACC_WHO_AM_I:
+  case ACC_STATUS:
+  case ACC_FIFO_SRC:
+  case ACC_IG_SRC1:
+  case ACC_IG_SRC2:
+    return; // Read only
+  default:
+    if (reg >= ACC_OUT_X_L && reg <= ACC_OUT_Z_H)
+    {
+      return;
+    }
+  }
+
+  acc[reg] = value;
+
+  if (reg == ACC_CTRL1 && ((old ^ value) & 0x70))
+  {
+    // New data rate: the first conversion lands one period from now
+    nextAccel = clock + accelPeriod();
+  }
+
+  if ((reg == ACC_FIFO_CTRL || reg == ACC_CTRL3) && !fifoEnabled())
+  {
+    // Bypass empties the FIFO
+    fifoHead = 0;
+    fifoCount = 0;
+    fifoOverrun = false;
+  }
+}
+
+void LSM303CEmulator::writeMag(uint8_t reg, uint8_t value)
+{
+  uint8_t old = mag[reg];
+
+  if (reg == MAG_WHO_AM_I || reg == MAG_STATUS_REG || reg == MAG_INT_SRC ||
+      (reg >= MAG_OUTX_L && reg <= MAG_TEMP_OUT_H))
+  {
+    return; // Read only
+  }
+
+  mag[reg] = value;
+
+  if ((reg == MAG_CTRL_REG1 && ((old ^ value) & MAG_DO_80_Hz)) ||
+      (reg == MAG_CTRL_REG3 && ((old ^ value) & EMU_MAG_MD_MASK)) ||
+      (reg == MAG_CTRL_REG3 && (value & EMU_MAG_MD_MASK) == MAG_MD_SINGLE))
+  {
+    nextMag = clock + magPeriod();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////// Interrupt pins
+
+bool LSM303CEmulator::intXL()
+{
+  uint8_t routing = acc[ACC_CTRL3];
+  bool level = false;
+
+  update();
+
+  if ((routing & ACC_INT_XL_DRDY) && (acc[ACC_STATUS] & EMU_ZYXDA))
+  {
+    level = true;
+  }
+  if ((routing & ACC_INT_XL_FTH) && fifoEnabled() &&
+      fifoCount >= (acc[ACC_FIFO_CTRL] & ACC_FIFO_FSS_MASK))
+  {
+    level = true;
+  }
+  if ((routing & ACC_INT_XL_OVR) && fifoOverrun)
+  {
+    level = true;
+  }
+  if (((routing & ACC_INT_XL_IG1) && (acc[ACC_IG_SRC1] & ACC_IG_SRC_IA)) ||
+      ((routing & ACC_INT_XL_IG2) && (acc[ACC_IG_SRC2] & ACC_IG_SRC_IA)))
+  {
+    level = true;
+  }
+
+  return (acc[ACC_CTRL5] & EMU_ACC_H_LACTIVE) ? !level : level;
+}
+
+bool LSM303CEmulator::drdyMag()
+{
+  update();
+  return mag[MAG_STATUS_REG] & EMU_ZYXDA;
+}
+
+bool LSM303CEmulator::intMag()
+{
+  update();
+  bool level = (mag[MAG_INT_CFG] & MAG_INT_IEN) &&
+      (mag[MAG_INT_SRC] & MAG_INT_SRC_INT);
+  return (mag[MAG_INT_CFG] & MAG_INT_IEA) ? level : !level;
+}
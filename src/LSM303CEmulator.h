@@ -0,0 +1,117 @@
+// Register-level model of both LSM303C dies that plugs in as a bus, so the
+// driver can run (and be benchmarked) without a breakout attached:
+//
+//   LSM303CEmulator emu;
+//   LSM303C myIMU(emu);
+//
+// Models output data rate timing, STATUS data-ready/overrun flags, block data
+// update, register auto-increment, the accelerometer FIFO, the accelerometer
+// interrupt generators (OR/AND events with duration and latching) and the
+// magnetometer threshold interrupt, and bus hangs for exercising recovery.
+// Time is simulated: every transaction advances the clock by its bus time and
+// elapse() stands in for everything else the sketch does.
+#ifndef __LSM303C_EMULATOR_H__
+#define __LSM303C_EMULATOR_H__
+
+#include "SparkFunLSM303C.h"
+
+#define EMU_REG_COUNT 0x40
+
+class LSM303CEmulator : public LSM303CBus
+{
+  public:
+    // busClock in Hz is only used to work out simulated transfer times
+    LSM303CEmulator(InterfaceMode_t emulatedMode = MODE_I2C,
+        uint32_t clockHz = 400000L);
+
+    InterfaceMode_t mode(void) const { return busMode; }
+    status_t readRegs(CHIP_t, uint8_t, uint8_t*, uint8_t);
+    status_t writeRegs(CHIP_t, uint8_t, const uint8_t*, uint8_t);
+
+    // Simulated time
+    void     elapse(uint32_t);
+    uint32_t now(void) const { return clock; }
+
+    // Values the next conversions report, in raw counts
+    void setAccel(const AxesRaw_t& axes) { accelSource = axes; }
+    void setMag(const AxesRaw_t& axes)   { magSource = axes; }
+    void setTemperature(int16_t raw)     { tempSource = raw; }
+
+    // Hangs the bus: every transfer times out after LSM303C_I2C_TIMEOUT_US
+    // of simulated time until recover(). With powerCycle the chip also
+    // comes back with its power-on registers, like after a brown-out.
+    void hangBus(bool powerCycle = false) { hung = true; lostPower = powerCycle; }
+    status_t recover(void);
+
+    // Interrupt pin levels, for driving the interrupt pipeline by hand
+    bool intXL(void);
+    bool drdyMag(void);
+    bool intMag(void);
+
+    // Bus accounting since the last resetCounters()
+    uint32_t transactions(void) const { return transactionCount; }
+    uint32_t bytes(void) const { return byteCount; }
+    uint32_t busTimeMicros(void) const;
+    void     resetCounters(void);
+
+    uint32_t accelConversions = 0;
+    uint32_t magConversions = 0;
+
+  protected:
+    void     powerOn(void);
+    void     account(bool, uint8_t);
+    status_t hangTransfer(void);
+    void     update(void);
+    void     convertAccel(void);
+    AxesRaw_t accelOutput(void) const;
+    void     convertMag(void);
+    void     evaluateGenerator(ACC_IG_t, const AxesRaw_t&);
+    void     evaluateMagThreshold(void);
+    uint32_t accelPeriod(void) const;
+    uint32_t magPeriod(void) const;
+    uint8_t  fifoDepth(void) const;
+    bool     fifoEnabled(void) const;
+    uint8_t  readAcc(uint8_t);
+    uint8_t  readMag(uint8_t);
+    void     writeAcc(uint8_t, uint8_t);
+    void     writeMag(uint8_t, uint8_t);
+
+    InterfaceMode_t busMode;
+    uint32_t busClock;
+
+    uint8_t acc[EMU_REG_COUNT];
+    uint8_t mag[EMU_REG_COUNT];
+
+    AxesRaw_t accelSource = {0, 0, 16384}; // 1 g at +/-2 g
+    AxesRaw_t magSource = {410, -205, -820};
+    int16_t   tempSource = 0;              // 25 C
+
+    // Conversions held back by block data update while an axis is half read
+    AxesRaw_t accelPending;
+    AxesRaw_t magPending;
+    uint8_t   accelHalfRead = 0;
+    uint8_t   magHalfRead = 0;
+    bool      accelHeld = false;
+    bool      magHeld = false;
+
+    AxesRaw_t fifo[ACC_FIFO_DEPTH];
+    uint8_t   fifoHead = 0;
+    uint8_t   fifoCount = 0;
+    bool      fifoOverrun = false;
+
+    uint8_t   igCounter[2] = {0, 0}; // Samples each generator's event held
+
+    uint32_t clock = 0;
+    uint32_t clockRemainder = 0;
+    uint32_t nextAccel = 0;
+    uint32_t nextMag = 0;
+    bool     magSinglePending = false;
+    bool     hung = false;
+    bool     lostPower = false;
+
+    uint32_t transactionCount = 0;
+    uint32_t byteCount = 0;
+    uint32_t bitCount = 0;
+};
+
+#endif
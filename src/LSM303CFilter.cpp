@@ -0,0 +1,150 @@
+#include <math.h>
+#include "LSM303CFilter.h"
+
+// Products are accumulated with 2 fractional bits dropped so five of them
+// can't overflow 32 bits: |coefficient| < 2 and |sample| <= 2^15
+#define BIQUAD_PRODUCT_SHIFT 2
+#define BIQUAD_ACC_SHIFT     (FILTER_COEFF_SHIFT - BIQUAD_PRODUCT_SHIFT)
+
+static inline int16_t toCoefficient(float c)
+{
+  return (int16_t)lroundf(c * (1L << FILTER_COEFF_SHIFT));
+}
+
+// Common part of the RBJ cookbook low/high-pass designs. Fills a1/a2 and
+// b0 = b2, leaves b1 to the caller.
+static BiquadCoeffs_t design(float cutoffHz, float sampleHz, float q,
+    bool highPass)
+{
+  BiquadCoeffs_t c;
+  float w0 = 2 * (float)M_PI * cutoffHz / sampleHz;
+  float cosW0 = cosf(w0);
+  float alpha = sinf(w0) / (2 * q);
+  float a0 = 1 + alpha;
+
+  c.a1 = toCoefficient(-2 * cosW0 / a0);
+  c.a2 = toCoefficient((1 - alpha) / a0);
+  c.b0 = c.b2 = toCoefficient((highPass ? 1 + cosW0 : 1 - cosW0) / 2 / a0);
+  return c;
+}
+
+BiquadCoeffs_t LSM303CBiquad::lowPass(float cutoffHz, float sampleHz, float q)
+{
+  BiquadCoeffs_t c = design(cutoffHz, sampleHz, q, false);
+
+  // b0 + b1 + b2 = 1 + a1 + a2, DC passes at exactly unity gain
+  c.b1 = (1L << FILTER_COEFF_SHIFT) + c.a1 + c.a2 - 2 * c.b0;
+  return c;
+}
+
+BiquadCoeffs_t LSM303CBiquad::highPass(float cutoffHz, float sampleHz, float q)
+{
+  BiquadCoeffs_t c = design(cutoffHz, sampleHz, q, true);
+
+  // b0 + b1 + b2 = 0, DC is removed completely
+  c.b1 = -2 * c.b0;
+  return c;
+}
+
+void LSM303CBiquad::prime(State_t& s, int16_t x)
+{
+  // Output the filter would settle to for a steady input x
+  int32_t den = (1L << FILTER_COEFF_SHIFT) + coeffs.a1 + coeffs.a2;
+  float y = den ? (float)x * ((int32_t)coeffs.b0 + coeffs.b1 + coeffs.b2) / den : 0;
+
+  s.x1 = s.x2 = x;
+  s.y1 = s.y2 = y > 32767 ? 32767 : y < -32768 ? -32768 : (int16_t)lroundf(y);
+  s.error = 0;
+}
+
+int16_t LSM303CBiquad::step(State_t& s, int16_t x)
+{
+  const int32_t products[5] =
+  {
+    (int32_t)coeffs.b0 * x,
+    (int32_t)coeffs.b1 * s.x1,
+    (int32_t)coeffs.b2 * s.x2,
+    -(int32_t)coeffs.a1 * s.y1,
+    -(int32_t)coeffs.a2 * s.y2
+  };
+  int32_t acc = s.error;
+  uint8_t dropped = 0;
+
+  // The bits shifted off each product are added back as a group, so acc is
+  // exactly the floor of the full sum. Otherwise a steady input never meets
+  // a steady output and the result dithers by a count.
+  for (uint8_t i = 0; i < 5; i++)
+  {
+    acc += products[i] >> BIQUAD_PRODUCT_SHIFT;
+    dropped += products[i] & ((1 << BIQUAD_PRODUCT_SHIFT) - 1);
+  }
+  acc += dropped >> BIQUAD_PRODUCT_SHIFT;
+
+  int32_t y = acc >> BIQUAD_ACC_SHIFT;
+  int16_t out;
+
+  if (y > 32767 || y < -32768)
+  {
+    out = y > 0 ? 32767 : -32768;
+    s.error = 0;
+  }
+  else
+  {
+    out = y;
+    s.error = acc - (y << BIQUAD_ACC_SHIFT);
+  }
+
+  s.x2 = s.x1;
+  s.x1 = x;
+  s.y2 = s.y1;
+  s.y1 = out;
+  return out;
+}
+
+bool LSM303CBiquad::process(AxesRaw_t& sample)
+{
+  if (!primed)
+  {
+    prime(state[0], sample.xAxis);
+    prime(state[1], sample.yAxis);
+    prime(state[2], sample.zAxis);
+    primed = true;
+  }
+
+  sample.xAxis = step(state[0], sample.xAxis);
+  sample.yAxis = step(state[1], sample.yAxis);
+  sample.zAxis = step(state[2], sample.zAxis);
+  return true;
+}
+
+bool LSM303CFilterChain::add(LSM303CFilterStage& stage)
+{
+  if (count >= maxStages)
+  {
+    return false;
+  }
+
+  stages[count++] = &stage;
+  return true;
+}
+
+bool LSM303CFilterChain::process(AxesRaw_t& sample)
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (!stages[i]->process(sample))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void LSM303CFilterChain::reset(void)
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    stages[i]->reset();
+  }
+}
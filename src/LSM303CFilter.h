@@ -0,0 +1,297 @@
+// Fixed-point filter stages for raw AxesRaw_t streams, chained into a
+// pipeline with LSM303CFilterChain. Everything runs on int16 samples with
+// 32-bit integer arithmetic, so a median + CIC decimator + biquad chain at
+// 800 Hz costs a fraction of what the same filtering in float does on AVR.
+//
+// Each stage starts from the first sample it sees as if the input had been
+// steady at that value, so there is no start-up ramp from zero.
+//
+// Pair with LSM303C::setAccelHighPass() to have the chip remove gravity and
+// drift before the samples ever reach the pipeline.
+//
+// Plain C++ with no Arduino dependencies, so it also builds on a host.
+#ifndef __LSM303C_FILTER_H__
+#define __LSM303C_FILTER_H__
+
+#include <stdint.h>
+#include "LSM303CTypes.h"
+
+// Fractional bits of LSM303CBiquad coefficients
+#define FILTER_COEFF_SHIFT 14
+
+class LSM303CFilterStage
+{
+  public:
+    // Filters the sample in place. Returns false while the stage holds the
+    // sample back (decimators), which ends the chain for that input.
+    virtual bool process(AxesRaw_t&) = 0;
+    // Forget the history, the next sample primes the stage again
+    virtual void reset(void) = 0;
+};
+
+// Mean of the last N samples, with running sums so the cost doesn't grow
+// with N
+template <uint8_t N>
+class LSM303CMovingAverage : public LSM303CFilterStage
+{
+  public:
+    LSM303CMovingAverage() { reset(); }
+
+    bool process(AxesRaw_t& sample)
+    {
+      if (!primed)
+      {
+        for (uint8_t i = 0; i < N; i++)
+        {
+          window[i] = sample;
+        }
+        sum[0] = (int32_t)sample.xAxis * N;
+        sum[1] = (int32_t)sample.yAxis * N;
+        sum[2] = (int32_t)sample.zAxis * N;
+        primed = true;
+      }
+
+      AxesRaw_t& oldest = window[head];
+      sum[0] += sample.xAxis - oldest.xAxis;
+      sum[1] += sample.yAxis - oldest.yAxis;
+      sum[2] += sample.zAxis - oldest.zAxis;
+      oldest = sample;
+      head = head + 1 < N ? head + 1 : 0;
+
+      sample.xAxis = sum[0] / N;
+      sample.yAxis = sum[1] / N;
+      sample.zAxis = sum[2] / N;
+      return true;
+    }
+
+    void reset(void) { primed = false; head = 0; }
+
+  protected:
+    AxesRaw_t window[N];
+    int32_t sum[3];
+    uint8_t head;
+    bool primed;
+};
+
+// Median of the last N samples (N odd) per axis. Removes single-sample
+// spikes without smearing steps the way an average does.
+template <uint8_t N>
+class LSM303CMedianFilter : public LSM303CFilterStage
+{
+  static_assert(N & 1, "median window must be odd");
+
+  public:
+    LSM303CMedianFilter() { reset(); }
+
+    bool process(AxesRaw_t& sample)
+    {
+      if (!primed)
+      {
+        for (uint8_t i = 0; i < N; i++)
+        {
+          window[i] = sample;
+        }
+        primed = true;
+      }
+
+      window[head] = sample;
+      head = head + 1 < N ? head + 1 : 0;
+
+      sample.xAxis = median(&AxesRaw_t::xAxis);
+      sample.yAxis = median(&AxesRaw_t::yAxis);
+      sample.zAxis = median(&AxesRaw_t::zAxis);
+      return true;
+    }
+
+    void reset(void) { primed = false; head = 0; }
+
+  protected:
+    AxesRaw_t window[N];
+    uint8_t head;
+    bool primed;
+
+    int16_t median(int16_t AxesRaw_t::* axis) const
+    {
+      int16_t sorted[N];
+
+      // Insertion sort, a handful of values at most
+      for (uint8_t i = 0; i < N; i++)
+      {
+        int16_t v = window[i].*axis;
+        uint8_t j = i;
+        for (; j > 0 && sorted[j - 1] > v; j--)
+        {
+          sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = v;
+      }
+
+      return sorted[N / 2];
+    }
+};
+
+// Cascaded integrator-comb decimator: ORDER integrators at the input rate,
+// ORDER combs at 1/2^LOG2_RATE of it. A sinc^ORDER low-pass plus decimation
+// with adds only, exact DC gain of 1. The integrators wrap by design.
+template <uint8_t ORDER, uint8_t LOG2_RATE>
+class LSM303CCICDecimator : public LSM303CFilterStage
+{
+  static_assert(ORDER >= 1 && LOG2_RATE >= 1, "CIC needs a stage and a rate");
+  // Gain is 2^(ORDER * LOG2_RATE) on top of 16 bits, all in 32
+  static_assert(ORDER * LOG2_RATE <= 15, "CIC bit growth exceeds 32 bits");
+
+  public:
+    LSM303CCICDecimator() { reset(); }
+
+    bool process(AxesRaw_t& sample)
+    {
+      if (!primed)
+      {
+        // Run the filter up to its steady state on the first sample
+        primed = true;
+        for (uint32_t i = 0; i < (uint32_t)(ORDER + 1) << LOG2_RATE; i++)
+        {
+          AxesRaw_t copy = sample;
+          process(copy);
+        }
+        phase = 0;
+      }
+
+      integrate(0, sample.xAxis);
+      integrate(1, sample.yAxis);
+      integrate(2, sample.zAxis);
+
+      if (++phase < (1 << LOG2_RATE))
+      {
+        return false;
+      }
+      phase = 0;
+
+      sample.xAxis = comb(0);
+      sample.yAxis = comb(1);
+      sample.zAxis = comb(2);
+      return true;
+    }
+
+    void reset(void)
+    {
+      for (uint8_t axis = 0; axis < 3; axis++)
+      {
+        for (uint8_t i = 0; i < ORDER; i++)
+        {
+          integrator[axis][i] = 0;
+          delay[axis][i] = 0;
+        }
+      }
+      phase = 0;
+      primed = false;
+    }
+
+  protected:
+    // Unsigned so the wrap-around is well defined
+    uint32_t integrator[3][ORDER];
+    uint32_t delay[3][ORDER];
+    uint8_t phase;
+    bool primed;
+
+    void integrate(uint8_t axis, int16_t in)
+    {
+      uint32_t v = (uint32_t)(int32_t)in;
+      for (uint8_t i = 0; i < ORDER; i++)
+      {
+        v = integrator[axis][i] += v;
+      }
+    }
+
+    int16_t comb(uint8_t axis)
+    {
+      uint32_t v = integrator[axis][ORDER - 1];
+      for (uint8_t i = 0; i < ORDER; i++)
+      {
+        uint32_t previous = delay[axis][i];
+        delay[axis][i] = v;
+        v -= previous;
+      }
+      // Round to nearest while dividing out the gain
+      const uint8_t shift = ORDER * LOG2_RATE;
+      return (int16_t)(((int32_t)v + (1L << (shift - 1))) >> shift);
+    }
+};
+
+// Second-order IIR section, Q14 coefficients with a0 normalized to 1:
+//  y = b0 x + b1 x[-1] + b2 x[-2] - a1 y[-1] - a2 y[-2]
+typedef struct
+{
+  int16_t b0, b1, b2;
+  int16_t a1, a2;
+} BiquadCoeffs_t;
+
+// Direct form I with the rounding error fed back into the next output, so
+// low cutoffs settle exactly instead of sticking a few counts off
+class LSM303CBiquad : public LSM303CFilterStage
+{
+  public:
+    LSM303CBiquad(const BiquadCoeffs_t& c) : coeffs(c) { reset(); }
+
+    // Butterworth-style designs (Q = 0.7071 is maximally flat). Float math,
+    // meant for setup(). The coefficients are tweaked after rounding so DC
+    // gain is exactly 1 (low-pass) or 0 (high-pass). Cutoffs far below
+    // the sample rate (under 1/50 or so) lose precision, decimate first.
+    static BiquadCoeffs_t lowPass(float cutoffHz, float sampleHz, float q = 0.7071f);
+    static BiquadCoeffs_t highPass(float cutoffHz, float sampleHz, float q = 0.7071f);
+
+    void setCoefficients(const BiquadCoeffs_t& c) { coeffs = c; reset(); }
+
+    bool process(AxesRaw_t&);
+    void reset(void) { primed = false; }
+
+  protected:
+    typedef struct
+    {
+      int16_t x1, x2, y1, y2;
+      int16_t error; // Fraction lost by the last output, 1/2^12 counts
+    } State_t;
+
+    BiquadCoeffs_t coeffs;
+    State_t state[3];
+    bool primed;
+
+    int16_t step(State_t&, int16_t);
+    void prime(State_t&, int16_t);
+};
+
+// Runs stages in order. Storage for the stage pointers comes from the caller
+// or from LSM303CFilterChainOf<N>.
+class LSM303CFilterChain
+{
+  public:
+    LSM303CFilterChain(LSM303CFilterStage** stageStorage, uint8_t capacity)
+      : stages(stageStorage), maxStages(capacity) { }
+
+    // False when the chain is full
+    bool add(LSM303CFilterStage&);
+    uint8_t size(void) const { return count; }
+
+    // Filters the sample in place. False if a decimating stage held it, so
+    // there's no output for this input.
+    bool process(AxesRaw_t&);
+    void reset(void);
+
+  protected:
+    LSM303CFilterStage** const stages;
+    const uint8_t maxStages;
+    uint8_t count = 0;
+};
+
+// Chain that owns its bookkeeping: LSM303CFilterChainOf<3> pipeline;
+template <uint8_t N>
+class LSM303CFilterChainOf : public LSM303CFilterChain
+{
+  public:
+    LSM303CFilterChainOf() : LSM303CFilterChain(stageStorage, N) { }
+
+  private:
+    LSM303CFilterStage* stageStorage[N];
+};
+
+#endif
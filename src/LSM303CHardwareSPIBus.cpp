@@ -0,0 +1,85 @@
+#include "LSM303CHardwareSPIBus.h"
+
+status_t LSM303CHardwareSPIBus::begin()
+{
+  debug_println("Setting up hardware SPI");
+  // Deselect both chips before the first clock edge
+  pinMode(csMag, OUTPUT);
+  pinMode(csXL, OUTPUT);
+  deselect();
+  spi.begin();
+
+  return IMU_SUCCESS;
+}
+
+// Starts the transaction and clocks out the sub-address
+void LSM303CHardwareSPIBus::select(CHIP_t chip, uint8_t reg)
+{
+  spi.beginTransaction(settings);
+  digitalWrite((chip == MAG) ? csMag : csXL, LOW);
+  spi.transfer(reg);
+}
+
+void LSM303CHardwareSPIBus::deselect()
+{
+  digitalWrite(csMag, HIGH);
+  digitalWrite(csXL, HIGH);
+}
+
+status_t LSM303CHardwareSPIBus::readRegs(CHIP_t chip, uint8_t reg,
+    uint8_t* data, uint8_t len)
+{
+  debug_print("Reading register 0x");
+  debug_printlns(reg, HEX);
+
+  if (chip == MAG && len > 1)
+  {
+    reg |= MAG_SPI_AUTO_INCREMENT;
+  }
+
+  // Set the read/write bit (bit 7) to do a read
+  select(chip, reg | _BV(7));
+
+  // Turn the bus around, the chip drives SDI/SDO from the next clock on
+  if (mosi != LSM303C_NO_PIN)
+  {
+    pinMode(mosi, INPUT);
+  }
+  for (uint8_t i = 0; i < len; i++)
+  {
+    data[i] = spi.transfer(0x00);
+  }
+
+  deselect();
+  if (mosi != LSM303C_NO_PIN)
+  {
+    pinMode(mosi, OUTPUT);
+  }
+  spi.endTransaction();
+
+  return IMU_SUCCESS;
+}
+
+status_t LSM303CHardwareSPIBus::writeRegs(CHIP_t chip, uint8_t reg,
+    const uint8_t* data, uint8_t len)
+{
+  debug_print("Writing register 0x");
+  debug_printlns(reg, HEX);
+
+  if (chip == MAG && len > 1)
+  {
+    reg |= MAG_SPI_AUTO_INCREMENT;
+  }
+
+  // Clear the read/write bit (bit 7) to do a write
+  select(chip, reg & ~_BV(7));
+  for (uint8_t i = 0; i < len; i++)
+  {
+    spi.transfer(data[i]);
+  }
+  deselect();
+  spi.endTransaction();
+
+  // Is there a way to verify true success?
+  return IMU_SUCCESS;
+}
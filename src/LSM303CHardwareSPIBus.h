@@ -0,0 +1,54 @@
+// 3-wire SPI transport on the MCU's SPI peripheral. Works on any board with
+// an SPI library and lets the chip select lines sit on any digital pins.
+//
+// The LSM303C shares one SDI/SDO line for both directions:
+//  MOSI -> 1k resistor -> SDI/SDO
+//  MISO ------------------> SDI/SDO
+//  SCK  -> SCLK
+//  any pin -> CS_XL, any pin -> CS_MAG
+// The resistor keeps MOSI from fighting the chip while it drives the line
+// during the read phase. On AVR, MOSI is also released to an input for the
+// read phase so the resistor is only a safety net there.
+#ifndef __LSM303C_HARDWARE_SPI_BUS_H__
+#define __LSM303C_HARDWARE_SPI_BUS_H__
+
+#include <SPI.h>
+#include "LSM303CBus.h"
+
+// Datasheet limit is 10 MHz, the SPI library rounds down to what it can do
+#define LSM303C_SPI_CLOCK 10000000L
+
+// Only AVR leaves MOSI under pinMode() control while the SPI is enabled
+#if defined(__AVR__)
+#define LSM303C_SPI_TURNAROUND_PIN MOSI
+#else
+#define LSM303C_SPI_TURNAROUND_PIN LSM303C_NO_PIN
+#endif
+
+class LSM303CHardwareSPIBus : public LSM303CBus
+{
+  public:
+    // Pass LSM303C_NO_PIN as mosiPin to rely on the series resistor alone
+    LSM303CHardwareSPIBus(uint8_t csMagPin, uint8_t csXLPin,
+        uint32_t clockHz = LSM303C_SPI_CLOCK, SPIClass& spiPort = SPI,
+        uint8_t mosiPin = LSM303C_SPI_TURNAROUND_PIN)
+      : spi(spiPort), settings(clockHz, MSBFIRST, SPI_MODE3),
+        csMag(csMagPin), csXL(csXLPin), mosi(mosiPin) {}
+
+    status_t begin(void);
+    InterfaceMode_t mode(void) const { return MODE_SPI; }
+    status_t readRegs(CHIP_t, uint8_t, uint8_t*, uint8_t);
+    status_t writeRegs(CHIP_t, uint8_t, const uint8_t*, uint8_t);
+
+  protected:
+    SPIClass& spi;
+    SPISettings settings;
+    uint8_t csMag;
+    uint8_t csXL;
+    uint8_t mosi;
+
+    void select(CHIP_t, uint8_t);
+    void deselect(void);
+};
+
+#endif
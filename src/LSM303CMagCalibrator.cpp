@@ -0,0 +1,338 @@
+#include <math.h>
+#include <stdlib.h>
+#include "LSM303CMagCalibrator.h"
+
+// Samples are scaled down by 2^10 before squaring, keeping the sums well
+// inside float precision at every full scale
+#define MAG_CAL_SCALE (1.0f / 1024)
+
+// Position of (i, j), i <= j, in the packed upper triangle of a 7x7 matrix
+uint8_t LSM303CMagCalibrator::index(uint8_t i, uint8_t j)
+{
+  return i * 7 - i * (i - 1) / 2 + (j - i);
+}
+
+float LSM303CMagCalibrator::sum(uint8_t i, uint8_t j) const
+{
+  uint8_t k = (i <= j) ? index(i, j) : index(j, i);
+  return sums[k] - carry[k];
+}
+
+void LSM303CMagCalibrator::reset()
+{
+  for (uint8_t i = 0; i < 28; i++)
+  {
+    sums[i] = carry[i] = 0;
+  }
+  count = 0;
+  octants = 0;
+  error = 0;
+}
+
+bool LSM303CMagCalibrator::add(const AxesRaw_t& raw)
+{
+  if (count)
+  {
+    int32_t step = labs((int32_t)raw.xAxis - last.xAxis) +
+        labs((int32_t)raw.yAxis - last.yAxis) +
+        labs((int32_t)raw.zAxis - last.zAxis);
+    if (step < MAG_CAL_MIN_STEP || count == 0xFFFF)
+    {
+      return false;
+    }
+  }
+  else
+  {
+    minimum = maximum = reference = raw;
+  }
+  last = raw;
+  count++;
+
+  // Track the extent of the data for the coverage estimate
+  if (raw.xAxis < minimum.xAxis) minimum.xAxis = raw.xAxis;
+  if (raw.yAxis < minimum.yAxis) minimum.yAxis = raw.yAxis;
+  if (raw.zAxis < minimum.zAxis) minimum.zAxis = raw.zAxis;
+  if (raw.xAxis > maximum.xAxis) maximum.xAxis = raw.xAxis;
+  if (raw.yAxis > maximum.yAxis) maximum.yAxis = raw.yAxis;
+  if (raw.zAxis > maximum.zAxis) maximum.zAxis = raw.zAxis;
+  uint8_t octant = 0;
+  if (2L * raw.xAxis > (int32_t)minimum.xAxis + maximum.xAxis) octant |= 1;
+  if (2L * raw.yAxis > (int32_t)minimum.yAxis + maximum.yAxis) octant |= 2;
+  if (2L * raw.zAxis > (int32_t)minimum.zAxis + maximum.zAxis) octant |= 4;
+  octants |= 1 << octant;
+
+  recenter();
+
+  float x = ((int32_t)raw.xAxis - reference.xAxis) * MAG_CAL_SCALE;
+  float y = ((int32_t)raw.yAxis - reference.yAxis) * MAG_CAL_SCALE;
+  float z = ((int32_t)raw.zAxis - reference.zAxis) * MAG_CAL_SCALE;
+  float psi[7] = {x * x, y * y, z * z, x, y, z, 1};
+
+  // Compensated (Kahan) sums: plain float sums of tens of thousands of
+  // samples lose the bits the fit error is made of
+  for (uint8_t i = 0; i < 7; i++)
+  {
+    for (uint8_t j = i; j < 7; j++)
+    {
+      uint8_t k = index(i, j);
+      float v = psi[i] * psi[j] - carry[k];
+      float t = sums[k] + v;
+      carry[k] = (t - sums[k]) - v;
+      sums[k] = t;
+    }
+  }
+
+  return true;
+}
+
+// Moves the reference to the middle of the data when it has drifted off,
+// shifting the sums to match: with x' = x - a, psi' = T psi where
+//   x'^2 = x^2 - 2a x + a^2,  x' = x - a
+// so sum(psi' psi'^T) = T sum(psi psi^T) T^T exactly
+void LSM303CMagCalibrator::recenter()
+{
+  int32_t lo[3] = {minimum.xAxis, minimum.yAxis, minimum.zAxis};
+  int32_t hi[3] = {maximum.xAxis, maximum.yAxis, maximum.zAxis};
+  int32_t ref[3] = {reference.xAxis, reference.yAxis, reference.zAxis};
+  int32_t mid[3];
+  bool move = false;
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    int32_t off;
+    mid[i] = (lo[i] + hi[i]) / 2;
+    off = labs(mid[i] - ref[i]);
+    if (off > MAG_CAL_MIN_STEP && off * MAG_CAL_RECENTER > hi[i] - lo[i])
+    {
+      move = true;
+    }
+  }
+  if (!move)
+  {
+    return;
+  }
+
+  float m[7][7];
+  float a[3];
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    a[i] = (mid[i] - ref[i]) * MAG_CAL_SCALE;
+  }
+  for (uint8_t i = 0; i < 7; i++)
+  {
+    for (uint8_t j = 0; j < 7; j++)
+    {
+      m[i][j] = sum(i, j);
+    }
+  }
+
+  // T from the left, row by row. The square rows need the linear rows
+  // before those are shifted themselves.
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    for (uint8_t j = 0; j < 7; j++)
+    {
+      m[i][j] += -2 * a[i] * m[i + 3][j] + a[i] * a[i] * m[6][j];
+    }
+  }
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    for (uint8_t j = 0; j < 7; j++)
+    {
+      m[i + 3][j] -= a[i] * m[6][j];
+    }
+  }
+  // And T^T from the right, column by column
+  for (uint8_t j = 0; j < 3; j++)
+  {
+    for (uint8_t i = 0; i < 7; i++)
+    {
+      m[i][j] += -2 * a[j] * m[i][j + 3] + a[j] * a[j] * m[i][6];
+    }
+  }
+  for (uint8_t j = 0; j < 3; j++)
+  {
+    for (uint8_t i = 0; i < 7; i++)
+    {
+      m[i][j + 3] -= a[j] * m[i][6];
+    }
+  }
+
+  for (uint8_t i = 0; i < 7; i++)
+  {
+    for (uint8_t j = i; j < 7; j++)
+    {
+      sums[index(i, j)] = m[i][j];
+      carry[index(i, j)] = 0;
+    }
+  }
+
+  reference.xAxis = (int16_t)mid[0];
+  reference.yAxis = (int16_t)mid[1];
+  reference.zAxis = (int16_t)mid[2];
+}
+
+uint8_t LSM303CMagCalibrator::coverage() const
+{
+  uint8_t bits = 0;
+
+  for (uint8_t o = octants; o; o >>= 1)
+  {
+    bits += o & 1;
+  }
+
+  return bits;
+}
+
+// The fit is linear least squares in p = [A, B, D, E, F, G] with
+// C = 1 - A - B substituted:
+//   A (x^2 - z^2) + B (y^2 - z^2) + D x + E y + F z + G = -z^2
+// phi = L psi are its regressors and t = -z^2 = e . psi its target
+static const int8_t L[6][7] = {
+  {1, 0, -1, 0, 0, 0, 0},
+  {0, 1, -1, 0, 0, 0, 0},
+  {0, 0,  0, 1, 0, 0, 0},
+  {0, 0,  0, 0, 1, 0, 0},
+  {0, 0,  0, 0, 0, 1, 0},
+  {0, 0,  0, 0, 0, 0, 1}
+};
+
+// sum(phi_i phi_j), and sum(phi_i t) for j == 6
+float LSM303CMagCalibrator::normal(uint8_t i, uint8_t j) const
+{
+  float s = 0;
+
+  for (uint8_t k = 0; k < 7; k++)
+  {
+    if (!L[i][k])
+    {
+      continue;
+    }
+    if (j == 6)
+    {
+      s -= L[i][k] * sum(k, 2);
+      continue;
+    }
+    for (uint8_t l = 0; l < 7; l++)
+    {
+      if (L[j][l])
+      {
+        s += L[i][k] * L[j][l] * sum(k, l);
+      }
+    }
+  }
+
+  return s;
+}
+
+bool LSM303CMagCalibrator::solve(MagCalibration_t& cal)
+{
+  float m[6][7];
+  float p[6];
+
+  if (count < MAG_CAL_MIN_SAMPLES)
+  {
+    return false;
+  }
+
+  // Normal equations sum(phi phi^T) p = sum(phi t)
+  for (uint8_t i = 0; i < 6; i++)
+  {
+    for (uint8_t j = 0; j < 7; j++)
+    {
+      m[i][j] = normal(i, j);
+    }
+  }
+
+  // Gaussian elimination with partial pivoting
+  for (uint8_t c = 0; c < 6; c++)
+  {
+    uint8_t pivot = c;
+    for (uint8_t r = c + 1; r < 6; r++)
+    {
+      if (fabs(m[r][c]) > fabs(m[pivot][c]))
+      {
+        pivot = r;
+      }
+    }
+    if (fabs(m[pivot][c]) < 1e-12f)
+    {
+      return false; // Degenerate, e.g. only turned about one axis
+    }
+    for (uint8_t j = c; j < 7; j++)
+    {
+      float t = m[c][j];
+      m[c][j] = m[pivot][j];
+      m[pivot][j] = t;
+    }
+    for (uint8_t r = c + 1; r < 6; r++)
+    {
+      float f = m[r][c] / m[c][c];
+      for (uint8_t j = c; j < 7; j++)
+      {
+        m[r][j] -= f * m[c][j];
+      }
+    }
+  }
+  for (int8_t r = 5; r >= 0; r--)
+  {
+    float s = m[r][6];
+    for (uint8_t j = r + 1; j < 6; j++)
+    {
+      s -= m[r][j] * p[j];
+    }
+    p[r] = s / m[r][r];
+  }
+
+  // A (x - cx)^2 + B (y - cy)^2 + C (z - cz)^2 = g
+  float coef[3] = {p[0], p[1], 1 - p[0] - p[1]};
+  if (coef[0] <= 0 || coef[1] <= 0 || coef[2] <= 0)
+  {
+    return false;
+  }
+  float center[3];
+  float g = -p[5];
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    center[i] = -p[i + 2] / (2 * coef[i]);
+    g += coef[i] * center[i] * center[i];
+  }
+  if (g <= 0)
+  {
+    return false;
+  }
+  float radius[3];
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    radius[i] = sqrt(g / coef[i]);
+  }
+  float mean = (radius[0] + radius[1] + radius[2]) / 3;
+
+  // Residual of the algebraic fit, p' M p - 2 p' v + sum(t^2). A sample's
+  // residual is g (q - 1), q its squared distance in radii, and q - 1 is
+  // about twice the relative radius error.
+  float sse = sum(2, 2);
+  for (uint8_t i = 0; i < 6; i++)
+  {
+    float mp = 0;
+    for (uint8_t j = 0; j < 6; j++)
+    {
+      mp += normal(i, j) * p[j];
+    }
+    sse += p[i] * (mp - 2 * normal(i, 6));
+  }
+  error = (sse > 0) ? sqrt(sse / count) / (2 * g) : 0;
+
+  cal.offset.xAxis = (int16_t)lround(center[0] / MAG_CAL_SCALE + reference.xAxis);
+  cal.offset.yAxis = (int16_t)lround(center[1] / MAG_CAL_SCALE + reference.yAxis);
+  cal.offset.zAxis = (int16_t)lround(center[2] / MAG_CAL_SCALE + reference.zAxis);
+  // Stretch every axis to the mean radius
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    long gain = lround(mean / radius[i] * 16384);
+    cal.gain[i] = (int16_t)((gain > 32767) ? 32767 : gain);
+  }
+
+  return true;
+}
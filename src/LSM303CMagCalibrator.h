@@ -0,0 +1,70 @@
+// Streaming hard/soft-iron calibration for the magnetometer. Each sample
+// updates the running moment sums of an axis-aligned ellipsoid
+// least-squares fit
+//   A x^2 + B y^2 + C z^2 + D x + E y + F z + G = 0,  A + B + C = 1
+// so memory stays constant no matter how many samples go in. solve() turns
+// the sums into a MagCalibration_t for LSM303C::setMagCalibration().
+//
+// The sums are taken relative to a reference point that follows the middle
+// of the data (they are shifted exactly when it moves), so the fit stays
+// well conditioned however far the hard-iron offset puts the ellipsoid from
+// zero.
+//
+// Plain C++ with no Arduino dependencies, so it also builds on a host.
+#ifndef __LSM303C_MAG_CALIBRATOR_H__
+#define __LSM303C_MAG_CALIBRATOR_H__
+
+#include <stdint.h>
+#include "LSM303CTypes.h"
+
+// Samples closer than this (sum of axis differences, counts) to the last one
+// kept are skipped, so holding still doesn't swamp the fit
+#define MAG_CAL_MIN_STEP    16
+// solve() refuses to fit with fewer samples than this
+#define MAG_CAL_MIN_SAMPLES 32
+// The reference point moves to the middle of the data once that is more than
+// 1/MAG_CAL_RECENTER of the data's extent away on some axis
+#define MAG_CAL_RECENTER    8
+
+class LSM303CMagCalibrator
+{
+  public:
+    LSM303CMagCalibrator() { reset(); }
+
+    void reset(void);
+    // Returns false if the sample was skipped
+    bool add(const AxesRaw_t&);
+
+    uint16_t samples(void) const { return count; }
+    // Number of octants around the current center that have seen a sample,
+    // 8 means the sensor has been turned through every orientation
+    uint8_t coverage(void) const;
+
+    // False if there is too little data or it doesn't fit an ellipsoid
+    bool solve(MagCalibration_t&);
+    // RMS distance of the samples from the fitted ellipsoid relative to its
+    // radius, from the last successful solve(). Below 0.02 is a good fit.
+    float fitError(void) const { return error; }
+
+  protected:
+    // Upper triangle of sum(psi * psi^T) for
+    // psi = [x^2, y^2, z^2, x, y, z, 1], x = (raw - reference) in scaled
+    // units. Row 6 holds the plain sums and the sample count.
+    float sums[28];
+    float carry[28]; // Rounding error still owed to sums
+
+    AxesRaw_t reference;
+    uint16_t count;
+    AxesRaw_t last;
+    AxesRaw_t minimum;
+    AxesRaw_t maximum;
+    uint8_t octants;
+    float error;
+
+    void recenter(void);
+    float sum(uint8_t, uint8_t) const;
+    float normal(uint8_t, uint8_t) const;
+    static uint8_t index(uint8_t, uint8_t);
+};
+
+#endif
@@ -0,0 +1,155 @@
+#include "LSM303CPowerGovernor.h"
+
+// Gravity tracking time constant, 2^n samples
+#define GOVERNOR_GRAVITY_SHIFT 4
+
+static const PowerProfile_t DEFAULT_PROFILES[POWER_LEVEL_COUNT] =
+{
+  {ACC_ODR_10_Hz,  MAG_DO_0_625_Hz, MAG_OMXY_LOW_POWER,          MAG_OMZ_LOW_PW},
+  {ACC_ODR_50_Hz,  MAG_DO_10_Hz,    MAG_OMXY_MEDIUM_PERFORMANCE, MAG_OMZ_MEDIUM_PERFORMANCE},
+  {ACC_ODR_100_Hz, MAG_DO_40_Hz,    MAG_OMXY_HIGH_PERFORMANCE,   MAG_OMZ_HIGH_PERFORMANCE}
+};
+
+LSM303CPowerGovernor::LSM303CPowerGovernor(LSM303C& imu) : sensor(imu)
+{
+  for (uint8_t i = 0; i < POWER_LEVEL_COUNT; i++)
+  {
+    profiles[i] = DEFAULT_PROFILES[i];
+  }
+  resetReport();
+}
+
+status_t LSM303CPowerGovernor::begin(POWER_LEVEL_t start)
+{
+  primed = false;
+  quietSince = millis();
+  current = start;
+  resetReport();
+  return apply(start);
+}
+
+void LSM303CPowerGovernor::setProfile(POWER_LEVEL_t level,
+    const PowerProfile_t& settings)
+{
+  profiles[level] = settings;
+  if (level == current)
+  {
+    applied = false; // Picked up by the next update()
+  }
+}
+
+void LSM303CPowerGovernor::setThresholds(uint16_t upMg, uint16_t downMg,
+    uint32_t idleMs)
+{
+  upThreshold = upMg;
+  downThreshold = downMg < upMg ? downMg : upMg;
+  idleTime = idleMs;
+}
+
+void LSM303CPowerGovernor::setHardwareSleep(uint16_t thresholdMg,
+    uint16_t durationMs)
+{
+  sleepThreshold = thresholdMg;
+  sleepDuration = durationMs;
+  if (sleeps(current))
+  {
+    applied = false;
+  }
+}
+
+// Never while active, where a sleeping chip would hold back the first
+// samples of a movement, nor where the profile is at the sleep rate anyway
+bool LSM303CPowerGovernor::sleeps(POWER_LEVEL_t level) const
+{
+  return level != POWER_ACTIVE && profiles[level].accelOdr > ACC_ODR_10_Hz;
+}
+
+status_t LSM303CPowerGovernor::apply(POWER_LEVEL_t level)
+{
+  const PowerProfile_t& p = profiles[level];
+
+  // Shadow registers make unchanged settings free
+  applied = sensor.ACC_SetODR(p.accelOdr) == IMU_SUCCESS &&
+      sensor.MAG_SetODR(p.magRate) == IMU_SUCCESS &&
+      sensor.MAG_XY_AxOperativeMode(p.magXY) == IMU_SUCCESS &&
+      sensor.MAG_Z_AxOperativeMode(p.magZ) == IMU_SUCCESS &&
+      // After the ODR, the inactivity duration counts samples
+      sensor.setAccelInactivity(sleeps(level) ? sleepThreshold : 0,
+          sleepDuration) == IMU_SUCCESS;
+
+  return applied ? IMU_SUCCESS : IMU_HW_ERROR;
+}
+
+status_t LSM303CPowerGovernor::update(const AxesRaw_t& accel)
+{
+  uint32_t now = millis();
+  AxesRaw_t mg;
+  sensor.accelMilliG(accel, mg);
+  const int16_t axes[3] = {mg.xAxis, mg.yAxis, mg.zAxis};
+  uint32_t motion = 0;
+
+  if (!primed)
+  {
+    for (uint8_t i = 0; i < 3; i++)
+    {
+      gravity[i] = (int32_t)axes[i] << GOVERNOR_GRAVITY_SHIFT;
+    }
+    primed = true;
+  }
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    int32_t deviation = axes[i] - (gravity[i] >> GOVERNOR_GRAVITY_SHIFT);
+    motion += deviation < 0 ? -deviation : deviation;
+    gravity[i] += deviation;
+  }
+  lastMotion = motion > 0xFFFF ? 0xFFFF : motion;
+
+  POWER_LEVEL_t next = current;
+  if (motion >= downThreshold)
+  {
+    quietSince = now;
+  }
+  if (motion > upThreshold)
+  {
+    next = POWER_ACTIVE;
+  }
+  else if (current > POWER_IDLE && now - quietSince >= idleTime)
+  {
+    next = (POWER_LEVEL_t)(current - 1);
+    quietSince = now; // A full idle time for each step
+  }
+
+  if (next != current)
+  {
+    levelTime[current] += now - levelSince;
+    levelSince = now;
+    current = next;
+    changes++;
+    return apply(next);
+  }
+
+  return applied ? IMU_SUCCESS : apply(current);
+}
+
+uint32_t LSM303CPowerGovernor::timeIn(POWER_LEVEL_t level) const
+{
+  uint32_t total = levelTime[level];
+
+  if (level == current)
+  {
+    total += millis() - levelSince;
+  }
+
+  return total;
+}
+
+void LSM303CPowerGovernor::resetReport()
+{
+  for (uint8_t i = 0; i < POWER_LEVEL_COUNT; i++)
+  {
+    levelTime[i] = 0;
+  }
+  levelSince = millis();
+  changes = 0;
+}
@@ -0,0 +1,88 @@
+// Steps the sensor between power profiles by how much it is moving, so a
+// battery node only pays for high data rates while something is happening.
+//
+// Motion is how far each accelerometer sample strays from a slowly tracked
+// gravity vector. Crossing the up threshold jumps straight to the active
+// profile so the start of a movement isn't lost; staying under the down
+// threshold for the idle time steps down one level. In between nothing
+// changes, which is the hysteresis. Optionally the chip's own inactivity
+// detection takes the accelerometer down to 10 Hz below the active level.
+#ifndef __LSM303C_POWER_GOVERNOR_H__
+#define __LSM303C_POWER_GOVERNOR_H__
+
+#include "SparkFunLSM303C.h"
+
+typedef enum
+{
+  POWER_IDLE,
+  POWER_LOW,
+  POWER_ACTIVE,
+  POWER_LEVEL_COUNT
+} POWER_LEVEL_t;
+
+typedef struct
+{
+  ACC_ODR_t  accelOdr;
+  MAG_DO_t   magRate;
+  MAG_OMXY_t magXY;
+  MAG_OMZ_t  magZ;
+} PowerProfile_t;
+
+class LSM303CPowerGovernor
+{
+  public:
+    LSM303CPowerGovernor(LSM303C& imu);
+
+    // The sensor must already be begun. Applies the starting level.
+    status_t begin(POWER_LEVEL_t start = POWER_ACTIVE);
+
+    // Defaults: idle 10 Hz / 0.625 Hz low power, low 50 Hz / 10 Hz medium,
+    // active 100 Hz / 40 Hz high performance (the begin() configuration)
+    void setProfile(POWER_LEVEL_t, const PowerProfile_t&);
+    const PowerProfile_t& profile(POWER_LEVEL_t level) const { return profiles[level]; }
+    // Motion thresholds in mg summed over the axes (up must be above down)
+    // and the quiet time per step down. Defaults 150 mg, 50 mg, 5 s.
+    void setThresholds(uint16_t upMg, uint16_t downMg, uint32_t idleMs);
+    // Chip inactivity detection below the active level, at every level
+    // whose profile runs the accelerometer faster than the 10 Hz it sleeps
+    // at (with the defaults, only low). See LSM303C::setAccelInactivity().
+    // A zero threshold leaves it off.
+    void setHardwareSleep(uint16_t thresholdMg, uint16_t durationMs);
+
+    // Feed every fresh accelerometer sample, raw counts. IMU_HW_ERROR if a
+    // level change didn't make it to the chip (it is retried next time).
+    status_t update(const AxesRaw_t& accel);
+
+    POWER_LEVEL_t level(void) const { return current; }
+    uint16_t motion(void) const { return lastMotion; } // mg, last sample
+    // Milliseconds spent at each level since begin() or resetReport(),
+    // including the current stretch
+    uint32_t timeIn(POWER_LEVEL_t) const;
+    uint16_t transitions(void) const { return changes; }
+    void resetReport(void);
+
+  protected:
+    LSM303C& sensor;
+    PowerProfile_t profiles[POWER_LEVEL_COUNT];
+    uint16_t upThreshold = 150;
+    uint16_t downThreshold = 50;
+    uint32_t idleTime = 5000;
+    uint16_t sleepThreshold = 0;
+    uint16_t sleepDuration = 0;
+
+    POWER_LEVEL_t current = POWER_ACTIVE;
+    bool applied = false;
+    int32_t gravity[3]; // Tracked gravity in mg, 4 fractional bits
+    bool primed = false;
+    uint16_t lastMotion = 0;
+    uint32_t quietSince = 0;
+
+    uint32_t levelTime[POWER_LEVEL_COUNT];
+    uint32_t levelSince = 0;
+    uint16_t changes = 0;
+
+    status_t apply(POWER_LEVEL_t);
+    bool sleeps(POWER_LEVEL_t) const;
+};
+
+#endif
@@ -0,0 +1,83 @@
+// Fixed-capacity single-producer/single-consumer queue of timestamped
+// samples. The producer (LSM303C::serviceInterrupts(), possibly from an ISR)
+// only writes head and the consumer (the sketch) only writes tail, so neither
+// side needs to disable interrupts.
+#ifndef __LSM303C_SAMPLE_QUEUE_H__
+#define __LSM303C_SAMPLE_QUEUE_H__
+
+#include "Arduino.h"
+#include "LSM303CTypes.h"
+
+class LSM303CSampleQueue
+{
+  public:
+    // Uses the largest power of two (up to 128) that fits in capacity, so
+    // the indexes can wrap with a mask. storage must hold at least one sample.
+    LSM303CSampleQueue(AxesSample_t* storage, uint8_t capacity)
+      : buffer(storage), mask(usableCapacity(capacity) - 1) { }
+
+    bool push(const AxesSample_t& sample)
+    {
+      uint8_t h = head;
+      if ((uint8_t)(h - tail) > mask)
+      {
+        return false; // Full, keep the older samples
+      }
+      buffer[h & mask] = sample;
+      barrier();
+      head = h + 1;
+      return true;
+    }
+
+    bool pop(AxesSample_t& sample)
+    {
+      uint8_t t = tail;
+      if (t == head)
+      {
+        return false;
+      }
+      sample = buffer[t & mask];
+      barrier();
+      tail = t + 1;
+      return true;
+    }
+
+    uint8_t available() const { return (uint8_t)(head - tail); }
+    uint8_t capacity()  const { return mask + 1; }
+    bool    empty()     const { return head == tail; }
+
+  protected:
+    static uint8_t usableCapacity(uint8_t capacity)
+    {
+      uint8_t n = 128;
+      while (n > 1 && n > capacity)
+      {
+        n >>= 1;
+      }
+      return n;
+    }
+
+    // Keep the compiler from moving the slot copy past the index update
+    static inline void barrier() { __asm__ __volatile__("" ::: "memory"); }
+
+    AxesSample_t* const buffer;
+    const uint8_t mask;
+    volatile uint8_t head = 0;
+    volatile uint8_t tail = 0;
+};
+
+// Queue that owns its storage: LSM303CSampleBuffer<16> accelQueue;
+template <uint8_t N>
+class LSM303CSampleBuffer : public LSM303CSampleQueue
+{
+  static_assert(N && N <= 128 && (N & (N - 1)) == 0,
+      "Queue capacity must be a power of two no larger than 128");
+
+  public:
+    LSM303CSampleBuffer() : LSM303CSampleQueue(storage, N) { }
+
+  private:
+    AxesSample_t storage[N];
+};
+
+#endif
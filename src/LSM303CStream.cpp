@@ -0,0 +1,18 @@
+#include "LSM303CStream.h"
+
+size_t LSM303CStream::begin(const LSM303C& imu)
+{
+  uint8_t frame[STREAM_MAX_ENCODED];
+  size_t len = encoder.config(imu.accelSensitivity(), imu.magSensitivity(),
+      frame);
+
+  return port.write(frame, len);
+}
+
+size_t LSM303CStream::write(CHIP_t chip, const AxesSample_t& s)
+{
+  uint8_t frame[STREAM_MAX_ENCODED];
+  size_t len = encoder.sample(chip, s, frame);
+
+  return port.write(frame, len);
+}
@@ -0,0 +1,32 @@
+// Streams samples as compact binary frames (see LSM303CStreamCodec.h) to any
+// Print: Serial, a SoftwareSerial, a radio. An accelerometer sample costs
+// 11 bytes on the wire when it can be delta encoded and 17 when it can't,
+// against 20-30 bytes of text for the same three numbers.
+//
+// Decode on the host with extras/StreamDecoder.
+#ifndef __LSM303C_STREAM_H__
+#define __LSM303C_STREAM_H__
+
+#include "SparkFunLSM303C.h"
+#include "LSM303CStreamCodec.h"
+
+class LSM303CStream
+{
+  public:
+    LSM303CStream(Print& out) : port(out) { }
+
+    // Sends the scale of each die so the host can convert counts. Call again
+    // after changing the full scale.
+    size_t begin(const LSM303C&);
+
+    // Each returns the bytes written
+    size_t writeAccel(const AxesSample_t& s) { return write(ACC, s); }
+    size_t   writeMag(const AxesSample_t& s) { return write(MAG, s); }
+    size_t write(CHIP_t, const AxesSample_t&);
+
+  protected:
+    Print& port;
+    LSM303CStreamEncoder encoder;
+};
+
+#endif
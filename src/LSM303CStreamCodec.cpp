@@ -0,0 +1,303 @@
+#include <string.h>
+#include "LSM303CStreamCodec.h"
+
+// Sample flags ride in the top bits of the type byte
+#define STREAM_FLAGS_SHIFT 5
+#define STREAM_FLAGS_MASK  (0x03 << STREAM_FLAGS_SHIFT)
+
+#define STREAM_CONFIG_LENGTH 9
+#define STREAM_ABS_LENGTH    13
+#define STREAM_DELTA_LENGTH  7
+
+static inline void put16(uint8_t* p, uint16_t v)
+{
+  p[0] = v;
+  p[1] = v >> 8;
+}
+
+static inline void put32(uint8_t* p, uint32_t v)
+{
+  put16(p, v);
+  put16(p + 2, v >> 16);
+}
+
+static inline uint16_t get16(const uint8_t* p)
+{
+  return p[0] | ((uint16_t)p[1] << 8);
+}
+
+static inline uint32_t get32(const uint8_t* p)
+{
+  return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+// Floats go out as their IEEE-754 bits, the same on AVR, ARM and x86
+static inline void putFloat(uint8_t* p, float f)
+{
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  put32(p, bits);
+}
+
+static inline float getFloat(const uint8_t* p)
+{
+  uint32_t bits = get32(p);
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+static inline bool fitsInt8(int32_t v)
+{
+  return v >= -128 && v <= 127;
+}
+
+// CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xFFFF
+uint16_t crc16(const uint8_t* data, size_t len)
+{
+  uint16_t crc = 0xFFFF;
+
+  while (len--)
+  {
+    crc ^= (uint16_t)*data++ << 8;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+
+  return crc;
+}
+
+// Frames are far shorter than 254 bytes, so there is never more than one
+// block and the output is exactly one byte longer than the input
+size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out)
+{
+  size_t code = 0;
+  size_t o = 1;
+
+  for (size_t i = 0; i < len; i++)
+  {
+    if (in[i])
+    {
+      out[o++] = in[i];
+    }
+    else
+    {
+      out[code] = o - code;
+      code = o++;
+    }
+  }
+  out[code] = o - code;
+
+  return o;
+}
+
+// Returns 0 for malformed input
+size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out)
+{
+  size_t i = 0;
+  size_t o = 0;
+
+  while (i < len)
+  {
+    uint8_t code = in[i++];
+    if (!code || i + code - 1 > len)
+    {
+      return 0;
+    }
+    for (uint8_t j = 1; j < code; j++)
+    {
+      out[o++] = in[i++];
+    }
+    if (i < len)
+    {
+      out[o++] = 0;
+    }
+  }
+
+  return o;
+}
+
+// Appends the CRC, COBS encodes and terminates the frame
+static size_t finishFrame(uint8_t* body, size_t len, uint8_t* out)
+{
+  put16(body + len, crc16(body, len));
+  len = cobsEncode(body, len + 2, out);
+  out[len++] = 0;
+  return len;
+}
+
+void LSM303CStreamEncoder::reset(void)
+{
+  // Any sample after a reset starts with a keyframe
+  memset(last, 0, sizeof(last));
+  sinceKey[MAG] = sinceKey[ACC] = STREAM_KEYFRAME_INTERVAL;
+}
+
+size_t LSM303CStreamEncoder::config(float accelSensitivity,
+    float magSensitivity, uint8_t* out)
+{
+  uint8_t body[STREAM_MAX_BODY];
+
+  body[0] = STREAM_CONFIG;
+  putFloat(body + 1, accelSensitivity);
+  putFloat(body + 5, magSensitivity);
+
+  // The host may have (re)started, send keyframes from here on
+  reset();
+
+  return finishFrame(body, STREAM_CONFIG_LENGTH, out);
+}
+
+size_t LSM303CStreamEncoder::sample(CHIP_t chip, const AxesSample_t& s,
+    uint8_t* out)
+{
+  uint8_t body[STREAM_MAX_BODY];
+  AxesSample_t& prev = last[chip];
+  uint8_t type = (chip == ACC ? STREAM_ACCEL : STREAM_MAG) |
+    ((s.flags << STREAM_FLAGS_SHIFT) & STREAM_FLAGS_MASK);
+  size_t len;
+
+  int32_t dx = (int32_t)s.axes.xAxis - prev.axes.xAxis;
+  int32_t dy = (int32_t)s.axes.yAxis - prev.axes.yAxis;
+  int32_t dz = (int32_t)s.axes.zAxis - prev.axes.zAxis;
+  uint32_t dt = s.timestamp - prev.timestamp;
+
+  if (sinceKey[chip] < STREAM_KEYFRAME_INTERVAL &&
+      s.sequence == (uint16_t)(prev.sequence + 1) && dt <= 0xFFFF &&
+      fitsInt8(dx) && fitsInt8(dy) && fitsInt8(dz))
+  {
+    body[0] = type | STREAM_DELTA;
+    body[1] = s.sequence;
+    put16(body + 2, dt);
+    body[4] = dx;
+    body[5] = dy;
+    body[6] = dz;
+    len = STREAM_DELTA_LENGTH;
+    sinceKey[chip]++;
+  }
+  else
+  {
+    body[0] = type;
+    put16(body + 1, s.sequence);
+    put32(body + 3, s.timestamp);
+    put16(body + 7, s.axes.xAxis);
+    put16(body + 9, s.axes.yAxis);
+    put16(body + 11, s.axes.zAxis);
+    len = STREAM_ABS_LENGTH;
+    sinceKey[chip] = 1;
+  }
+
+  prev = s;
+  return finishFrame(body, len, out);
+}
+
+void LSM303CStreamDecoder::reset(void)
+{
+  length = 0;
+  overflow = false;
+  haveLast[MAG] = haveLast[ACC] = false;
+  accScale = magScale = 0;
+  errorCount = 0;
+}
+
+bool LSM303CStreamDecoder::feed(uint8_t byte, StreamRecord_t& out)
+{
+  if (byte)
+  {
+    if (length < sizeof(buffer))
+    {
+      buffer[length++] = byte;
+    }
+    else
+    {
+      overflow = true;
+    }
+    return false;
+  }
+
+  // Delimiter: decode whatever came before it
+  uint8_t body[STREAM_MAX_ENCODED];
+  uint8_t len = overflow ? 0 : cobsDecode(buffer, length, body);
+  bool empty = !length;
+
+  length = 0;
+  overflow = false;
+  if (empty)
+  {
+    return false;
+  }
+
+  if (len < 3 || crc16(body, len - 2) != get16(body + len - 2) ||
+      !parse(body, len - 2, out))
+  {
+    errorCount++;
+    return false;
+  }
+
+  return true;
+}
+
+bool LSM303CStreamDecoder::parse(const uint8_t* body, uint8_t len,
+    StreamRecord_t& out)
+{
+  uint8_t type = body[0] & STREAM_TYPE_MASK;
+  CHIP_t chip = type == STREAM_ACCEL ? ACC : MAG;
+  AxesSample_t& s = out.sample;
+
+  out.type = (STREAM_FRAME_t)type;
+
+  if (type == STREAM_CONFIG)
+  {
+    if (len != STREAM_CONFIG_LENGTH)
+    {
+      return false;
+    }
+    accScale = getFloat(body + 1);
+    magScale = getFloat(body + 5);
+    return true;
+  }
+
+  if (type != STREAM_ACCEL && type != STREAM_MAG)
+  {
+    return false;
+  }
+
+  s.flags = (body[0] & STREAM_FLAGS_MASK) >> STREAM_FLAGS_SHIFT;
+
+  if (!(body[0] & STREAM_DELTA))
+  {
+    if (len != STREAM_ABS_LENGTH)
+    {
+      return false;
+    }
+    s.sequence = get16(body + 1);
+    s.timestamp = get32(body + 3);
+    s.axes.xAxis = get16(body + 7);
+    s.axes.yAxis = get16(body + 9);
+    s.axes.zAxis = get16(body + 11);
+  }
+  else
+  {
+    const AxesSample_t& prev = last[chip];
+
+    // A delta only applies to the sample right before it. After a lost
+    // frame wait for the next keyframe.
+    if (len != STREAM_DELTA_LENGTH || !haveLast[chip] ||
+        body[1] != (uint8_t)(prev.sequence + 1))
+    {
+      haveLast[chip] = false;
+      return false;
+    }
+    s.sequence = prev.sequence + 1;
+    s.timestamp = prev.timestamp + get16(body + 2);
+    s.axes.xAxis = prev.axes.xAxis + (int8_t)body[4];
+    s.axes.yAxis = prev.axes.yAxis + (int8_t)body[5];
+    s.axes.zAxis = prev.axes.zAxis + (int8_t)body[6];
+  }
+
+  last[chip] = s;
+  haveLast[chip] = true;
+  return true;
+}
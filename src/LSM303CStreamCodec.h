@@ -0,0 +1,97 @@
+// Compact binary framing for streaming samples off the board, shared by the
+// sketch side (LSM303CStream) and the host decoder in extras/StreamDecoder.
+//
+// Every frame is CRC-16/CCITT protected, COBS encoded and terminated by a
+// 0x00 byte, so a receiver that joins mid-stream or loses bytes resyncs on
+// the next zero. Frame bodies, little-endian:
+//  CONFIG: type, accel mg/LSB (float), mag gauss/LSB (float)
+//  ABS:    type, sequence (16), timestamp (32), x, y, z (16 each)
+//  DELTA:  type, sequence (low 8), dt (16), dx, dy, dz (8 each)
+// A DELTA frame is relative to the previous sample of the same die and is
+// only sent when the sequence is consecutive and every change fits 8 bits.
+// An ABS keyframe goes out at least every STREAM_KEYFRAME_INTERVAL samples.
+//
+// Plain C++ with no Arduino dependencies, so it also builds on a host.
+#ifndef __LSM303C_STREAM_CODEC_H__
+#define __LSM303C_STREAM_CODEC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "LSM303CTypes.h"
+
+#define STREAM_KEYFRAME_INTERVAL 32
+// Largest frame body (ABS) plus CRC, and after COBS + delimiter
+#define STREAM_MAX_BODY    15
+#define STREAM_MAX_ENCODED (STREAM_MAX_BODY + 2)
+
+typedef enum
+{
+  STREAM_CONFIG     = 0x01,
+  STREAM_ACCEL      = 0x02,
+  STREAM_MAG        = 0x03,
+  STREAM_TYPE_MASK  = 0x0F,
+  STREAM_DELTA      = 0x10
+} STREAM_FRAME_t;
+
+// A decoded sample, or a config update (chip is then meaningless)
+typedef struct
+{
+  STREAM_FRAME_t type;
+  AxesSample_t   sample;
+} StreamRecord_t;
+
+class LSM303CStreamEncoder
+{
+  public:
+    LSM303CStreamEncoder() { reset(); }
+
+    // Forget previous samples, the next one of each die is a keyframe
+    void reset(void);
+
+    // Each returns the number of bytes written to out, which must hold
+    // STREAM_MAX_ENCODED bytes
+    size_t config(float accelSensitivity, float magSensitivity, uint8_t* out);
+    size_t sample(CHIP_t, const AxesSample_t&, uint8_t* out);
+
+  protected:
+    AxesSample_t last[2];
+    uint8_t sinceKey[2];
+};
+
+class LSM303CStreamDecoder
+{
+  public:
+    LSM303CStreamDecoder() { reset(); }
+
+    void reset(void);
+
+    // Feed one received byte. True when it completed a valid frame, which
+    // is then in out. Samples that arrive before a CONFIG frame are still
+    // decoded, the scale is just unknown (0).
+    bool feed(uint8_t, StreamRecord_t& out);
+
+    float accelSensitivity(void) const { return accScale; } // mg/LSB
+    float   magSensitivity(void) const { return magScale; } // Ga/LSB
+
+    // Frames dropped for a bad CRC, bad COBS or a delta with no base
+    uint32_t errors(void) const { return errorCount; }
+
+  protected:
+    uint8_t buffer[STREAM_MAX_ENCODED];
+    uint8_t length;
+    bool overflow;
+    AxesSample_t last[2];
+    bool haveLast[2];
+    float accScale;
+    float magScale;
+    uint32_t errorCount;
+
+    bool parse(const uint8_t*, uint8_t, StreamRecord_t&);
+};
+
+// Framing helpers, exposed for tests and other transports
+size_t   cobsEncode(const uint8_t* in, size_t len, uint8_t* out);
+size_t   cobsDecode(const uint8_t* in, size_t len, uint8_t* out);
+uint16_t crc16(const uint8_t*, size_t);
+
+#endif
@@ -85,6 +85,13 @@ typedef enum
   MAG_XYZDA_YES = 0x08
 } MAG_XYZDA_t;
 
+// Any axis overwritten before it was read
+typedef enum
+{
+  MAG_ZYXOR_NO  = 0x00,
+  MAG_ZYXOR_YES = 0x80
+} MAG_ZYXOR_t;
+
 typedef enum
 {
   ACC_I2C_ADDR = 0x1D,
@@ -98,6 +105,28 @@ typedef struct
   int16_t zAxis;
 } AxesRaw_t;
 
+typedef struct
+{
+  AxesRaw_t axes;
+  uint32_t  timestamp; // micros() when the sample was flagged ready
+  uint16_t  sequence;  // Fresh samples delivered by this die, wraps
+  uint8_t   flags;     // SAMPLE_FLAGS_t
+} AxesSample_t;
+
+typedef enum
+{
+  SAMPLE_OVERRUN = 0x01, // Conversions were overwritten before this one
+  SAMPLE_STALE   = 0x02  // No new conversion since the last read, repeat
+} SAMPLE_FLAGS_t;
+
+// Running totals per die, see LSM303C::accelStats()
+typedef struct
+{
+  uint32_t samples;  // Fresh samples read, low 16 bits are the sequence
+  uint32_t overruns; // Reads that found unread conversions overwritten
+  uint32_t dropped;  // Samples lost to a full queue
+} SampleStats_t;
+
 typedef enum
 {
   MODE_SPI,
@@ -129,6 +158,40 @@ typedef enum
   MAG_DO_80_Hz    = 0x1C
 } MAG_DO_t;
 
+// MAG_INT_CFG. Bit 3 is reserved and must stay set. Unlike the
+// accelerometer, MAG_INT_LIR set means *not* latched.
+typedef enum
+{
+  MAG_INT_IEN      = 0x01, // Drive INT_MAG
+  MAG_INT_LIR      = 0x02,
+  MAG_INT_IEA      = 0x04, // INT_MAG active high
+  MAG_INT_RESERVED = 0x08,
+  MAG_INT_Z        = 0x20,
+  MAG_INT_Y        = 0x40,
+  MAG_INT_X        = 0x80,
+  MAG_INT_ALL      = 0xE0
+} MAG_INT_CFG_t;
+
+// MAG_INT_SRC: which axis passed the threshold in which direction
+typedef enum
+{
+  MAG_INT_SRC_INT   = 0x01, // Interrupt event
+  MAG_INT_SRC_MROI  = 0x02, // Internal measurement range overflow
+  MAG_INT_SRC_NTH_Z = 0x04, // Below -threshold
+  MAG_INT_SRC_NTH_Y = 0x08,
+  MAG_INT_SRC_NTH_X = 0x10,
+  MAG_INT_SRC_PTH_Z = 0x20, // Above +threshold
+  MAG_INT_SRC_PTH_Y = 0x40,
+  MAG_INT_SRC_PTH_X = 0x80
+} MAG_INT_SRC_t;
+
+// Options for LSM303C::setMagInterrupt()
+typedef enum
+{
+  MAG_INT_LATCH      = 0x01, // Hold the event until the source is read
+  MAG_INT_ACTIVE_LOW = 0x02  // e.g. to wake an AVR from power-down
+} MAG_INT_OPTION_t;
+
 typedef enum
 { 
   MAG_FS_4_Ga   =  0x00,
@@ -189,7 +252,7 @@ typedef enum
   ACC_ODR_200_Hz      = 0x40,
   ACC_ODR_400_Hz      = 0x50,
   ACC_ODR_800_Hz      = 0x60,
-  ACC_ODR_MASK        = 0x60
+  ACC_ODR_MASK        = 0x70
 } ACC_ODR_t;
 
 typedef enum
@@ -212,4 +275,163 @@ typedef enum
   ACC_ZYX_OVERRUN             = 0x80
 } ACC_STATUS_FLAGS_t;
 
+typedef enum
+{ 
+  ACC_INT_XL_DRDY   = 0x01,
+  ACC_INT_XL_FTH    = 0x02,
+  ACC_INT_XL_OVR    = 0x04,
+  ACC_INT_XL_IG1    = 0x08,
+  ACC_INT_XL_IG2    = 0x10,
+  ACC_INT_XL_INACT  = 0x20,
+  ACC_STOP_FTH      = 0x40,
+  ACC_FIFO_EN       = 0x80
+} ACC_CTRL3_t;
+
+typedef enum
+{
+  ACC_HPIS2         = 0x01,
+  ACC_HPIS1         = 0x02,
+  ACC_FDS           = 0x04, // Filtered data to the output registers
+  ACC_HPM_NORMAL    = 0x00,
+  ACC_HPM_REFERENCE = 0x08, // Output = input - REFERENCE registers
+  ACC_HPM_MASK      = 0x18,
+  ACC_DFC_MASK      = 0x60
+} ACC_CTRL2_t;
+
+// On-chip high-pass cutoff as a fraction of the accelerometer ODR
+typedef enum
+{
+  ACC_DFC_ODR_50  = 0x00,
+  ACC_DFC_ODR_100 = 0x20,
+  ACC_DFC_ODR_9   = 0x40,
+  ACC_DFC_ODR_400 = 0x60
+} ACC_DFC_t;
+
+// IG_CFG1/IG_CFG2: axis events plus how they combine. OR fires when any
+// enabled event is true, AND only when all are. The 6D modes fire on a
+// change of orientation (movement) or while in one (position), with the
+// enabled events selecting which faces count.
+typedef enum
+{
+  ACC_IG_XL          = 0x01, // Below threshold
+  ACC_IG_XH          = 0x02, // Above threshold
+  ACC_IG_YL          = 0x04,
+  ACC_IG_YH          = 0x08,
+  ACC_IG_ZL          = 0x10,
+  ACC_IG_ZH          = 0x20,
+  ACC_IG_ALL_LOW     = 0x15,
+  ACC_IG_ALL_HIGH    = 0x2A,
+  ACC_IG_OR          = 0x00,
+  ACC_IG_6D_MOVEMENT = 0x40,
+  ACC_IG_AND         = 0x80,
+  ACC_IG_6D_POSITION = 0xC0
+} ACC_IG_CFG_t;
+
+// IG_SRC1/IG_SRC2: which events are true, IA when the generator fired
+typedef enum
+{
+  ACC_IG_SRC_XL = 0x01,
+  ACC_IG_SRC_XH = 0x02,
+  ACC_IG_SRC_YL = 0x04,
+  ACC_IG_SRC_YH = 0x08,
+  ACC_IG_SRC_ZL = 0x10,
+  ACC_IG_SRC_ZH = 0x20,
+  ACC_IG_SRC_IA = 0x40
+} ACC_IG_SRC_t;
+
+typedef enum
+{
+  ACC_IG1,
+  ACC_IG2
+} ACC_IG_t;
+
+// Options for LSM303C::setAccelInterrupt()
+typedef enum
+{
+  ACC_IG_PIN       = 0x01, // Drive INT_XL
+  ACC_IG_LATCH     = 0x02, // Hold the event until the source is read
+  ACC_IG_4D        = 0x04, // 6D modes ignore Z
+  ACC_IG_HIGH_PASS = 0x08, // Feed the generator high-passed data (no gravity)
+  ACC_IG_WAIT      = 0x10, // The event also has to clear for the duration
+  ACC_IG_DECREMENT = 0x20  // Duration counter counts down instead of resetting
+} ACC_IG_OPTION_t;
+
+typedef enum
+{
+  ACC_PP_OD     = 0x01, // Open-drain interrupt pins
+  ACC_H_LACTIVE = 0x02  // Active-low interrupt pins
+} ACC_CTRL5_t;
+
+typedef enum
+{
+  ACC_4D_IG1 = 0x01,
+  ACC_4D_IG2 = 0x02,
+  ACC_LIR1   = 0x04,
+  ACC_LIR2   = 0x08,
+  ACC_DCRM1  = 0x10,
+  ACC_DCRM2  = 0x20
+} ACC_CTRL7_t;
+
+typedef enum
+{ 
+  ACC_FIFO_BYPASS           = 0x00,
+  ACC_FIFO_FIFO             = 0x20,
+  ACC_FIFO_STREAM           = 0x40,
+  ACC_FIFO_STREAM_TO_FIFO   = 0x60,
+  ACC_FIFO_BYPASS_TO_STREAM = 0x80,
+  ACC_FIFO_BYPASS_TO_FIFO   = 0xE0,
+  ACC_FIFO_MODE_MASK        = 0xE0
+} ACC_FIFO_MODE_t;
+
+typedef enum
+{ 
+  ACC_FIFO_FSS_MASK = 0x1F,
+  ACC_FIFO_EMPTY    = 0x20,
+  ACC_FIFO_OVR      = 0x40,
+  ACC_FIFO_FTH      = 0x80
+} ACC_FIFO_SRC_t;
+
+// Accelerometer calibration blob, fixed layout so it can be stored as is
+// (EEPROM.put(), flash, a file on a host). Build it with
+// LSM303CAccelCalibrator, which also seals it with the checksum.
+typedef struct
+{
+  uint8_t   version;   // ACC_CAL_VERSION
+  uint8_t   fullScale; // ACC_FS_t the offsets were measured at
+  AxesRaw_t offset;    // Counts
+  int16_t   gain[3];   // Q14, 16384 = 1.0
+  uint8_t   checksum;  // CRC-8 of the bytes above
+  uint8_t   reserved;  // 0, keeps the blob 16 bytes on 8- and 32-bit targets
+} AccelCalibration_t;
+
+static_assert(sizeof(AccelCalibration_t) == 16,
+    "AccelCalibration_t is stored as is and must be the same everywhere");
+
+// Hard/soft-iron correction: out = (raw - offset) * gain / 2^14 per axis
+typedef struct
+{
+  AxesRaw_t offset; // Counts
+  int16_t   gain[3]; // Q14, 16384 = 1.0
+} MagCalibration_t;
+
+// Offset drift against temperature: drift = coefficient * (T - reference)
+// per axis, in counts at the full scale the readings use. Coefficients are
+// Q8 counts/˚C (256 = one count per degree).
+typedef struct
+{
+  int16_t referenceCentiC; // Temperature the offsets were calibrated at
+  int16_t accel[3];
+  int16_t mag[3];
+} TempCompensation_t;
+
+// Phase of an asynchronous sample read (LSM303C::pollSampleRead())
+typedef enum
+{
+  ASYNC_IDLE,
+  ASYNC_ACC_ADDRESS,
+  ASYNC_ACC_DATA,
+  ASYNC_MAG_ADDRESS,
+  ASYNC_MAG_DATA
+} ASYNC_STATE_t;
+
 #endif
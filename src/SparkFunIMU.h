@@ -14,6 +14,7 @@ typedef enum
   IMU_NOT_SUPPORTED,
   IMU_GENERIC_ERROR,
   IMU_OUT_OF_BOUNDS,
+  IMU_TIMEOUT,
   //...
 } status_t;
 
@@ -36,6 +37,13 @@ class SparkFunIMU
     virtual float readMagX()   { return NAN; }
     virtual float readMagY()   { return NAN; }
     virtual float readMagZ()   { return NAN; }
+    // Batch reads: all three axes from the same conversion
+    virtual status_t readGyroXYZ(float& x, float& y, float& z)
+      { x = y = z = NAN; return IMU_NOT_SUPPORTED; }
+    virtual status_t readAccelXYZ(float& x, float& y, float& z)
+      { x = y = z = NAN; return IMU_NOT_SUPPORTED; }
+    virtual status_t readMagXYZ(float& x, float& y, float& z)
+      { x = y = z = NAN; return IMU_NOT_SUPPORTED; }
     virtual float readTempC()  { return NAN; }
     virtual float readTempF()  { return NAN; }
 
@@ -1,6 +1,30 @@
 #include "SparkFunLSM303C.h"
+#include "LSM303CAccelCalibrator.h"
 #include "stdint.h"
 
+#if LSM303C_INSTRUMENTATION
+// Runs one bus call into ret and files it with busCounters, if any
+#define BUS_TIMED(chip, dir, len, ret, call) \
+  do { uint32_t busStart = busCounters ? micros() : 0; ret = call; \
+    if (busCounters) \
+      busCounters->record(chip, dir, len, micros() - busStart, ret); } while (0)
+// Split reads: time each phase, file the total once the read ends
+#define BUS_PHASE(ret, call) \
+  do { uint32_t busStart = micros(); ret = call; \
+    asyncBusMicros += micros() - busStart; } while (0)
+#define BUS_PHASES_DONE(chip, len, ret) \
+  do { if (busCounters) \
+      busCounters->record(chip, BUS_OP_READ, len, asyncBusMicros, ret); \
+    asyncBusMicros = 0; } while (0)
+#define BUS_PHASE_FAILED(chip, len, ret) \
+  do { if (ret != IMU_SUCCESS) BUS_PHASES_DONE(chip, len, ret); } while (0)
+#else
+#define BUS_TIMED(chip, dir, len, ret, call) do { ret = call; } while (0)
+#define BUS_PHASE(ret, call) do { ret = call; } while (0)
+#define BUS_PHASES_DONE(chip, len, ret) do { } while (0)
+#define BUS_PHASE_FAILED(chip, len, ret) do { } while (0)
+#endif
+
 // Public methods
 status_t LSM303C::begin()
 {
@@ -37,30 +61,40 @@ status_t LSM303C::begin(InterfaceMode_t im, MAG_DO_t modr, MAG_FS_t mfs,
 {
   uint8_t successes = 0;
   // Select I2C or SPI
-  interfaceMode = im;
+  if (!busFixed)
+  {
+#if LSM303C_HAS_BITBANG_SPI
+    bus = (im == MODE_SPI) ? (LSM303CBus*)&spiBus : (LSM303CBus*)&i2cBus;
+#else
+    // Only AVR has the built-in bit-banged SPI, use LSM303CHardwareSPIBus
+    if (im == MODE_SPI)
+    {
+      return IMU_NOT_SUPPORTED;
+    }
+    bus = &i2cBus;
+#endif
+  }
+  interfaceMode = bus->mode();
+  bus->attachStats(busCounters);
+  successes += bus->begin();
 
   if (interfaceMode == MODE_SPI)
   {
-    debug_println("Setting up SPI");
-    // Setup pins for SPI
-    // CS & CLK must be outputs DDRxn = 1
-    bitSet(DIR_REG, CSBIT_MAG);
-    bitSet(DIR_REG, CSBIT_XL);
-    bitSet(DIR_REG, CLKBIT);
-    // Deselect SPI chips
-    bitSet(CSPORT_MAG, CSBIT_MAG);
-    bitSet(CSPORT_XL, CSBIT_XL);
-    // Clock polarity (CPOL) = 1
-    bitSet(CLKPORT, CLKBIT);
     // SPI Serial Interface Mode (SIM) bits must be set
-    SPI_WriteByte(ACC, ACC_CTRL4, 0b111);
-    SPI_WriteByte(MAG, MAG_CTRL_REG3, _BV(2));
+    successes += ACC_WriteReg(ACC_CTRL4, 0b111);
+    successes += MAG_WriteReg(MAG_CTRL_REG3, _BV(2));
   }
   else
   {
     //I2C Mode
     //initialize I2C bus and clock stretch in the setup()
   }
+
+  // Start from what the chip actually holds, stage every setting in the
+  // shadow registers, then push them out in one burst per die
+  successes += syncRegisters();
+  deferWrites = true;
+
   ////////// Initialize Magnetometer //////////
   // Initialize magnetometer output data rate
   successes += MAG_SetODR(modr);
@@ -85,6 +119,9 @@ status_t LSM303C::begin(InterfaceMode_t im, MAG_DO_t modr, MAG_FS_t mfs,
   // Initialize accelerometer output data rate
   successes += ACC_SetODR(aodr);
 
+  deferWrites = false;
+  successes += flushRegisters();
+
   return (successes == IMU_SUCCESS) ? IMU_SUCCESS : IMU_HW_ERROR;
 }
 
@@ -105,152 +142,152 @@ float LSM303C::readMagZ()
 
 float LSM303C::readAccelX()
 {
-  uint8_t flag_ACC_STATUS_FLAGS;
-  status_t response = ACC_Status_Flags(flag_ACC_STATUS_FLAGS);
-  
+  return readAccel(xAxis);
+}
+
+float LSM303C::readAccelY()
+{
+  return readAccel(yAxis);
+}
+
+float LSM303C::readAccelZ()
+{
+  return readAccel(zAxis);
+}
+
+// All three axes of one conversion from a single status+data burst
+status_t LSM303C::readAccelXYZ(float& x, float& y, float& z)
+{
+  status_t response = updateAccel();
+
   if (response != IMU_SUCCESS)
   {
-    debug_println(AERROR);
-    return NAN;
+    x = y = z = NAN;
+    return response;
   }
-  
-  // Check for new data in the status flags with a mask
-  // If there isn't new data use the last data read.
-  // There are valid cases for this, like reading faster than refresh rate.
-  if (flag_ACC_STATUS_FLAGS & ACC_X_NEW_DATA_AVAILABLE)
-  {
-    uint8_t valueL;
-    uint8_t valueH;
-
-    if ( ACC_ReadReg(ACC_OUT_X_H, valueH) )
-    {
-	    return IMU_HW_ERROR;
-    }
-  
-    if ( ACC_ReadReg(ACC_OUT_X_L, valueL) )
-    {
-	    return IMU_HW_ERROR;
-    }
-  
-    debug_println("Fresh raw data");
 
-    //convert from LSB to mg
-    return int16_t(( (valueH << 8) | valueL )) * SENSITIVITY_ACC;
-  }
+  //convert from LSB to mg
+  float scale = accelSensitivity();
+  x = accelCorrected.xAxis * scale;
+  y = accelCorrected.yAxis * scale;
+  z = accelCorrected.zAxis * scale;
 
-  // Should never get here
-  debug_println("Returning NAN");
-  return NAN;
+  return IMU_SUCCESS;
 }
 
-float LSM303C::readAccelY()
+status_t LSM303C::readMagXYZ(float& x, float& y, float& z)
 {
-  uint8_t flag_ACC_STATUS_FLAGS;
-  status_t response = ACC_Status_Flags(flag_ACC_STATUS_FLAGS);
-  
+  status_t response = updateMag();
+
   if (response != IMU_SUCCESS)
   {
-    debug_println(AERROR);
-    return NAN;
+    x = y = z = NAN;
+    return response;
   }
-  
-  // Check for new data in the status flags with a mask
-  // If there isn't new data use the last data read.
-  // There are valid cases for this, like reading faster than refresh rate.
-  if (flag_ACC_STATUS_FLAGS & ACC_Y_NEW_DATA_AVAILABLE)
-  {
-    uint8_t valueL;
-    uint8_t valueH;
 
-    if ( ACC_ReadReg(ACC_OUT_Y_H, valueH) )
-    {
-	    return IMU_HW_ERROR;
-    }
-  
-    if ( ACC_ReadReg(ACC_OUT_Y_L, valueL) )
-    {
-	    return IMU_HW_ERROR;
-    }
-  
-    debug_println("Fresh raw data");
+  //convert from LSB to Gauss
+  float scale = magSensitivity();
+  x = magCorrected.xAxis * scale;
+  y = magCorrected.yAxis * scale;
+  z = magCorrected.zAxis * scale;
+
+  return IMU_SUCCESS;
+}
+
+status_t LSM303C::readAccelRaw(AxesRaw_t& axes)
+{
+  status_t response = updateAccel();
 
-    //convert from LSB to mg
-    return int16_t(( (valueH << 8) | valueL )) * SENSITIVITY_ACC;
+  if (response == IMU_SUCCESS)
+  {
+    axes = accelData;
   }
 
-  // Should never get here
-  debug_println("Returning NAN");
-  return NAN;
+  return response;
 }
 
-float LSM303C::readAccelZ()
+status_t LSM303C::readMagRaw(AxesRaw_t& axes)
 {
-  uint8_t flag_ACC_STATUS_FLAGS;
-  status_t response = ACC_Status_Flags(flag_ACC_STATUS_FLAGS);
-  
-  if (response != IMU_SUCCESS)
+  status_t response = updateMag();
+
+  if (response == IMU_SUCCESS)
   {
-    debug_println(AERROR);
-    return NAN;
+    axes = magData;
   }
-  
-  // Check for new data in the status flags with a mask
-  // If there isn't new data use the last data read.
-  // There are valid cases for this, like reading faster than refresh rate.
-  if (flag_ACC_STATUS_FLAGS & ACC_Z_NEW_DATA_AVAILABLE)
-  {
-    uint8_t valueL;
-    uint8_t valueH;
 
-    if ( ACC_ReadReg(ACC_OUT_Z_H, valueH) )
-    {
-	    return IMU_HW_ERROR;
-    }
-  
-    if ( ACC_ReadReg(ACC_OUT_Z_L, valueL) )
-    {
-	    return IMU_HW_ERROR;
-    }
-  
-    debug_println("Fresh raw data");
+  return response;
+}
+
+status_t LSM303C::readAccelSample(AxesSample_t& sample)
+{
+  status_t response = updateAccel();
 
-    //convert from LSB to mg
-    return(int16_t(( (valueH << 8) | valueL )) * SENSITIVITY_ACC);
+  if (response == IMU_SUCCESS)
+  {
+    sample.axes = accelData;
+    sample.timestamp = accelTime;
+    stampSample(sample, accelCounters, accelFlags);
   }
 
-  // Should never get here
-  debug_println("Returning NAN");
-  return NAN;
+  return response;
 }
 
-
-float LSM303C::readTempC()
+status_t LSM303C::readMagSample(AxesSample_t& sample)
 {
-  uint8_t valueL;
-  uint8_t valueH;
-  float temperature;
+  status_t response = updateMag();
 
-  // Make sure temperature sensor is enabled
-  if( MAG_TemperatureEN(MAG_TEMP_EN_ENABLE))
+  if (response == IMU_SUCCESS)
   {
-    return NAN;
+    sample.axes = magData;
+    sample.timestamp = magTime;
+    stampSample(sample, magCounters, magFlags);
   }
 
-	if( MAG_ReadReg(MAG_TEMP_OUT_L, valueL) )
+  return response;
+}
+
+void LSM303C::resetStats()
+{
+  noInterrupts();
+  accelCounters.samples = accelCounters.overruns = accelCounters.dropped = 0;
+  magCounters.samples = magCounters.overruns = magCounters.dropped = 0;
+  interrupts();
+}
+
+uint8_t LSM303C::countSample(SampleStats_t& stats, bool overrun)
+{
+  stats.samples++;
+  if (overrun)
   {
-    return NAN;
+    stats.overruns++;
+    return SAMPLE_OVERRUN;
   }
+  return 0;
+}
+
+// The sequence number of the newest fresh sample is the low half of the
+// running sample count
+void LSM303C::stampSample(AxesSample_t& sample, const SampleStats_t& stats,
+    uint8_t flags)
+{
+  sample.sequence = (uint16_t)(stats.samples - 1);
+  sample.flags = flags;
+}
+
+
+float LSM303C::readTempC()
+{
+  int16_t raw;
 
-  if( MAG_ReadReg(MAG_TEMP_OUT_H, valueH) )
+  // NAN on failure, getStatus() says why (IMU_TIMEOUT, ...)
+  driverStatus = readTempRaw(raw);
+  if (driverStatus != IMU_SUCCESS)
   {
     return NAN;
   }
 
-  temperature = (float)( (valueH << 8) | valueL );
-  temperature /= 8; // 8 digits/˚C
-  temperature += 25;// Reads 0 @ 25˚C
-
-  return temperature;  
+  // 8 digits/˚C, reads 0 @ 25˚C
+  return raw / 8.0 + 25;
 }
 
 float LSM303C::readTempF()
@@ -258,360 +295,471 @@ float LSM303C::readTempF()
   return( (readTempC() * 9.0 / 5.0) + 32.0);
 }
 
+status_t LSM303C::setTempInterval(uint16_t ms)
+{
+  debug_print(EMPTY);
+  tempInterval = ms;
+  tempValid = false;
 
+  // Left on from here, so the bundled reads always find a fresh value
+  return MAG_TemperatureEN(MAG_TEMP_EN_ENABLE);
+}
 
-////////////////////////////////////////////////////////////////////////////////
-////// Protected methods
-
-float LSM303C::readAccel(AXIS_t dir)
+status_t LSM303C::readTempRaw(int16_t& raw)
 {
-  uint8_t flag_ACC_STATUS_FLAGS;
-  status_t response = ACC_Status_Flags(flag_ACC_STATUS_FLAGS);
-  
-  if (response != IMU_SUCCESS)
-  {
-    debug_println(AERROR);
-    return NAN;
-  }
-  
-  // Check for new data in the status flags with a mask
-  // If there isn't new data use the last data read.
-  // There are valid cases for this, like reading faster than refresh rate.
-  if (flag_ACC_STATUS_FLAGS & ACC_ZYX_NEW_DATA_AVAILABLE)
+  if (tempInterval && tempValid && millis() - tempTime < tempInterval)
   {
-    response = ACC_GetAccRaw(accelData);
-    debug_println("Fresh raw data");
+    raw = tempRaw;
+    return IMU_SUCCESS;
   }
-  //convert from LSB to mg
-  switch (dir)
+
+  status_t ret = MAG_GetTempRaw(raw);
+
+  if (ret != IMU_SUCCESS)
   {
-  case xAxis:
-    return accelData.xAxis * SENSITIVITY_ACC;
-    break;
-  case yAxis:
-    return accelData.yAxis * SENSITIVITY_ACC;
-    break;
-  case zAxis:
-    return accelData.zAxis * SENSITIVITY_ACC;
-    break;
-  default:
-    return NAN;
+    return ret;
   }
 
-  // Should never get here
-  debug_println("Returning NAN");
-  return NAN;
+  refreshTemp(raw);
+  return IMU_SUCCESS;
 }
 
-float LSM303C::readMag(AXIS_t dir)
+// Scale factors indexed by the full scale bits of the shadow registers.
+// Output = raw * mul >> shift, which is exact since every full scale is a
+// whole number of units over 2^15 counts.
+typedef struct
 {
-  MAG_XYZDA_t flag_MAG_XYZDA;
-  status_t response = MAG_XYZ_AxDataAvailable(flag_MAG_XYZDA);
-  
-  if (response != IMU_SUCCESS)
-  {
-    debug_println(MERROR);
-    return NAN;
-  }
-  
-  // Check for new data in the status flags with a mask
-  if (flag_MAG_XYZDA & MAG_XYZDA_YES)
-  {
-    response = MAG_GetMagRaw(magData);
-    debug_println("Fresh raw data");
-  }
-  //convert from LSB to Gauss
-  switch (dir)
-  {
-  case xAxis:
-    return magData.xAxis * SENSITIVITY_MAG;
-    break;
-  case yAxis:
-    return magData.yAxis * SENSITIVITY_MAG;
-    break;
-  case zAxis:
-    return magData.zAxis * SENSITIVITY_MAG;
-    break;
-  default:
-    return NAN;
-  }
+  uint8_t mul;
+  uint8_t shift;
+  float   sensitivity;
+} FixedScale_t;
 
-  // Should never get here
-  debug_println("Returning NAN");
-  return NAN;
+// ACC_CTRL4 FS[5:4]: 2 g, (reserved, treated as 2 g), 4 g, 8 g -> mg
+static const FixedScale_t ACC_SCALE[4] =
+{
+  {125, 11, 0.06103515625},
+  {125, 11, 0.06103515625},
+  {125, 10, 0.1220703125},
+  {125,  9, 0.244140625}
+};
+
+// MAG_CTRL_REG2 FS[6:5]: 4, 8, 12, 16 gauss -> uT (1 gauss = 100 uT)
+static const FixedScale_t MAG_SCALE[4] =
+{
+  {25, 11, 0.0001220703125},
+  {25, 10, 0.000244140625},
+  {75, 11, 0.0003662109375},
+  {25,  9, 0.00048828125}
+};
+
+static inline const FixedScale_t& accScale(const uint8_t* ctrl)
+{
+  return ACC_SCALE[(ctrl[ACC_CTRL4 - ACC_CTRL1] >> 4) & 0x03];
 }
 
-status_t LSM303C::MAG_GetMagRaw(AxesRaw_t& buff)
+static inline const FixedScale_t& magScale(const uint8_t* ctrl)
 {
-  debug_print(EMPTY);
-  uint8_t valueL;
-  uint8_t valueH;
-  
-  debug_println("& was false");
-  if( MAG_ReadReg(MAG_OUTX_L, valueL) )
-  {
-    return IMU_HW_ERROR;
-  }
+  return MAG_SCALE[(ctrl[MAG_CTRL_REG2 - MAG_CTRL_REG1] >> 5) & 0x03];
+}
 
-  if( MAG_ReadReg(MAG_OUTX_H, valueH) )
-  {
-    return IMU_HW_ERROR;
-  }
+// Clamps to the int16_t range instead of letting the cast wrap
+static inline int16_t saturate(int32_t value)
+{
+  return (int16_t)((value > 32767) ? 32767 : (value < -32768) ? -32768 : value);
+}
 
-  buff.xAxis = (int16_t)( (valueH << 8) | valueL );
-  
-  if( MAG_ReadReg(MAG_OUTY_L, valueL) )
-  {
-    return IMU_HW_ERROR;
-  }
+static inline void scaleAxes(const AxesRaw_t& in, AxesRaw_t& out,
+    const FixedScale_t& scale)
+{
+  out.xAxis = (int16_t)(((int32_t)in.xAxis * scale.mul) >> scale.shift);
+  out.yAxis = (int16_t)(((int32_t)in.yAxis * scale.mul) >> scale.shift);
+  out.zAxis = (int16_t)(((int32_t)in.zAxis * scale.mul) >> scale.shift);
+}
 
-  if( MAG_ReadReg(MAG_OUTY_H, valueH) )
+status_t LSM303C::setAccelCalibration(const AccelCalibration_t& cal,
+    bool useReference)
+{
+  if (!LSM303CAccelCalibrator::valid(cal) ||
+      cal.fullScale != (accCtrl[ACC_CTRL4 - ACC_CTRL1] & ACC_FS_8g))
   {
-    return IMU_HW_ERROR;
+    return IMU_GENERIC_ERROR;
   }
 
-  buff.yAxis = (int16_t)( (valueH << 8) | valueL );
-  
-  if( MAG_ReadReg(MAG_OUTZ_L, valueL) )
+  accelCal = cal;
+  if (useReference)
   {
-    return IMU_HW_ERROR;
+    // REFERENCE registers are little-endian like the outputs, X, Y, Z
+    uint8_t ref[6] =
+    {
+      (uint8_t)cal.offset.xAxis, (uint8_t)(cal.offset.xAxis >> 8),
+      (uint8_t)cal.offset.yAxis, (uint8_t)(cal.offset.yAxis >> 8),
+      (uint8_t)cal.offset.zAxis, (uint8_t)(cal.offset.zAxis >> 8)
+    };
+    if (ACC_WriteRegs(ACC_XL_REFERENCE, ref, sizeof(ref)) ||
+        ACC_UpdateReg(ACC_CTRL2, ACC_HPM_MASK | ACC_FDS,
+            ACC_HPM_REFERENCE | ACC_FDS))
+    {
+      return IMU_HW_ERROR;
+    }
+    // The chip subtracts them now
+    accelCal.offset.xAxis = accelCal.offset.yAxis = accelCal.offset.zAxis = 0;
   }
-
-  if( MAG_ReadReg(MAG_OUTZ_H, valueH) )
+  else if (releaseAccelReference())
   {
     return IMU_HW_ERROR;
   }
 
-  buff.zAxis = (int16_t)( (valueH << 8) | valueL );
-
+  accelCalEnabled = accelCal.offset.xAxis || accelCal.offset.yAxis ||
+      accelCal.offset.zAxis || accelCal.gain[0] != 16384 ||
+      accelCal.gain[1] != 16384 || accelCal.gain[2] != 16384;
+  correctAccel(accelData, accelCorrected);
   return IMU_SUCCESS;
 }
 
-// Methods required to get device up and running
-status_t LSM303C::MAG_SetODR(MAG_DO_t val)
+status_t LSM303C::clearAccelCalibration()
 {
-  debug_print(EMPTY);
-  uint8_t value;
+  accelCalEnabled = false;
+  correctAccel(accelData, accelCorrected);
+  return releaseAccelReference();
+}
+
+// Zeroes the REFERENCE registers and returns the filter to normal mode.
+// A high-pass set up by setAccelHighPass() is left alone.
+status_t LSM303C::releaseAccelReference()
+{
+  const uint8_t zero[6] = {0, 0, 0, 0, 0, 0};
 
-  if(MAG_ReadReg(MAG_CTRL_REG1, value))
+  if (!accelReferenceActive())
   {
-    debug_printlns("Failed Read from MAG_CTRL_REG1");
-    return IMU_HW_ERROR;
+    return IMU_SUCCESS;
   }
-
-  // Mask and only change DO0 bits (4:2) of MAG_CTRL_REG1
-  value &= ~MAG_DO_80_Hz;
-  value |= val;
-
-  if(MAG_WriteReg(MAG_CTRL_REG1, value))
+  if (ACC_UpdateReg(ACC_CTRL2, ACC_HPM_MASK | ACC_FDS, ACC_HPM_NORMAL) ||
+      ACC_WriteRegs(ACC_XL_REFERENCE, zero, sizeof(zero)))
   {
     return IMU_HW_ERROR;
   }
-
   return IMU_SUCCESS;
 }
 
-status_t LSM303C::MAG_SetFullScale(MAG_FS_t val)
+status_t LSM303C::setAccelHighPass(ACC_DFC_t cutoff)
 {
-  debug_print(EMPTY);
-  uint8_t value;
+  uint8_t ref;
 
-  if ( MAG_ReadReg(MAG_CTRL_REG2, value) )
+  if (accelReferenceActive())
+  {
+    return IMU_GENERIC_ERROR;
+  }
+
+  if (ACC_UpdateReg(ACC_CTRL2, ACC_DFC_MASK | ACC_HPM_MASK | ACC_FDS,
+        cutoff | ACC_HPM_NORMAL | ACC_FDS))
   {
     return IMU_HW_ERROR;
   }
 
-  value &= ~MAG_FS_16_Ga; //mask
-  value |= val;	
+  // In normal mode reading REFERENCE resets the filter, so it starts from
+  // the current input instead of settling from whatever it held
+  return ACC_ReadReg(ACC_XL_REFERENCE, ref);
+}
 
-  if ( MAG_WriteReg(MAG_CTRL_REG2, value) )
+status_t LSM303C::clearAccelHighPass()
+{
+  if (accelReferenceActive())
   {
-    return IMU_HW_ERROR;
+    return IMU_SUCCESS;
   }
 
-  return IMU_SUCCESS;
+  return ACC_UpdateReg(ACC_CTRL2, ACC_FDS, 0);
 }
 
-status_t LSM303C::MAG_BlockDataUpdate(MAG_BDU_t val)
+// 8 digits/˚C -> 12.5 centi-degrees per digit, reads 0 @ 25˚C
+static inline int16_t tempCentiC(int16_t raw)
 {
-  debug_print(EMPTY);
-  uint8_t value;
+  return (int16_t)((((int32_t)raw * 25) >> 1) + 2500);
+}
+
+// Q8 counts/˚C times hundredths of a degree, rounded to counts
+static void driftAxes(const int16_t* coeff, int32_t deltaCentiC,
+    AxesRaw_t& drift)
+{
+  int16_t* axes[3] = {&drift.xAxis, &drift.yAxis, &drift.zAxis};
 
-  if ( MAG_ReadReg(MAG_CTRL_REG5, value) )
+  for (uint8_t i = 0; i < 3; i++)
   {
-    return IMU_HW_ERROR;
+    int32_t v = coeff[i] * deltaCentiC;
+    *axes[i] = (int16_t)((v + (v < 0 ? -12800 : 12800)) / 25600);
   }
+}
 
+void LSM303C::refreshTemp(int16_t raw)
+{
+  tempRaw = raw;
+  tempTime = millis();
+  tempValid = true;
 
-  value &= ~MAG_BDU_ENABLE; //mask
-  value |= val;		
-
-  if ( MAG_WriteReg(MAG_CTRL_REG5, value) )
+  if (!tempCompEnabled)
   {
-    return IMU_HW_ERROR;
+    return;
   }
 
-  return IMU_SUCCESS;
+  int32_t delta = tempCentiC(raw) - tempComp.referenceCentiC;
+  driftAxes(tempComp.accel, delta, accelDrift);
+  driftAxes(tempComp.mag, delta, magDrift);
+  correctAccel(accelData, accelCorrected);
+  correctMag(magData, magCorrected);
 }
 
-status_t LSM303C::MAG_XYZ_AxDataAvailable(MAG_XYZDA_t& value)
+void LSM303C::setTempCompensation(const TempCompensation_t& comp)
 {
-  if ( MAG_ReadReg(MAG_STATUS_REG, (uint8_t&)value) )
+  tempComp = comp;
+  tempCompEnabled = true;
+  if (tempValid)
   {
-    return IMU_HW_ERROR;
+    refreshTemp(tempRaw);
   }
+}
 
-  value = (MAG_XYZDA_t)((int8_t)value & (int8_t)MAG_XYZDA_YES);
-
-  return IMU_SUCCESS;
+void LSM303C::clearTempCompensation()
+{
+  tempCompEnabled = false;
+  accelDrift.xAxis = accelDrift.yAxis = accelDrift.zAxis = 0;
+  magDrift.xAxis = magDrift.yAxis = magDrift.zAxis = 0;
+  correctAccel(accelData, accelCorrected);
+  correctMag(magData, magCorrected);
 }
 
-status_t LSM303C::MAG_XY_AxOperativeMode(MAG_OMXY_t val)
+// Drift is zero unless temperature compensation is on
+void LSM303C::correctAccel(const AxesRaw_t& raw, AxesRaw_t& out) const
 {
-  debug_print(EMPTY);
+  // Saturated first so (x - offset) * gain below can't overflow 32 bits
+  int32_t x = saturate((int32_t)raw.xAxis - accelDrift.xAxis);
+  int32_t y = saturate((int32_t)raw.yAxis - accelDrift.yAxis);
+  int32_t z = saturate((int32_t)raw.zAxis - accelDrift.zAxis);
 
-  uint8_t value;
-
-  if ( MAG_ReadReg(MAG_CTRL_REG1, value) )
+  if (!accelCalEnabled)
   {
-    return IMU_HW_ERROR;
+    out.xAxis = (int16_t)x;
+    out.yAxis = (int16_t)y;
+    out.zAxis = (int16_t)z;
+    return;
   }
-	
-  value &= ~MAG_OMXY_ULTRA_HIGH_PERFORMANCE; //mask
-  value |= val;	
 
-  if ( MAG_WriteReg(MAG_CTRL_REG1, value) )
-  {
-    return IMU_HW_ERROR;
-  }
+  out.xAxis = saturate(((x - accelCal.offset.xAxis) * accelCal.gain[0]) >> 14);
+  out.yAxis = saturate(((y - accelCal.offset.yAxis) * accelCal.gain[1]) >> 14);
+  out.zAxis = saturate(((z - accelCal.offset.zAxis) * accelCal.gain[2]) >> 14);
+}
 
-  return IMU_SUCCESS;
+void LSM303C::setMagCalibration(const MagCalibration_t& cal)
+{
+  magCal = cal;
+  magCalEnabled = true;
+  correctMag(magData, magCorrected);
 }
 
-status_t LSM303C::MAG_Z_AxOperativeMode(MAG_OMZ_t val)
+void LSM303C::correctMag(const AxesRaw_t& raw, AxesRaw_t& out) const
 {
-  debug_print(EMPTY);
-  uint8_t value;
+  int32_t x = saturate((int32_t)raw.xAxis - magDrift.xAxis);
+  int32_t y = saturate((int32_t)raw.yAxis - magDrift.yAxis);
+  int32_t z = saturate((int32_t)raw.zAxis - magDrift.zAxis);
 
-  if ( MAG_ReadReg(MAG_CTRL_REG4, value) )
+  if (!magCalEnabled)
   {
-    return IMU_HW_ERROR;
+    out.xAxis = (int16_t)x;
+    out.yAxis = (int16_t)y;
+    out.zAxis = (int16_t)z;
+    return;
   }
 
-  value &= ~MAG_OMZ_ULTRA_HIGH_PERFORMANCE; //mask
-  value |= val;	
+  out.xAxis = saturate(((x - magCal.offset.xAxis) * magCal.gain[0]) >> 14);
+  out.yAxis = saturate(((y - magCal.offset.yAxis) * magCal.gain[1]) >> 14);
+  out.zAxis = saturate(((z - magCal.offset.zAxis) * magCal.gain[2]) >> 14);
+}
+
+float LSM303C::accelSensitivity() const
+{
+  return accScale(accCtrl).sensitivity;
+}
+
+float LSM303C::magSensitivity() const
+{
+  return magScale(magCtrl).sensitivity;
+}
+
+void LSM303C::accelMilliG(const AxesRaw_t& raw, AxesRaw_t& mg) const
+{
+  scaleAxes(raw, mg, accScale(accCtrl));
+}
+
+void LSM303C::magMicroTesla(const AxesRaw_t& raw, AxesRaw_t& uT) const
+{
+  scaleAxes(raw, uT, magScale(magCtrl));
+}
+
+status_t LSM303C::readAccelMilliG(AxesRaw_t& mg)
+{
+  status_t response = updateAccel();
 
-  if ( MAG_WriteReg(MAG_CTRL_REG4, value) )
+  if (response == IMU_SUCCESS)
   {
-    return IMU_HW_ERROR;
+    accelMilliG(accelCorrected, mg);
   }
 
-  return IMU_SUCCESS;
+  return response;
 }
 
-status_t LSM303C::MAG_SetMode(MAG_MD_t val)
+status_t LSM303C::readMagMicroTesla(AxesRaw_t& uT)
 {
-  debug_print(EMPTY);
-  uint8_t value;
+  status_t response = updateMag();
 
-  if ( MAG_ReadReg(MAG_CTRL_REG3, value) )
+  if (response == IMU_SUCCESS)
   {
-    debug_print("Failed to read MAG_CTRL_REG3. 'Read': 0x");
-    debug_printlns(value, HEX);
-    return IMU_HW_ERROR;
+    magMicroTesla(magCorrected, uT);
   }
 
-  value &= ~MAG_MD_POWER_DOWN_2;
-  value |= val;		
+  return response;
+}
+
+status_t LSM303C::readTempCentiC(int16_t& centiC)
+{
+  int16_t raw;
+
+  status_t ret = readTempRaw(raw);
 
-  if ( MAG_WriteReg(MAG_CTRL_REG3, value) )
+  if (ret != IMU_SUCCESS)
   {
-    return IMU_HW_ERROR;
+    return ret;
   }
 
+  centiC = tempCentiC(raw);
   return IMU_SUCCESS;
 }
 
-status_t LSM303C::ACC_SetFullScale(ACC_FS_t val)
+status_t LSM303C::syncRegisters()
 {
   debug_print(EMPTY);
-  uint8_t value;
 
-  if ( ACC_ReadReg(ACC_CTRL4, value) )
+  if ( ACC_ReadRegs(ACC_CTRL1, accCtrl, ACC_CTRL_COUNT) )
   {
-    debug_printlns("Failed ACC read");
+    debug_println(AERROR);
     return IMU_HW_ERROR;
   }
 
-  value &= ~ACC_FS_8g;
-  value |= val;	
-
-
-  if ( ACC_WriteReg(ACC_CTRL4, value) )
+  if ( MAG_ReadRegs(MAG_CTRL_REG1, magCtrl, MAG_CTRL_COUNT) )
   {
+    debug_println(MERROR);
     return IMU_HW_ERROR;
   }
 
+  accDirty = 0;
+  magDirty = 0;
+
   return IMU_SUCCESS;
 }
 
-status_t LSM303C::ACC_BlockDataUpdate(ACC_BDU_t val)
+// Self-clearing bits (SOFT_RESET, BOOT, REBOOT, SOFT_RST) and the mag mode,
+// which changes on its own after a single conversion, are not compared
+static const uint8_t ACC_CTRL_VERIFY_MASK[ACC_CTRL_COUNT] =
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xBF, 0x7F, 0xFF};
+static const uint8_t MAG_CTRL_VERIFY_MASK[MAG_CTRL_COUNT] =
+    {0xFF, 0xF3, 0xFC, 0xFF, 0xFF};
+
+status_t LSM303C::verifyRegisters()
 {
   debug_print(EMPTY);
-  uint8_t value;
+  uint8_t acc[ACC_CTRL_COUNT];
+  uint8_t mag[MAG_CTRL_COUNT];
 
-  if ( ACC_ReadReg(ACC_CTRL1, value) )
+  if ( ACC_ReadRegs(ACC_CTRL1, acc, ACC_CTRL_COUNT) ||
+       MAG_ReadRegs(MAG_CTRL_REG1, mag, MAG_CTRL_COUNT) )
   {
     return IMU_HW_ERROR;
   }
 
-  value &= ~ACC_BDU_ENABLE;
-  value |= val;	
+  for (uint8_t i = 0; i < ACC_CTRL_COUNT; i++)
+  {
+    if ((acc[i] ^ accCtrl[i]) & ACC_CTRL_VERIFY_MASK[i])
+    {
+      debug_print("ACC_CTRL mismatch at index ");
+      debug_printlns(i);
+      return IMU_GENERIC_ERROR;
+    }
+  }
 
-  if ( ACC_WriteReg(ACC_CTRL1, value) )
+  for (uint8_t i = 0; i < MAG_CTRL_COUNT; i++)
   {
-    return IMU_HW_ERROR;
+    if ((mag[i] ^ magCtrl[i]) & MAG_CTRL_VERIFY_MASK[i])
+    {
+      debug_print("MAG_CTRL mismatch at index ");
+      debug_printlns(i);
+      return IMU_GENERIC_ERROR;
+    }
   }
 
   return IMU_SUCCESS;
 }
 
-status_t LSM303C::ACC_EnableAxis(uint8_t val)
+status_t LSM303C::recoverBus()
 {
   debug_print(EMPTY);
-  uint8_t value;
+  status_t ret;
+
+  recovering = true;
+  recoveryCount++;
+  // A split read in flight died with the bus
+  asyncState = ASYNC_IDLE;
+  asyncBusMicros = 0;
 
-  if ( ACC_ReadReg(ACC_CTRL1, value) )
+  ret = bus->recover();
+  if (ret == IMU_SUCCESS)
   {
-    debug_println(AERROR);
-    return IMU_HW_ERROR;
+    // Whatever the chip holds now, put the known configuration back
+    accDirty = (1 << ACC_CTRL_COUNT) - 1;
+    magDirty = (1 << MAG_CTRL_COUNT) - 1;
+    ret = flushRegisters();
   }
 
-  value &= ~0x07;
-  value |= val;	
+  recovering = false;
+  return ret;
+}
+
+status_t LSM303C::setBusStats(LSM303CBusStats* stats)
+{
+#if LSM303C_INSTRUMENTATION
+  busCounters = stats;
+  bus->attachStats(stats);
+  return IMU_SUCCESS;
+#else
+  return stats ? IMU_NOT_SUPPORTED : IMU_SUCCESS;
+#endif
+}
 
-  if ( ACC_WriteReg(ACC_CTRL1, value) )
+// The timeout still goes back to the caller, recovery only makes sure the
+// next access finds a working bus
+status_t LSM303C::checkBus(status_t ret)
+{
+  if (ret == IMU_TIMEOUT && autoRecover && !recovering)
   {
-    return IMU_HW_ERROR;
+    recoverBus();
   }
-
-  return IMU_SUCCESS;
+  return ret;
 }
 
-status_t LSM303C::ACC_SetODR(ACC_ODR_t val)
+status_t LSM303C::enableAccelFifo(ACC_FIFO_MODE_t mode, uint8_t watermark)
 {
   debug_print(EMPTY);
-  uint8_t value;
 
-  if ( ACC_ReadReg(ACC_CTRL1, value) )
+  if (watermark > ACC_FIFO_FSS_MASK)
+  {
+    return IMU_OUT_OF_BOUNDS;
+  }
+
+  // Bypass mode leaves the FIFO switched off entirely
+  if ( ACC_UpdateReg(ACC_CTRL3, ACC_FIFO_EN,
+         (mode == ACC_FIFO_BYPASS) ? 0 : ACC_FIFO_EN) )
   {
     return IMU_HW_ERROR;
   }
 
-  value &= ~ACC_ODR_MASK;
-  value |= val;	
-	
-  if ( ACC_WriteReg(ACC_CTRL1, value) )
+  if ( ACC_WriteReg(ACC_FIFO_CTRL, mode | watermark) )
   {
     return IMU_HW_ERROR;
   }
@@ -619,393 +767,1103 @@ status_t LSM303C::ACC_SetODR(ACC_ODR_t val)
   return IMU_SUCCESS;
 }
 
-status_t LSM303C::MAG_TemperatureEN(MAG_TEMP_EN_t val){
+status_t LSM303C::accelFifoLevel(uint8_t& level)
+{
   uint8_t value;
 
-  if( MAG_ReadReg(MAG_CTRL_REG1, value) )
-  {
-    return IMU_HW_ERROR;
-  }
+  return ACC_GetFifoSrc(level, value);
+}
 
-  value &= ~MAG_TEMP_EN_ENABLE; //mask
-  value |= val;	
+// Reads FIFO_SRC and decodes the number of stored samples
+status_t LSM303C::ACC_GetFifoSrc(uint8_t& level, uint8_t& value)
+{
+  status_t ret = ACC_ReadReg(ACC_FIFO_SRC, value);
 
-  if( MAG_WriteReg(MAG_CTRL_REG1, value) )
+  if (ret != IMU_SUCCESS)
   {
-    return IMU_HW_ERROR;
+    return ret;
   }
 
-  return IMU_SUCCESS;
-}
-
-status_t LSM303C::MAG_ReadReg(MAG_REG_t reg, uint8_t& data)
-{
-  debug_print("Reading register 0x");
-  debug_printlns(reg, HEX);
-  status_t ret = IMU_GENERIC_ERROR;
-    
-  if (interfaceMode == MODE_I2C)
+  // FSS wraps to 0 once all 32 slots are filled
+  if (value & ACC_FIFO_EMPTY)
   {
-    ret = I2C_ByteRead(MAG_I2C_ADDR, reg, data);
+    level = 0;
   }
-  else if (interfaceMode == MODE_SPI)
+  else if ((value & ACC_FIFO_FSS_MASK) == 0)
   {
-    data = SPI_ReadByte(MAG, reg);
-    ret = IMU_SUCCESS;
+    level = ACC_FIFO_DEPTH;
   }
   else
   {
-    ret = IMU_GENERIC_ERROR; // Shouldn't get here
+    level = value & ACC_FIFO_FSS_MASK;
   }
 
-  return ret;
+  return IMU_SUCCESS;
 }
 
-uint8_t  LSM303C::MAG_WriteReg(MAG_REG_t reg, uint8_t data)
+size_t LSM303C::readAccelFifo(AxesRaw_t* out, size_t max)
 {
   debug_print(EMPTY);
-  uint8_t ret;
-    
-  if (interfaceMode == MODE_I2C)
-  {
-    ret = I2C_ByteWrite(MAG_I2C_ADDR, reg, data);
-  }
-  else if (interfaceMode == MODE_SPI)
+  // With the FIFO enabled the output address rolls back from OUT_Z_H to
+  // OUT_X_L, so consecutive samples stream out of a single burst
+  uint8_t raw[(LSM303C_I2C_BUFFER / 6) * 6];
+  uint8_t level;
+  uint8_t src;
+  size_t count = 0;
+
+  driverStatus = ACC_GetFifoSrc(level, src);
+  if (driverStatus != IMU_SUCCESS)
   {
-    ret = SPI_WriteByte(MAG, reg, data);
+    debug_println(AERROR);
+    return 0;
   }
-  else
+  // A full FIFO has been overwriting (stream) or discarding (FIFO mode)
+  if (src & ACC_FIFO_OVR)
   {
-    ret = IMU_GENERIC_ERROR;
+    accelCounters.overruns++;
   }
 
-  return ret;
-}
-
-status_t LSM303C::ACC_ReadReg(ACC_REG_t reg, uint8_t& data)
-{
-  debug_print("Reading address 0x");
-  debug_printlns(reg, HEX);
-  status_t ret;
-    
-  if (interfaceMode == MODE_I2C)
+  if (level < max)
   {
-    ret = I2C_ByteRead(ACC_I2C_ADDR, reg, data);
+    max = level;
   }
-  else if (interfaceMode == MODE_SPI)
-  {
-    data = SPI_ReadByte(ACC, reg);
-    ret = IMU_SUCCESS;
-  }
-  else
+
+  while (count < max)
   {
-    ret = IMU_HW_ERROR;
+    uint8_t chunk = sizeof(raw) / 6;
+    if (max - count < chunk)
+    {
+      chunk = max - count;
+    }
+
+    driverStatus = ACC_ReadRegs(ACC_OUT_X_L, raw, chunk * 6);
+    if (driverStatus != IMU_SUCCESS)
+    {
+      debug_println(AERROR);
+      break;
+    }
+
+    for (uint8_t i = 0; i < chunk * 6; i += 6)
+    {
+      out[count].xAxis = (int16_t)( (raw[i + 1] << 8) | raw[i] );
+      out[count].yAxis = (int16_t)( (raw[i + 3] << 8) | raw[i + 2] );
+      out[count].zAxis = (int16_t)( (raw[i + 5] << 8) | raw[i + 4] );
+      count++;
+    }
   }
 
-  return ret;
+  accelCounters.samples += count;
+  return count;
 }
 
 
 
+// Full scale in mg and output data rate in Hz, indexed by the FS and ODR
+// fields of CTRL4 and CTRL1
+static const uint16_t ACC_FULL_SCALE_MG[4] = {2000, 2000, 4000, 8000};
+static const uint16_t ACC_ODR_HZ[8] = {0, 10, 50, 100, 200, 400, 800, 0};
 
-
-uint8_t  LSM303C::ACC_WriteReg(ACC_REG_t reg, uint8_t data)
+// Thresholds step in a fraction of the full scale (1/256 for the interrupt
+// generators, 1/128 for inactivity), saturating at max
+static uint8_t accelThreshold(uint16_t mg, const uint8_t* ctrl,
+    uint16_t stepsPerFullScale = 256, uint8_t max = 0xFF)
 {
-  debug_print(EMPTY);
-  uint8_t ret;
-    
-  if (interfaceMode == MODE_I2C)
-  {
-    ret = I2C_ByteWrite(ACC_I2C_ADDR, reg, data);
-  }
-  else if (interfaceMode == MODE_SPI)
-  {
-    ret = SPI_WriteByte(ACC, reg, data);
-  }
-  else
-  {
-    ret = IMU_GENERIC_ERROR;
-  }
+  uint16_t fullScale = ACC_FULL_SCALE_MG[(ctrl[ACC_CTRL4 - ACC_CTRL1] >> 4) & 0x03];
+  uint32_t steps = ((uint32_t)mg * stepsPerFullScale + fullScale / 2) / fullScale;
 
-  return ret;
+  return steps > max ? max : steps;
 }
 
-// This function uses bit manibulation for higher speed & smaller code
-uint8_t LSM303C::SPI_ReadByte(CHIP_t chip, uint8_t data)
+// Durations count output samples (1 per step for the interrupt generators,
+// 8 for inactivity), saturating at max
+static uint8_t accelDuration(uint16_t ms, const uint8_t* ctrl,
+    uint8_t samplesPerStep = 1, uint8_t max = 0x7F)
 {
-  debug_print("Reading register 0x");
-  debug_printlns(data, HEX);
-  uint8_t counter;
+  uint16_t odr = ACC_ODR_HZ[(ctrl[ACC_CTRL1 - ACC_CTRL1] & ACC_ODR_MASK) >> 4];
+  uint32_t perStep = 1000UL * samplesPerStep;
+  uint32_t steps = ((uint32_t)ms * odr + perStep / 2) / perStep;
 
-  // Set the read/write bit (bit 7) to do a read
-  data |= _BV(7);
+  return steps > max ? max : steps;
+}
 
-  // Set data pin to output
-  bitSet(DIR_REG, DATABIT);
- 
-  noInterrupts();
+status_t LSM303C::setAccelInterrupt(ACC_IG_t generator, uint8_t config,
+    uint16_t thresholdMg, uint16_t durationMs, uint8_t options)
+{
+  debug_print(EMPTY);
+  bool first = generator == ACC_IG1;
+  uint8_t threshold = accelThreshold(thresholdMg, accCtrl);
+  uint8_t duration = accelDuration(durationMs, accCtrl);
 
-  // Select the chip & deselect the other
-  switch (chip)
+  if (options & ACC_IG_WAIT)
   {
-  case MAG:
-    bitClear(CSPORT_MAG, CSBIT_MAG);
-    bitSet(CSPORT_XL, CSBIT_XL);
-    break;
-  case ACC:
-    bitClear(CSPORT_XL, CSBIT_XL);
-    bitSet(CSPORT_MAG, CSBIT_MAG);
-    break;
+    duration |= 0x80;
   }
 
-  // Shift out 8-bit address
-  for(counter = 8; counter; counter--)
+  // Threshold and duration before the config register arms the generator
+  if (first)
   {
-    bitWrite(DATAPORTO, DATABIT, data & 0x80);
-    // Data is setup, so drop clock edge
-    bitClear(CLKPORT, CLKBIT);
-    bitSet(CLKPORT, CLKBIT);
-    // Shift off sent bit
-    data <<= 1;
+    uint8_t regs[4] = {threshold, threshold, threshold, duration};
+    if ( ACC_WriteRegs(ACC_IG_THS_X1, regs, sizeof(regs)) )
+    {
+      return IMU_HW_ERROR;
+    }
   }
-  
-  // Switch data pin to input (0 = INPUT)
-  bitClear(DIR_REG, DATABIT);
-
-  // Shift in register data from address
-  for(counter = 8; counter; counter--)
+  else
   {
-    // Shift data to the left.  Remains 0 after first shift
-    data <<= 1;
-
-    bitClear(CLKPORT, CLKBIT);
-    // Sample on rising egde
-    bitSet(CLKPORT, CLKBIT);
-    if (bitRead(DATAPORTI, DATABIT))
+    uint8_t regs[2] = {threshold, duration};
+    if ( ACC_WriteRegs(ACC_IG_THS2, regs, sizeof(regs)) )
     {
-      data |= 0x01;
+      return IMU_HW_ERROR;
     }
   }
 
-  // Unselect chip
-  switch (chip)
+  uint8_t fourD = first ? ACC_4D_IG1 : ACC_4D_IG2;
+  uint8_t latch = first ? ACC_LIR1 : ACC_LIR2;
+  uint8_t decrement = first ? ACC_DCRM1 : ACC_DCRM2;
+  uint8_t ctrl7 = ((options & ACC_IG_4D) ? fourD : 0) |
+      ((options & ACC_IG_LATCH) ? latch : 0) |
+      ((options & ACC_IG_DECREMENT) ? decrement : 0);
+  uint8_t highPass = first ? ACC_HPIS1 : ACC_HPIS2;
+  uint8_t pin = first ? ACC_INT_XL_IG1 : ACC_INT_XL_IG2;
+
+  if ( ACC_UpdateReg(ACC_CTRL7, fourD | latch | decrement, ctrl7) ||
+       ACC_UpdateReg(ACC_CTRL2, highPass,
+          (options & ACC_IG_HIGH_PASS) ? highPass : 0) ||
+       ACC_WriteReg(first ? ACC_IG_CFG1 : ACC_IG_CFG2, config) ||
+       ACC_UpdateReg(ACC_CTRL3, pin, (options & ACC_IG_PIN) ? pin : 0) )
   {
-  case MAG:
-    bitSet(CSPORT_MAG, CSBIT_MAG);
-    break;
-  case ACC:
-    bitSet(CSPORT_XL, CSBIT_XL);
-    break;
+    return IMU_HW_ERROR;
   }
 
-  interrupts();
+  // Restart the high-pass filter from the current input so gravity isn't
+  // seen as a step
+  if (options & ACC_IG_HIGH_PASS)
+  {
+    uint8_t ref;
+    return ACC_ReadReg(ACC_XL_REFERENCE, ref);
+  }
 
-  return(data);
+  return IMU_SUCCESS;
 }
 
+status_t LSM303C::setAccelInterruptThresholds(uint16_t xMg, uint16_t yMg,
+    uint16_t zMg)
+{
+  uint8_t regs[3] =
+  {
+    accelThreshold(xMg, accCtrl),
+    accelThreshold(yMg, accCtrl),
+    accelThreshold(zMg, accCtrl)
+  };
+
+  return ACC_WriteRegs(ACC_IG_THS_X1, regs, sizeof(regs));
+}
 
+status_t LSM303C::disableAccelInterrupt(ACC_IG_t generator)
+{
+  bool first = generator == ACC_IG1;
+  uint8_t highPass = first ? ACC_HPIS1 : ACC_HPIS2;
+  uint8_t pin = first ? ACC_INT_XL_IG1 : ACC_INT_XL_IG2;
 
+  if ( ACC_WriteReg(first ? ACC_IG_CFG1 : ACC_IG_CFG2, 0) ||
+       ACC_UpdateReg(ACC_CTRL3, pin, 0) ||
+       ACC_UpdateReg(ACC_CTRL2, highPass, 0) )
+  {
+    return IMU_HW_ERROR;
+  }
 
+  return IMU_SUCCESS;
+}
 
-// This function uses bit manibulation for higher speed & smaller code
-status_t LSM303C::SPI_WriteByte(CHIP_t chip, uint8_t reg, uint8_t data)
+status_t LSM303C::readAccelInterruptSource(ACC_IG_t generator, uint8_t& source)
 {
-  debug_print("Writing 0x");
-  debug_prints(data, HEX);
-  debug_prints(" to register 0x");
-  debug_printlns(reg, HEX);
-
-  uint8_t counter;
-  uint16_t twoBytes;
+  return ACC_ReadReg(generator == ACC_IG1 ? ACC_IG_SRC1 : ACC_IG_SRC2, source);
+}
 
-  // Clear the read/write bit (bit 7) to do a write
-  reg &= ~_BV(7);
-  twoBytes = reg << 8 | data;
+status_t LSM303C::setAccelInterruptPin(bool activeLow, bool openDrain)
+{
+  return ACC_UpdateReg(ACC_CTRL5, ACC_H_LACTIVE | ACC_PP_OD,
+      (activeLow ? ACC_H_LACTIVE : 0) | (openDrain ? ACC_PP_OD : 0));
+}
 
-  // Set data pin to output
-  bitSet(DIR_REG, DATABIT);
- 
-  noInterrupts();
+status_t LSM303C::setAccelInactivity(uint16_t thresholdMg,
+    uint16_t durationMs, bool pin)
+{
+  debug_print(EMPTY);
+  uint8_t threshold = accelThreshold(thresholdMg, accCtrl, 128, 0x7F);
 
-  // Select the chip & deselect the other
-  switch (chip)
+  if (thresholdMg && !threshold)
   {
-  case MAG:
-    bitClear(CSPORT_MAG, CSBIT_MAG);
-    bitSet(CSPORT_XL, CSBIT_XL);
-    break;
-  case ACC:
-    bitClear(CSPORT_XL, CSBIT_XL);
-    bitSet(CSPORT_MAG, CSBIT_MAG);
-    break;
+    threshold = 1; // Zero would turn it off
   }
+  uint8_t regs[2] = {threshold, accelDuration(durationMs, accCtrl, 8, 0xFF)};
 
-  // Shift out 8-bit address & 8-bit data
-  for(counter = 16; counter; counter--)
+  if ( ACC_WriteRegs(ACC_ACT_TSH, regs, sizeof(regs)) ||
+       ACC_UpdateReg(ACC_CTRL3, ACC_INT_XL_INACT,
+          (pin && threshold) ? ACC_INT_XL_INACT : 0) )
   {
-    bitWrite(DATAPORTO, DATABIT, twoBytes & 0x8000);
-    
-    // Data is setup, so drop clock edge
-    bitClear(CLKPORT, CLKBIT);
-    bitSet(CLKPORT, CLKBIT);
-    // Shift off sent bit
-    twoBytes <<= 1;
+    return IMU_HW_ERROR;
   }
-  
-  // Unselect chip
-  switch (chip)
+
+  return IMU_SUCCESS;
+}
+
+status_t LSM303C::setMagInterrupt(uint8_t axes, uint16_t thresholdMilliGauss,
+    uint8_t options)
+{
+  debug_print(EMPTY);
+  // Inverse of the micro-tesla scale, 1 mG = 0.1 uT. 15 bits, unsigned.
+  const FixedScale_t& scale = magScale(magCtrl);
+  uint32_t counts = (((uint32_t)thresholdMilliGauss << scale.shift) +
+      5 * scale.mul) / (10 * scale.mul);
+  if (counts > 0x7FFF)
   {
-  case MAG:
-    bitSet(CSPORT_MAG, CSBIT_MAG);
-    break;
-  case ACC:
-    bitSet(CSPORT_XL, CSBIT_XL);
-    break;
+    counts = 0x7FFF;
   }
- 
-  interrupts();
 
-  // Set data pin to input
-  bitClear(DIR_REG, DATABIT);
+  uint8_t ths[2] = {(uint8_t)counts, (uint8_t)(counts >> 8)};
+  uint8_t config = (axes & MAG_INT_ALL) | MAG_INT_RESERVED | MAG_INT_IEN |
+      ((options & MAG_INT_LATCH) ? 0 : MAG_INT_LIR) |
+      ((options & MAG_INT_ACTIVE_LOW) ? 0 : MAG_INT_IEA);
+
+  // Threshold before the config register arms the interrupt
+  if ( MAG_WriteRegs(MAG_INT_THS_L, ths, sizeof(ths)) ||
+       MAG_WriteReg(MAG_INT_CFG, config) )
+  {
+    return IMU_HW_ERROR;
+  }
 
-  // Is there a way to verify true success?
   return IMU_SUCCESS;
 }
 
+status_t LSM303C::disableMagInterrupt()
+{
+  // Power-on value: axes enabled, not driving the pin
+  if ( MAG_WriteReg(MAG_INT_CFG, MAG_INT_ALL | MAG_INT_RESERVED) )
+  {
+    return IMU_HW_ERROR;
+  }
+
+  return IMU_SUCCESS;
+}
 
+status_t LSM303C::readMagInterruptSource(uint8_t& source)
+{
+  return MAG_ReadReg(MAG_INT_SRC, source);
+}
 
+status_t LSM303C::triggerMag()
+{
+  debug_print(EMPTY);
+  // The chip falls back to power-down after each conversion while the
+  // shadow still says single, so force the write every time
+  bitSet(magDirty, MAG_CTRL_REG3 - MAG_CTRL_REG1);
+  return MAG_UpdateReg(MAG_CTRL_REG3, MAG_MD_POWER_DOWN_2, MAG_MD_SINGLE);
+}
 
-uint8_t  LSM303C::I2C_ByteWrite(I2C_ADDR_t slaveAddress, uint8_t reg,
-    uint8_t data)
+status_t LSM303C::readTriggeredFrame(AxesSample_t& accel, AxesSample_t& mag,
+    uint16_t timeoutMs)
 {
-  uint8_t ret = IMU_GENERIC_ERROR;
-  Wire.beginTransmission(slaveAddress);  // Initialize the Tx buffer
-  // returns num bytes written
-  if (Wire.write(reg))
+  debug_print(EMPTY);
+  // Single status byte polls in between, the data comes in one burst each
+  const uint16_t POLL_US = 500;
+  uint32_t start = millis();
+  MAG_XYZDA_t ready = MAG_XYZDA_NO;
+
+  // Results left over from before the call would otherwise pass for this
+  // frame: drop them, so the accelerometer sample is at most one poll old
+  // when the shot fires and the mag result is the shot's own
+  status_t ret = readAccelSample(accel);
+  if (ret == IMU_SUCCESS)
   {
-    ret = Wire.write(data);
-    if (ret)
-    {
-      debug_print("Wrote: 0x");
-      debug_printlns(data, HEX);
-      switch (Wire.endTransmission())
-      {
-      case 0:
-        ret = IMU_SUCCESS;
-        break;
-      case 1: // Data too long to fit in transmit buffer
-      case 2: // Received NACK on transmit of address
-      case 3: // Received NACK on transmit of data
-      case 4: // Other Error
-      default:
-        ret = IMU_HW_ERROR;
-      }
-    }
-    else
-    {
-      ret = IMU_HW_ERROR;
-    }
+    ret = MAG_XYZ_AxDataAvailable(ready);
   }
-  else
+  if (ret == IMU_SUCCESS && ready)
   {
-    ret = IMU_HW_ERROR;
+    ret = updateMag();
+  }
+  if (ret != IMU_SUCCESS)
+  {
+    return ret;
   }
-  return ret;
-}
 
-status_t LSM303C::I2C_ByteRead(I2C_ADDR_t slaveAddress, uint8_t reg,
-    uint8_t& data)
-{
-  status_t ret = IMU_GENERIC_ERROR;
-  debug_print("Reading from I2C address: 0x");
-  debug_prints(slaveAddress, HEX);
-  debug_prints(", register 0x");
-  debug_printlns(reg, HEX);
-  Wire.beginTransmission(slaveAddress); // Initialize the Tx buffer
-  if (Wire.write(reg))  // Put slave register address in Tx buff
+  for (;;)
   {
-    if (Wire.endTransmission(false))  // Send Tx, send restart to keep alive
+    ret = readAccelSample(accel);
+    if (ret != IMU_SUCCESS)
     {
-      debug_println("Error: I2C buffer didn't get sent!");
-      debug_print("Slave address: 0x");
-      debug_printlns(slaveAddress, HEX);
-      debug_print("Register: 0x");
-      debug_printlns(reg, HEX);
-
-      ret = IMU_HW_ERROR;
+      return ret;
     }
-    else if (Wire.requestFrom(slaveAddress, 1))
+    if (!(accel.flags & SAMPLE_STALE))
     {
-      data = Wire.read();
-      debug_print("Read: 0x");
-      debug_printlns(data, HEX);
-      ret = IMU_SUCCESS;
+      break;
     }
-    else
+    if (millis() - start >= timeoutMs)
     {
-      debug_println("IMU_HW_ERROR");
-      ret = IMU_HW_ERROR;
+      return IMU_TIMEOUT;
     }
+    delayMicroseconds(POLL_US);
   }
-  else
+
+  ret = triggerMag();
+  if (ret != IMU_SUCCESS)
   {
-    debug_println("Error: couldn't send slave register address");
+    return ret;
   }
-  return ret;
+
+  do
+  {
+    delayMicroseconds(POLL_US);
+    ret = MAG_XYZ_AxDataAvailable(ready);
+    if (ret != IMU_SUCCESS)
+    {
+      return ret;
+    }
+    if (!ready && millis() - start >= timeoutMs)
+    {
+      return IMU_TIMEOUT;
+    }
+  } while (!ready);
+
+  return readMagSample(mag);
 }
 
-status_t LSM303C::ACC_Status_Flags(uint8_t& val)
+status_t LSM303C::enableAccelDataReadyInterrupt(LSM303CSampleQueue* queue)
 {
-  debug_println("Getting accel status");
-  if( ACC_ReadReg(ACC_STATUS, val) )
+  debug_print(EMPTY);
+  AxesRaw_t discard;
+
+  // Route (or unroute) data-ready to the INT_XL pin
+  if ( ACC_UpdateReg(ACC_CTRL3, ACC_INT_XL_DRDY, queue ? ACC_INT_XL_DRDY : 0) )
   {
-    debug_println(AERROR);
     return IMU_HW_ERROR;
   }
 
-  return IMU_SUCCESS;
+  noInterrupts();
+  accelQueue = queue;
+  accelIrqPending = 0;
+  interrupts();
+
+  // Clear any sample that is already waiting, otherwise INT_XL stays high and
+  // the first rising edge never arrives
+  return ACC_GetAccRaw(discard);
 }
 
-status_t LSM303C::ACC_GetAccRaw(AxesRaw_t& buff)
+status_t LSM303C::enableMagDataReadyInterrupt(LSM303CSampleQueue* queue)
 {
-  uint8_t valueL;
-  uint8_t valueH;
+  debug_print(EMPTY);
+  AxesRaw_t discard;
 
-  if ( ACC_ReadReg(ACC_OUT_X_H, valueH) )
-  {
-	  return IMU_HW_ERROR;
-  }
-  
-  if ( ACC_ReadReg(ACC_OUT_X_L, valueL) )
+  // DRDY_MAG is always driven, there is nothing to route
+  noInterrupts();
+  magQueue = queue;
+  magIrqPending = 0;
+  interrupts();
+
+  return MAG_GetMagRaw(discard);
+}
+
+// Keep these short: they run in interrupt context and never touch the bus
+void LSM303C::accelDataReadyISR()
+{
+  accelIrqTime = micros();
+  accelIrqPending = 1;
+}
+
+void LSM303C::magDataReadyISR()
+{
+  magIrqTime = micros();
+  magIrqPending = 1;
+}
+
+status_t LSM303C::serviceInterrupts()
+{
+  AxesSample_t sample;
+  uint8_t pending;
+  uint8_t status;
+
+  noInterrupts();
+  pending = accelIrqPending;
+  sample.timestamp = accelIrqTime;
+  accelIrqPending = 0;
+  interrupts();
+
+  // Status comes along in the same burst for the overrun bits
+  if (pending && accelQueue)
   {
-	  return IMU_HW_ERROR;
+    status_t ret = ACC_GetAccRawStatus(sample.axes, status);
+
+    if (ret != IMU_SUCCESS)
+    {
+      debug_println(AERROR);
+      return ret;
+    }
+    stampSample(sample, accelCounters,
+        countSample(accelCounters, status & ACC_ZYX_OVERRUN));
+    if (!accelQueue->push(sample))
+    {
+      accelCounters.dropped++;
+    }
+  }
+
+  noInterrupts();
+  pending = magIrqPending;
+  sample.timestamp = magIrqTime;
+  magIrqPending = 0;
+  interrupts();
+
+  if (pending && magQueue)
+  {
+    status_t ret = MAG_GetMagRawStatus(sample.axes, status);
+
+    if (ret != IMU_SUCCESS)
+    {
+      debug_println(MERROR);
+      return ret;
+    }
+    stampSample(sample, magCounters,
+        countSample(magCounters, status & MAG_ZYXOR_YES));
+    if (!magQueue->push(sample))
+    {
+      magCounters.dropped++;
+    }
+  }
+
+  return IMU_SUCCESS;
+}
+
+// Queues a status + data read of both dies, run by pollSampleRead()
+status_t LSM303C::startSampleRead()
+{
+  if (asyncState != ASYNC_IDLE)
+  {
+    return IMU_GENERIC_ERROR;
+  }
+
+  asyncDone = false;
+  asyncState = ASYNC_ACC_ADDRESS;
+  return IMU_SUCCESS;
+}
+
+// Each call moves the read along by exactly one bus phase. Status and data
+// come back together, only fresh samples replace accelData/magData.
+status_t LSM303C::pollSampleRead()
+{
+  status_t ret = IMU_SUCCESS;
+
+  switch (asyncState)
+  {
+  case ASYNC_IDLE:
+    return IMU_SUCCESS;
+  case ASYNC_ACC_ADDRESS:
+    BUS_PHASE(ret, bus->startRead(ACC, ACC_STATUS, sizeof(asyncRaw)));
+    BUS_PHASE_FAILED(ACC, sizeof(asyncRaw), ret);
+    asyncState = ASYNC_ACC_DATA;
+    break;
+  case ASYNC_ACC_DATA:
+    BUS_PHASE(ret, bus->finishRead(asyncRaw, sizeof(asyncRaw)));
+    BUS_PHASES_DONE(ACC, sizeof(asyncRaw), ret);
+    if (ret == IMU_SUCCESS && (asyncRaw[0] & ACC_ZYX_NEW_DATA_AVAILABLE))
+    {
+      accelTime = micros();
+      accelFlags = countSample(accelCounters, asyncRaw[0] & ACC_ZYX_OVERRUN);
+      accelData.xAxis = (int16_t)( (asyncRaw[2] << 8) | asyncRaw[1] );
+      accelData.yAxis = (int16_t)( (asyncRaw[4] << 8) | asyncRaw[3] );
+      accelData.zAxis = (int16_t)( (asyncRaw[6] << 8) | asyncRaw[5] );
+      correctAccel(accelData, accelCorrected);
+    }
+    asyncState = ASYNC_MAG_ADDRESS;
+    break;
+  case ASYNC_MAG_ADDRESS:
+    BUS_PHASE(ret, bus->startRead(MAG, MAG_STATUS_REG, sizeof(asyncRaw)));
+    BUS_PHASE_FAILED(MAG, sizeof(asyncRaw), ret);
+    asyncState = ASYNC_MAG_DATA;
+    break;
+  case ASYNC_MAG_DATA:
+    BUS_PHASE(ret, bus->finishRead(asyncRaw, sizeof(asyncRaw)));
+    BUS_PHASES_DONE(MAG, sizeof(asyncRaw), ret);
+    if (ret == IMU_SUCCESS && (asyncRaw[0] & MAG_XYZDA_YES))
+    {
+      magTime = micros();
+      magFlags = countSample(magCounters, asyncRaw[0] & MAG_ZYXOR_YES);
+      magData.xAxis = (int16_t)( (asyncRaw[2] << 8) | asyncRaw[1] );
+      magData.yAxis = (int16_t)( (asyncRaw[4] << 8) | asyncRaw[3] );
+      magData.zAxis = (int16_t)( (asyncRaw[6] << 8) | asyncRaw[5] );
+      correctMag(magData, magCorrected);
+    }
+    asyncState = ASYNC_IDLE;
+    if (ret == IMU_SUCCESS)
+    {
+      asyncDone = true;
+      if (sampleCallback)
+      {
+        sampleCallback(accelData, magData);
+      }
+    }
+    break;
+  }
+
+  if (ret != IMU_SUCCESS)
+  {
+    debug_println("Async read failed");
+    asyncState = ASYNC_IDLE;
+  }
+
+  return checkBus(ret);
+}
+
+// True once per completed read
+bool LSM303C::sampleReady(AxesRaw_t& accel, AxesRaw_t& mag)
+{
+  if (!asyncDone)
+  {
+    return false;
   }
+
+  asyncDone = false;
+  accel = accelData;
+  mag = magData;
+  return true;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+////// Protected methods
+
+// Refreshes accelData if a new conversion is waiting
+status_t LSM303C::updateAccel()
+{
+  uint8_t flag_ACC_STATUS_FLAGS;
+  AxesRaw_t sample;
+  uint32_t now = micros();
+  // Status and all three axes come back in a single burst
+  status_t response = ACC_GetAccRawStatus(sample, flag_ACC_STATUS_FLAGS);
   
-  buff.xAxis = (int16_t)( (valueH << 8) | valueL );
+  if (response != IMU_SUCCESS)
+  {
+    debug_println(AERROR);
+    return response;
+  }
   
-  if ( ACC_ReadReg(ACC_OUT_Y_H, valueH) )
+  // Check for new data in the status flags with a mask
+  // If there isn't new data use the last data read.
+  // There are valid cases for this, like reading faster than refresh rate.
+  if (flag_ACC_STATUS_FLAGS & ACC_ZYX_NEW_DATA_AVAILABLE)
   {
-	  return IMU_HW_ERROR;
+    accelData = sample;
+    correctAccel(accelData, accelCorrected);
+    accelTime = now;
+    accelFlags = countSample(accelCounters,
+        flag_ACC_STATUS_FLAGS & ACC_ZYX_OVERRUN);
+    debug_println("Fresh raw data");
   }
+  else
+  {
+    accelFlags |= SAMPLE_STALE;
+  }
+
+  return IMU_SUCCESS;
+}
+
+// Refreshes magData if a new conversion is waiting
+status_t LSM303C::updateMag()
+{
+  uint8_t flag_MAG_STATUS;
+  AxesRaw_t sample;
+  uint32_t now = micros();
+  int16_t temp;
+  // Status and all three axes come back in a single burst, with the
+  // temperature tacked on when the cache is due
+  bool withTemp = tempInterval &&
+    (!tempValid || millis() - tempTime >= tempInterval);
+  status_t response = withTemp ?
+    MAG_GetMagRawStatusTemp(sample, flag_MAG_STATUS, temp) :
+    MAG_GetMagRawStatus(sample, flag_MAG_STATUS);
   
-  if ( ACC_ReadReg(ACC_OUT_Y_L, valueL) )
+  if (response != IMU_SUCCESS)
+  {
+    debug_println(MERROR);
+    return response;
+  }
+
+  if (withTemp)
+  {
+    refreshTemp(temp);
+  }
+  
+  // Check for new data in the status flags with a mask
+  if (flag_MAG_STATUS & MAG_XYZDA_YES)
+  {
+    magData = sample;
+    correctMag(magData, magCorrected);
+    magTime = now;
+    magFlags = countSample(magCounters, flag_MAG_STATUS & MAG_ZYXOR_YES);
+    debug_println("Fresh raw data");
+  }
+  else
+  {
+    magFlags |= SAMPLE_STALE;
+  }
+
+  return IMU_SUCCESS;
+}
+
+float LSM303C::readAccel(AXIS_t dir)
+{
+  // NAN on failure, getStatus() says why (IMU_TIMEOUT, ...)
+  driverStatus = updateAccel();
+  if (driverStatus != IMU_SUCCESS)
+  {
+    return NAN;
+  }
+
+  //convert from LSB to mg
+  switch (dir)
   {
-	  return IMU_HW_ERROR;
+  case xAxis:
+    return accelCorrected.xAxis * accelSensitivity();
+    break;
+  case yAxis:
+    return accelCorrected.yAxis * accelSensitivity();
+    break;
+  case zAxis:
+    return accelCorrected.zAxis * accelSensitivity();
+    break;
+  default:
+    return NAN;
   }
+
+  // Should never get here
+  debug_println("Returning NAN");
+  return NAN;
+}
+
+float LSM303C::readMag(AXIS_t dir)
+{
+  driverStatus = updateMag();
+  if (driverStatus != IMU_SUCCESS)
+  {
+    return NAN;
+  }
+
+  //convert from LSB to Gauss
+  switch (dir)
+  {
+  case xAxis:
+    return magCorrected.xAxis * magSensitivity();
+    break;
+  case yAxis:
+    return magCorrected.yAxis * magSensitivity();
+    break;
+  case zAxis:
+    return magCorrected.zAxis * magSensitivity();
+    break;
+  default:
+    return NAN;
+  }
+
+  // Should never get here
+  debug_println("Returning NAN");
+  return NAN;
+}
+
+status_t LSM303C::MAG_GetMagRaw(AxesRaw_t& buff)
+{
+  debug_print(EMPTY);
+  uint8_t raw[6];
   
-  buff.yAxis = (int16_t)( (valueH << 8) | valueL );
+  // OUTX_L..OUTZ_H in one auto-incremented transfer
+  status_t ret = MAG_ReadRegs(MAG_OUTX_L, raw, sizeof(raw));
+
+  if (ret != IMU_SUCCESS)
+  {
+    return ret;
+  }
+
+  buff.xAxis = (int16_t)( (raw[1] << 8) | raw[0] );
+  buff.yAxis = (int16_t)( (raw[3] << 8) | raw[2] );
+  buff.zAxis = (int16_t)( (raw[5] << 8) | raw[4] );
+
+  return IMU_SUCCESS;
+}
+
+status_t LSM303C::MAG_GetMagRawStatus(AxesRaw_t& buff, uint8_t& status)
+{
+  debug_print(EMPTY);
+  uint8_t raw[7];
   
-  if ( ACC_ReadReg(ACC_OUT_Z_H, valueH) )
+  // STATUS_REG directly precedes OUTX_L, so grab it in the same transfer
+  status_t ret = MAG_ReadRegs(MAG_STATUS_REG, raw, sizeof(raw));
+
+  if (ret != IMU_SUCCESS)
   {
-	  return IMU_HW_ERROR;
+    return ret;
   }
+
+  status = raw[0];
+  buff.xAxis = (int16_t)( (raw[2] << 8) | raw[1] );
+  buff.yAxis = (int16_t)( (raw[4] << 8) | raw[3] );
+  buff.zAxis = (int16_t)( (raw[6] << 8) | raw[5] );
+
+  return IMU_SUCCESS;
+}
+
+status_t LSM303C::MAG_GetMagRawStatusTemp(AxesRaw_t& buff, uint8_t& status,
+    int16_t& temp)
+{
+  debug_print(EMPTY);
+  uint8_t raw[9];
   
-  if ( ACC_ReadReg(ACC_OUT_Z_L, valueL) )
+  // STATUS_REG through TEMP_OUT_H are contiguous
+  status_t ret = MAG_ReadRegs(MAG_STATUS_REG, raw, sizeof(raw));
+
+  if (ret != IMU_SUCCESS)
+  {
+    return ret;
+  }
+
+  status = raw[0];
+  buff.xAxis = (int16_t)( (raw[2] << 8) | raw[1] );
+  buff.yAxis = (int16_t)( (raw[4] << 8) | raw[3] );
+  buff.zAxis = (int16_t)( (raw[6] << 8) | raw[5] );
+  temp = (int16_t)( (raw[8] << 8) | raw[7] );
+
+  return IMU_SUCCESS;
+}
+
+// Methods required to get device up and running
+status_t LSM303C::MAG_SetODR(MAG_DO_t val)
+{
+  debug_print(EMPTY);
+  // Mask and only change DO0 bits (4:2) of MAG_CTRL_REG1
+  return MAG_UpdateReg(MAG_CTRL_REG1, MAG_DO_80_Hz, val);
+}
+
+status_t LSM303C::MAG_SetFullScale(MAG_FS_t val)
+{
+  debug_print(EMPTY);
+  return MAG_UpdateReg(MAG_CTRL_REG2, MAG_FS_16_Ga, val);
+}
+
+status_t LSM303C::MAG_BlockDataUpdate(MAG_BDU_t val)
+{
+  debug_print(EMPTY);
+  return MAG_UpdateReg(MAG_CTRL_REG5, MAG_BDU_ENABLE, val);
+}
+
+status_t LSM303C::MAG_XYZ_AxDataAvailable(MAG_XYZDA_t& value)
+{
+  status_t ret = MAG_ReadReg(MAG_STATUS_REG, (uint8_t&)value);
+
+  if (ret != IMU_SUCCESS)
+  {
+    return ret;
+  }
+
+  value = (MAG_XYZDA_t)((int8_t)value & (int8_t)MAG_XYZDA_YES);
+
+  return IMU_SUCCESS;
+}
+
+status_t LSM303C::MAG_XY_AxOperativeMode(MAG_OMXY_t val)
+{
+  debug_print(EMPTY);
+  return MAG_UpdateReg(MAG_CTRL_REG1, MAG_OMXY_ULTRA_HIGH_PERFORMANCE, val);
+}
+
+status_t LSM303C::MAG_Z_AxOperativeMode(MAG_OMZ_t val)
+{
+  debug_print(EMPTY);
+  return MAG_UpdateReg(MAG_CTRL_REG4, MAG_OMZ_ULTRA_HIGH_PERFORMANCE, val);
+}
+
+status_t LSM303C::MAG_SetMode(MAG_MD_t val)
+{
+  debug_print(EMPTY);
+  return MAG_UpdateReg(MAG_CTRL_REG3, MAG_MD_POWER_DOWN_2, val);
+}
+
+// Calibration offsets are counts at the full scale they were measured at,
+// so a change of full scale drops the calibration rather than keep
+// subtracting the wrong amount
+status_t LSM303C::ACC_SetFullScale(ACC_FS_t val)
+{
+  debug_print(EMPTY);
+  if ((accCtrl[ACC_CTRL4 - ACC_CTRL1] & ACC_FS_8g) != val &&
+      clearAccelCalibration())
+  {
+    return IMU_HW_ERROR;
+  }
+  return ACC_UpdateReg(ACC_CTRL4, ACC_FS_8g, val);
+}
+
+status_t LSM303C::ACC_BlockDataUpdate(ACC_BDU_t val)
+{
+  debug_print(EMPTY);
+  return ACC_UpdateReg(ACC_CTRL1, ACC_BDU_ENABLE, val);
+}
+
+status_t LSM303C::ACC_EnableAxis(uint8_t val)
+{
+  debug_print(EMPTY);
+  return ACC_UpdateReg(ACC_CTRL1, ACC_X_ENABLE|ACC_Y_ENABLE|ACC_Z_ENABLE, val);
+}
+
+status_t LSM303C::ACC_SetODR(ACC_ODR_t val)
+{
+  debug_print(EMPTY);
+  return ACC_UpdateReg(ACC_CTRL1, ACC_ODR_MASK, val);
+}
+
+status_t LSM303C::MAG_GetTempRaw(int16_t& raw)
+{
+  uint8_t data[2];
+
+  // Make sure temperature sensor is enabled
+  status_t ret = MAG_TemperatureEN(MAG_TEMP_EN_ENABLE);
+
+  if (ret != IMU_SUCCESS)
+  {
+    return ret;
+  }
+
+  // TEMP_OUT_L and TEMP_OUT_H in one auto-incremented transfer
+  ret = MAG_ReadRegs(MAG_TEMP_OUT_L, data, sizeof(data));
+  if (ret != IMU_SUCCESS)
+  {
+    return ret;
+  }
+
+  raw = (int16_t)((data[1] << 8) | data[0]);
+  return IMU_SUCCESS;
+}
+
+status_t LSM303C::MAG_TemperatureEN(MAG_TEMP_EN_t val)
+{
+  return MAG_UpdateReg(MAG_CTRL_REG1, MAG_TEMP_EN_ENABLE, val);
+}
+
+status_t LSM303C::ACC_UpdateReg(ACC_REG_t reg, uint8_t mask, uint8_t bits)
+{
+  uint8_t index = reg - ACC_CTRL1;
+
+  if (index >= ACC_CTRL_COUNT)
+  {
+    return IMU_OUT_OF_BOUNDS;
+  }
+
+  uint8_t value = (accCtrl[index] & ~mask) | (bits & mask);
+
+  if (value == accCtrl[index] && !bitRead(accDirty, index))
+  {
+    return IMU_SUCCESS; // Chip already holds this value
+  }
+
+  accCtrl[index] = value;
+  bitSet(accDirty, index);
+
+  return deferWrites ? IMU_SUCCESS : flushRegisters();
+}
+
+status_t LSM303C::MAG_UpdateReg(MAG_REG_t reg, uint8_t mask, uint8_t bits)
+{
+  uint8_t index = reg - MAG_CTRL_REG1;
+
+  if (index >= MAG_CTRL_COUNT)
+  {
+    return IMU_OUT_OF_BOUNDS;
+  }
+
+  uint8_t value = (magCtrl[index] & ~mask) | (bits & mask);
+
+  if (value == magCtrl[index] && !bitRead(magDirty, index))
+  {
+    return IMU_SUCCESS; // Chip already holds this value
+  }
+
+  magCtrl[index] = value;
+  bitSet(magDirty, index);
+
+  return deferWrites ? IMU_SUCCESS : flushRegisters();
+}
+
+// Finds the contiguous span of registers covering every dirty bit
+static void dirtySpan(uint8_t dirty, uint8_t& first, uint8_t& count)
+{
+  uint8_t last = 0;
+
+  first = 0xFF;
+  for (uint8_t i = 0; dirty >> i; i++)
+  {
+    if (bitRead(dirty, i))
+    {
+      if (first == 0xFF)
+      {
+        first = i;
+      }
+      last = i;
+    }
+  }
+  count = last - first + 1;
+}
+
+// Writes every dirty register of a die in one burst. Clean registers between
+// dirty ones are rewritten with their (identical) shadow values.
+status_t LSM303C::flushRegisters()
+{
+  uint8_t first;
+  uint8_t count;
+  status_t ret;
+
+  if (magDirty)
+  {
+    dirtySpan(magDirty, first, count);
+    ret = MAG_WriteRegs((MAG_REG_t)(MAG_CTRL_REG1 + first), &magCtrl[first],
+        count);
+    if (ret != IMU_SUCCESS)
+    {
+      debug_println(MERROR);
+      return ret;
+    }
+    magDirty = 0;
+  }
+
+  if (accDirty)
+  {
+    dirtySpan(accDirty, first, count);
+    ret = ACC_WriteRegs((ACC_REG_t)(ACC_CTRL1 + first), &accCtrl[first],
+        count);
+    if (ret != IMU_SUCCESS)
+    {
+      debug_println(AERROR);
+      return ret;
+    }
+    accDirty = 0;
+  }
+
+  return IMU_SUCCESS;
+}
+
+status_t LSM303C::MAG_ReadReg(MAG_REG_t reg, uint8_t& data)
+{
+  debug_print("Reading register 0x");
+  debug_printlns(reg, HEX);
+  status_t ret;
+  BUS_TIMED(MAG, BUS_OP_READ, 1, ret, bus->readReg(MAG, reg, data));
+  return checkBus(ret);
+}
+
+status_t LSM303C::MAG_ReadRegs(MAG_REG_t reg, uint8_t* data, uint8_t len)
+{
+  debug_print("Burst reading from register 0x");
+  debug_printlns(reg, HEX);
+  status_t ret;
+  BUS_TIMED(MAG, BUS_OP_READ, len, ret, bus->readRegs(MAG, reg, data, len));
+  return checkBus(ret);
+}
+
+uint8_t  LSM303C::MAG_WriteReg(MAG_REG_t reg, uint8_t data)
+{
+  debug_print(EMPTY);
+  status_t ret;
+  BUS_TIMED(MAG, BUS_OP_WRITE, 1, ret, bus->writeReg(MAG, reg, data));
+  return checkBus(ret);
+}
+
+status_t LSM303C::MAG_WriteRegs(MAG_REG_t reg, const uint8_t* data,
+    uint8_t len)
+{
+  debug_print(EMPTY);
+  status_t ret;
+  BUS_TIMED(MAG, BUS_OP_WRITE, len, ret, bus->writeRegs(MAG, reg, data, len));
+  return checkBus(ret);
+}
+
+status_t LSM303C::ACC_ReadReg(ACC_REG_t reg, uint8_t& data)
+{
+  debug_print("Reading address 0x");
+  debug_printlns(reg, HEX);
+  status_t ret;
+  BUS_TIMED(ACC, BUS_OP_READ, 1, ret, bus->readReg(ACC, reg, data));
+  return checkBus(ret);
+}
+
+status_t LSM303C::ACC_ReadRegs(ACC_REG_t reg, uint8_t* data, uint8_t len)
+{
+  debug_print("Burst reading from address 0x");
+  debug_printlns(reg, HEX);
+  status_t ret;
+  BUS_TIMED(ACC, BUS_OP_READ, len, ret, bus->readRegs(ACC, reg, data, len));
+  return checkBus(ret);
+}
+
+uint8_t  LSM303C::ACC_WriteReg(ACC_REG_t reg, uint8_t data)
+{
+  debug_print(EMPTY);
+  status_t ret;
+  BUS_TIMED(ACC, BUS_OP_WRITE, 1, ret, bus->writeReg(ACC, reg, data));
+  return checkBus(ret);
+}
+
+status_t LSM303C::ACC_WriteRegs(ACC_REG_t reg, const uint8_t* data,
+    uint8_t len)
+{
+  debug_print(EMPTY);
+  status_t ret;
+  BUS_TIMED(ACC, BUS_OP_WRITE, len, ret, bus->writeRegs(ACC, reg, data, len));
+  return checkBus(ret);
+}
+
+status_t LSM303C::ACC_Status_Flags(uint8_t& val)
+{
+  debug_println("Getting accel status");
+  status_t ret = ACC_ReadReg(ACC_STATUS, val);
+
+  if (ret != IMU_SUCCESS)
   {
-	  return IMU_HW_ERROR;
+    debug_println(AERROR);
+    return ret;
   }
 
-  buff.zAxis = (int16_t)( (valueH << 8) | valueL ); 
+  return IMU_SUCCESS;
+}
+
+status_t LSM303C::ACC_GetAccRaw(AxesRaw_t& buff)
+{
+  uint8_t raw[6];
+
+  // OUT_X_L..OUT_Z_H in one transfer (relies on IF_ADD_INC in ACC_CTRL4)
+  status_t ret = ACC_ReadRegs(ACC_OUT_X_L, raw, sizeof(raw));
+
+  if (ret != IMU_SUCCESS)
+  {
+    return ret;
+  }
+  
+  buff.xAxis = (int16_t)( (raw[1] << 8) | raw[0] );
+  buff.yAxis = (int16_t)( (raw[3] << 8) | raw[2] );
+  buff.zAxis = (int16_t)( (raw[5] << 8) | raw[4] ); 
+
+  return IMU_SUCCESS;
+}
+
+status_t LSM303C::ACC_GetAccRawStatus(AxesRaw_t& buff, uint8_t& status)
+{
+  uint8_t raw[7];
+
+  // ACC_STATUS directly precedes OUT_X_L, so grab it in the same transfer
+  status_t ret = ACC_ReadRegs(ACC_STATUS, raw, sizeof(raw));
+
+  if (ret != IMU_SUCCESS)
+  {
+    return ret;
+  }
+  
+  status = raw[0];
+  buff.xAxis = (int16_t)( (raw[2] << 8) | raw[1] );
+  buff.yAxis = (int16_t)( (raw[4] << 8) | raw[3] );
+  buff.zAxis = (int16_t)( (raw[6] << 8) | raw[5] ); 
 
   return IMU_SUCCESS;
 }
@@ -5,39 +5,49 @@
 #include "Wire.h"
 #include "SparkFunIMU.h"
 #include "LSM303CTypes.h"
+#include "LSM303CBus.h"
+#include "LSM303CBitBangSPIBus.h"
+#include "LSM303CSampleQueue.h"
 #include "DebugMacros.h"
 
+// Power-on full scale (2 g, 16 gauss). Conversions follow the configured
+// full scale through accelSensitivity()/magSensitivity().
 #define SENSITIVITY_ACC   0.06103515625   // LSB/mg
 #define SENSITIVITY_MAG   0.00048828125   // LSB/Ga
 
+// Number of contiguous control registers mirrored in the shadow copies
+#define ACC_CTRL_COUNT 7 // ACC_CTRL1..ACC_CTRL7
+#define MAG_CTRL_COUNT 5 // MAG_CTRL_REG1..MAG_CTRL_REG5
+
+// Depth of the accelerometer FIFO in samples
+#define ACC_FIFO_DEPTH 32
+
+// Largest single read the Wire library can buffer
+#if defined(BUFFER_LENGTH)
+#define LSM303C_I2C_BUFFER BUFFER_LENGTH
+#elif defined(I2C_BUFFER_LENGTH)
+#define LSM303C_I2C_BUFFER I2C_BUFFER_LENGTH
+#else
+#define LSM303C_I2C_BUFFER 32
+#endif
+
 #define DEBUG 0 // Change to 1 (nonzero) to enable debug messages
 
 // Define a few error messages to save on space
 static const char AERROR[] = "\nAccel Error";
 static const char MERROR[] = "\nMag Error";
 
-// Define SPI pins (Pro Mini)
-//  D10 -> SDI/SDO
-//  D11 -> SCLK
-//  D12 -> CS_XL
-//  D13 -> CS_MAG
-#define CSPORT_MAG PORTB
-#define CSBIT_MAG  5
-#define CSPORT_XL  PORTB
-#define CSBIT_XL   4
-#define CLKPORT    PORTB
-#define CLKBIT     3
-#define DATAPORTI  PINB
-#define DATAPORTO  PORTB
-#define DATABIT    2
-#define DIR_REG    DDRB
-// End SPI pin definitions
-
+// Called by pollSampleRead() when an asynchronous sample read completes
+typedef void (*SampleCallback_t)(const AxesRaw_t& accel, const AxesRaw_t& mag);
 
 class LSM303C : public SparkFunIMU
 {
   public:
     // These are the only methods are the only methods the user can use w/o mods
+    LSM303C() : bus(&i2cBus) { }
+    // Talk to the chip through any transport. The interface mode passed to
+    // begin() is then ignored in favor of the bus' own.
+    explicit LSM303C(LSM303CBus& customBus) : bus(&customBus), busFixed(true) { }
     ~LSM303C()  =  default;
     status_t begin(void);
     // Begin contains hardware specific code (Pro Mini)
@@ -49,49 +59,297 @@ class LSM303C : public SparkFunIMU
     float   readMagX(void);
     float   readMagY(void);
     float   readMagZ(void);
+    // One coherent sample per call (single bus transaction)
+    status_t readAccelXYZ(float&, float&, float&);
+    status_t   readMagXYZ(float&, float&, float&);
+    status_t readAccelRaw(AxesRaw_t&);
+    status_t   readMagRaw(AxesRaw_t&);
+    // Raw sample with its micros() timestamp, sequence number and overrun
+    // flags. Flagged SAMPLE_STALE (same sequence) if nothing new was ready.
+    status_t readAccelSample(AxesSample_t&);
+    status_t   readMagSample(AxesSample_t&);
+    // Totals since begin() across every read path, to spot polling that
+    // falls behind the output data rate
+    const SampleStats_t& accelStats(void) const { return accelCounters; }
+    const SampleStats_t&   magStats(void) const { return magCounters; }
+    void resetStats(void);
     float  readTempC(void);
     float  readTempF(void);
+    // Temperature as a cached low-rate channel. With an interval set, a mag
+    // read that finds the cache due picks TEMP_OUT up in the same burst
+    // (two more bytes) and the readTemp*() calls answer from the cache
+    // while it's younger than the interval, going to the chip only when no
+    // mag read refreshed it. 0, the default, reads the chip every call.
+    status_t setTempInterval(uint16_t ms);
+    // Offset drift removal for the unit-converting reads and correctAccel()/
+    // correctMag(), on top of any calibration. The drift is worked out
+    // again whenever the temperature is refreshed, so keep reading it (or
+    // set an interval).
+    void setTempCompensation(const TempCompensation_t&);
+    void clearTempCompensation(void);
+
+    // Integer outputs for FPU-less boards: shifts and integer multiplies
+    // only, scaled for the configured full scale
+    status_t   readAccelMilliG(AxesRaw_t&);
+    status_t readMagMicroTesla(AxesRaw_t&);
+    status_t     readTempCentiC(int16_t&);
+    // Accelerometer offset/gain correction for the unit-converting reads.
+    // With useReference the offsets go into the chip's reference registers
+    // (high-pass filter in reference mode), so every accelerometer output,
+    // raw ones included, comes out offset-free at no CPU cost; only gains
+    // that aren't 1.0 are still applied in software. The blob must be
+    // valid and recorded at the current full scale; changing the full scale
+    // afterwards clears it.
+    status_t setAccelCalibration(const AccelCalibration_t&, bool useReference = false);
+    status_t clearAccelCalibration(void);
+    void correctAccel(const AxesRaw_t&, AxesRaw_t&) const;
+    // On-chip accelerometer high-pass filter on the output registers and
+    // FIFO, e.g. to strip gravity before an LSM303CFilterChain. Shares the
+    // filter with the reference-register calibration above, so it fails
+    // while that is in use.
+    status_t setAccelHighPass(ACC_DFC_t);
+    status_t clearAccelHighPass(void);
+
+    // Hard/soft-iron correction for the unit-converting magnetometer reads.
+    // Raw samples (readMagRaw(), queues, async) stay raw to feed
+    // LSM303CMagCalibrator, correctMag() applies it to them.
+    void setMagCalibration(const MagCalibration_t&);
+    void clearMagCalibration(void) { magCalEnabled = false; correctMag(magData, magCorrected); }
+    void correctMag(const AxesRaw_t&, AxesRaw_t&) const;
+    // Same conversions for raw samples from the FIFO, queues or async reads
+    void     accelMilliG(const AxesRaw_t&, AxesRaw_t&) const;
+    void   magMicroTesla(const AxesRaw_t&, AxesRaw_t&) const;
+    float accelSensitivity(void) const; // mg/LSB
+    float   magSensitivity(void) const; // Ga/LSB
+
+    // Runtime reconfiguration. Once begin() has synced the shadow copies of
+    // the control registers each of these is a single register write.
+    status_t MAG_SetODR(MAG_DO_t);
+    status_t MAG_SetFullScale(MAG_FS_t);
+    status_t MAG_XY_AxOperativeMode(MAG_OMXY_t);
+    status_t MAG_Z_AxOperativeMode(MAG_OMZ_t);
+    status_t MAG_SetMode(MAG_MD_t);
+    status_t ACC_SetFullScale(ACC_FS_t);
+    status_t ACC_SetODR(ACC_ODR_t);
+    // Reload the shadow copies from the chip, or check the chip still matches
+    status_t syncRegisters(void);
+    status_t verifyRegisters(void);
+
+    // Bus-hang recovery. A transfer past the bus deadline (see
+    // LSM303CI2CBus::setTimeout()) returns IMU_TIMEOUT and, unless turned
+    // off, recoverBus() runs right away: the transport frees the bus and
+    // the control registers are rewritten from the shadow copies, in case
+    // the chip lost them. Interrupt, FIFO and inactivity settings aren't
+    // shadowed, set those again if recoveries show up.
+    status_t recoverBus(void);
+    void setAutoRecover(bool on) { autoRecover = on; }
+    uint16_t busRecoveries(void) const { return recoveryCount; }
+
+    // Accelerometer FIFO. The watermark (0-31) sets the FTH flag/interrupt.
+    status_t enableAccelFifo(ACC_FIFO_MODE_t, uint8_t);
+    status_t accelFifoLevel(uint8_t&);
+    // Drains up to max queued samples, returns how many were stored in out
+    size_t   readAccelFifo(AxesRaw_t*, size_t);
+
+    // Accelerometer interrupt generators for motion, free-fall and
+    // orientation, so the host can sleep until something happens. config is
+    // ACC_IG_CFG_t events plus a combination, options ACC_IG_OPTION_t.
+    // Thresholds in mg (full scale/256 steps, at most 255 of them) and
+    // durations in ms are converted for the current full scale and ODR, so
+    // set them again after changing either. Generator 1 can also take a
+    // separate threshold per axis.
+    status_t setAccelInterrupt(ACC_IG_t, uint8_t config, uint16_t thresholdMg,
+        uint16_t durationMs, uint8_t options = ACC_IG_PIN);
+    status_t setAccelInterruptThresholds(uint16_t xMg, uint16_t yMg, uint16_t zMg);
+    status_t disableAccelInterrupt(ACC_IG_t);
+    // ACC_IG_SRC_t bits. Reading clears a latched interrupt.
+    status_t readAccelInterruptSource(ACC_IG_t, uint8_t&);
+    // INT_XL polarity and drive, shared with data-ready. Active low lets a
+    // level interrupt wake an AVR from power-down.
+    status_t setAccelInterruptPin(bool activeLow, bool openDrain = false);
+
+    // Chip-level inactivity: once every axis stays within thresholdMg
+    // (full scale/128 steps) for durationMs (8/ODR steps) the accelerometer
+    // drops to 10 Hz by itself and goes back to the set ODR on the first
+    // sample past the threshold. With pin set INT_XL shows the inactive
+    // state. A zero threshold turns it off.
+    status_t setAccelInactivity(uint16_t thresholdMg, uint16_t durationMs,
+        bool pin = false);
+
+    // Magnetometer threshold interrupt on INT_MAG: fires when an enabled
+    // axis (MAG_INT_X/Y/Z) reads beyond +-threshold. The threshold is in
+    // milligauss at the current full scale and is compared against raw
+    // readings, so it has to clear the earth's field plus any hard-iron
+    // offset. options is MAG_INT_OPTION_t.
+    status_t setMagInterrupt(uint8_t axes, uint16_t thresholdMilliGauss,
+        uint8_t options = MAG_INT_LATCH);
+    status_t disableMagInterrupt(void);
+    // MAG_INT_SRC_t bits. Reading clears a latched interrupt.
+    status_t readMagInterruptSource(uint8_t&);
+
+    // Triggered magnetometer. triggerMag() starts one conversion, after
+    // which the die powers itself down again, so it only draws current
+    // while a shot is in progress. Poll readMagSample() (SAMPLE_STALE until
+    // the result is in) or let readTriggeredFrame() do the waiting: it
+    // waits for the next fresh accelerometer sample, fires the conversion
+    // right behind it and returns the pair. timeoutMs bounds the whole
+    // exchange, a miss returns IMU_TIMEOUT.
+    status_t triggerMag(void);
+    status_t readTriggeredFrame(AxesSample_t& accel, AxesSample_t& mag,
+        uint16_t timeoutMs = 100);
+
+    // Interrupt driven acquisition. Wire INT_XL/DRDY_MAG to interrupt pins,
+    // call the *DataReadyISR() methods from the sketch's handlers and
+    // serviceInterrupts() from loop(). Samples land in the given queue.
+    // Passing NULL turns the pipeline off again.
+    status_t enableAccelDataReadyInterrupt(LSM303CSampleQueue*);
+    status_t enableMagDataReadyInterrupt(LSM303CSampleQueue*);
+    void     accelDataReadyISR(void);
+    void     magDataReadyISR(void);
+    status_t serviceInterrupts(void);
+
+    // Asynchronous sample read. startSampleRead() queues a status + data read
+    // of both dies and each pollSampleRead() call runs one bus phase of it,
+    // so the loop never blocks for a whole sample. Collect the result with
+    // sampleReady() or the callback. On I2C nothing else may use the Wire
+    // port while a read is in flight.
+    status_t startSampleRead(void);
+    status_t pollSampleRead(void);
+    bool     sampleBusy(void) const { return asyncState != ASYNC_IDLE; }
+    bool     sampleReady(AxesRaw_t&, AxesRaw_t&);
+    void     onSampleReady(SampleCallback_t cb) { sampleCallback = cb; }
+
+    // Files every register access with stats (see LSM303CBusStats.h) until
+    // called with NULL. IMU_NOT_SUPPORTED unless the library was built with
+    // LSM303C_INSTRUMENTATION=1.
+    status_t setBusStats(LSM303CBusStats*);
 
   protected:
+    // Schedules reads across several devices through the raw accessors
+    friend class LSM303CArray;
+
     // Variables to store the most recently read raw data from sensor
-    AxesRaw_t accelData = {NAN, NAN, NAN};
-    AxesRaw_t   magData = {NAN, NAN, NAN};
+    AxesRaw_t accelData = {0, 0, 0};
+    AxesRaw_t   magData = {0, 0, 0};
+    // When accelData/magData were read and how
+    uint32_t accelTime = 0;
+    uint32_t   magTime = 0;
+    uint8_t accelFlags = SAMPLE_STALE;
+    uint8_t   magFlags = SAMPLE_STALE;
+    SampleStats_t accelCounters = {0, 0, 0};
+    SampleStats_t   magCounters = {0, 0, 0};
+
+    // accelData after calibration, refreshed with every fresh sample
+    AxesRaw_t accelCorrected = {0, 0, 0};
+    AccelCalibration_t accelCal;
+    bool accelCalEnabled = false;
+    // magData after calibration, refreshed with every fresh sample
+    AxesRaw_t magCorrected = {0, 0, 0};
+    MagCalibration_t magCal;
+    bool magCalEnabled = false;
+
+    // Last temperature read and when (millis()), see setTempInterval()
+    int16_t  tempRaw = 0;
+    uint32_t tempTime = 0;
+    uint16_t tempInterval = 0;
+    bool     tempValid = false;
+    // Offsets due to temperature, subtracted by correctAccel()/correctMag()
+    TempCompensation_t tempComp;
+    bool tempCompEnabled = false;
+    AxesRaw_t accelDrift = {0, 0, 0};
+    AxesRaw_t   magDrift = {0, 0, 0};
 
     // The LSM303C functions over both I2C or SPI. This library supports both.
     // Interface mode used must be set!
     InterfaceMode_t interfaceMode = MODE_I2C;  // Set a default...
 
-    // Hardware abstraction functions (Pro Mini)
-    uint8_t  SPI_ReadByte(CHIP_t, uint8_t);
-    status_t SPI_WriteByte(CHIP_t, uint8_t, uint8_t);
-    uint8_t  I2C_ByteWrite(I2C_ADDR_t, uint8_t, uint8_t);  
-    status_t I2C_ByteRead(I2C_ADDR_t, uint8_t, uint8_t&);
+    // Built-in transports, unless a custom bus was handed to the constructor
+    LSM303CI2CBus        i2cBus;
+#if LSM303C_HAS_BITBANG_SPI
+    LSM303CBitBangSPIBus spiBus;
+#endif
+    LSM303CBus* bus;
+    bool busFixed = false;
+
+    // Interrupt pipeline state, written by the *DataReadyISR() methods
+    LSM303CSampleQueue* accelQueue = NULL;
+    LSM303CSampleQueue*   magQueue = NULL;
+    volatile uint8_t  accelIrqPending = 0;
+    volatile uint8_t    magIrqPending = 0;
+    volatile uint32_t accelIrqTime = 0;
+    volatile uint32_t   magIrqTime = 0;
+
+    // Bus recovery state, see recoverBus()
+    bool autoRecover = true;
+    bool recovering = false;
+    uint16_t recoveryCount = 0;
+
+    // Asynchronous read state, see pollSampleRead()
+    ASYNC_STATE_t asyncState = ASYNC_IDLE;
+    bool asyncDone = false;
+    uint8_t asyncRaw[7];
+    SampleCallback_t sampleCallback = NULL;
+
+    LSM303CBusStats* busCounters = NULL;
+    uint32_t asyncBusMicros = 0; // Split read phases so far
+
+    // Shadow copies of the control registers (power-on defaults until
+    // begin() syncs them), so setters never read the chip before writing.
+    uint8_t accCtrl[ACC_CTRL_COUNT] = {0x07, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00};
+    uint8_t magCtrl[MAG_CTRL_COUNT] = {0x10, 0x60, 0x03, 0x00, 0x00};
+    // Bit n set: register CTRL1 + n changed but hasn't been written yet
+    uint8_t accDirty = 0;
+    uint8_t magDirty = 0;
+    // Stage changes in the shadows only, flushRegisters() writes them out
+    bool deferWrites = false;
 
     // Methods required to get device up and running
-    status_t MAG_SetODR(MAG_DO_t);
-    status_t MAG_SetFullScale(MAG_FS_t);
     status_t MAG_BlockDataUpdate(MAG_BDU_t);
-    status_t MAG_XY_AxOperativeMode(MAG_OMXY_t);
-    status_t MAG_Z_AxOperativeMode(MAG_OMZ_t);
-    status_t MAG_SetMode(MAG_MD_t);
-    status_t ACC_SetFullScale(ACC_FS_t);
     status_t ACC_BlockDataUpdate(ACC_BDU_t);
     status_t ACC_EnableAxis(uint8_t);
-    status_t ACC_SetODR(ACC_ODR_t);
 
+    // Change the masked bits of a control register through its shadow copy.
+    // Nothing goes on the bus if the value is unchanged.
+    status_t ACC_UpdateReg(ACC_REG_t, uint8_t, uint8_t);
+    status_t MAG_UpdateReg(MAG_REG_t, uint8_t, uint8_t);
+    status_t flushRegisters(void); // Writes dirty shadow registers
+    status_t checkBus(status_t);   // Recovers after a timeout
+    // The high-pass filter is holding calibration offsets
+    bool accelReferenceActive(void) const
+    {
+      return (accCtrl[ACC_CTRL2 - ACC_CTRL1] & ACC_HPM_MASK) == ACC_HPM_REFERENCE;
+    }
+    status_t releaseAccelReference(void);
+
+    // Counts a fresh sample and returns its SAMPLE_* flags
+    static uint8_t countSample(SampleStats_t&, bool overrun);
+    static void stampSample(AxesSample_t&, const SampleStats_t&, uint8_t);
+    status_t ACC_GetFifoSrc(uint8_t&, uint8_t&);
     status_t ACC_Status_Flags(uint8_t&);
     status_t ACC_GetAccRaw(AxesRaw_t&);
+    status_t ACC_GetAccRawStatus(AxesRaw_t&, uint8_t&);
+    status_t updateAccel(void); // Refreshes accelData from IC
     float    readAccel(AXIS_t); // Reads the accelerometer data from IC
 
     status_t MAG_GetMagRaw(AxesRaw_t&);
+    status_t MAG_GetMagRawStatus(AxesRaw_t&, uint8_t&);
+    status_t MAG_GetMagRawStatusTemp(AxesRaw_t&, uint8_t&, int16_t&);
+    status_t MAG_GetTempRaw(int16_t&);
+    status_t readTempRaw(int16_t&); // Through the cache
+    void     refreshTemp(int16_t);  // New reading into cache and drift
     status_t MAG_TemperatureEN(MAG_TEMP_EN_t);    
     status_t MAG_XYZ_AxDataAvailable(MAG_XYZDA_t&);
+    status_t updateMag(void);   // Refreshes magData from IC
     float    readMag(AXIS_t);   // Reads the magnetometer data from IC
 
     status_t MAG_ReadReg(MAG_REG_t, uint8_t&);
+    status_t MAG_ReadRegs(MAG_REG_t, uint8_t*, uint8_t);
     uint8_t  MAG_WriteReg(MAG_REG_t, uint8_t);
+    status_t MAG_WriteRegs(MAG_REG_t, const uint8_t*, uint8_t);
     status_t ACC_ReadReg(ACC_REG_t, uint8_t&);
+    status_t ACC_ReadRegs(ACC_REG_t, uint8_t*, uint8_t);
     uint8_t  ACC_WriteReg(ACC_REG_t, uint8_t);
+    status_t ACC_WriteRegs(ACC_REG_t, const uint8_t*, uint8_t);
 };
 
 #endif